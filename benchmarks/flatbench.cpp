@@ -0,0 +1,531 @@
+/*
+ * Copyright 2015 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks for building, accessing, verifying, parsing and reflecting on
+// FlatBuffers. Run from the source or build directory, as it loads
+// tests/monster_test.fbs and tests/monster_test.bfbs.
+//
+// Results are written to stdout as CSV, one line per benchmark:
+// name,iterations,ns_per_op,mb_per_s,allocs_per_op,alloc_bytes_per_op
+// where mb_per_s is the bytes of buffer (or JSON) processed per second, and
+// the allocations are all heap allocations made through operator new.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+
+#ifdef _WIN32
+  #include <windows.h>
+#else
+  #include <time.h>
+#endif
+
+#include "flatbuffers/flatbuffers.h"
+#include "flatbuffers/idl.h"
+#include "flatbuffers/reflection.h"
+#include "flatbuffers/util.h"
+
+#include "monster_test_generated.h"
+#include "wide_generated.h"
+#include "deep_generated.h"
+
+using namespace flatbuffers;
+using namespace MyGame::Example;
+
+// ------------------------- ALLOCATION COUNTING -------------------------
+
+static size_t num_allocations = 0;
+static size_t num_allocated_bytes = 0;
+
+#if __cplusplus >= 201103L
+  #define FLATBENCH_NEW_THROWS
+  #define FLATBENCH_NEVER_THROWS noexcept
+#else
+  #define FLATBENCH_NEW_THROWS throw(std::bad_alloc)
+  #define FLATBENCH_NEVER_THROWS throw()
+#endif
+
+// operator new[] and delete[] forward to these by default.
+void *operator new(size_t size) FLATBENCH_NEW_THROWS {
+  num_allocations++;
+  num_allocated_bytes += size;
+  void *p = malloc(size ? size : 1);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void *p) FLATBENCH_NEVER_THROWS { free(p); }
+
+// ------------------------- TEST DATA -------------------------
+
+static const int kNumMonsters = 100;
+static const int kTreeDepth = 12;  // Levels of Node below the root.
+
+// Everything the benchmarks work on, set up once.
+struct Data {
+  std::vector<std::string> names;  // One per monster, unique.
+  std::vector<uint8_t> inventory;
+  std::vector<int> order;  // A random permutation of the monsters.
+  size_t next;  // Into order, for lookups.
+
+  FlatBufferBuilder builder;       // Reused between iterations.
+  std::string monster;             // Built by BuildMonsters().
+  std::string wide;
+  std::string deep;
+
+  Parser parser;                   // Parsed tests/monster_test.fbs.
+  std::string json;                // Generated from monster.
+  std::string text;                // Reused by GenerateText.
+  std::string bfbs;                // tests/monster_test.bfbs.
+  std::vector<uint8_t> resizable;  // A copy of monster, for SetString().
+};
+
+static void BuildMonsters(Data &data, FlatBufferBuilder &builder) {
+  std::vector<Offset<Monster> > monsters;
+  for (int i = 0; i < kNumMonsters; i++) {
+    Offset<String> name = builder.CreateString(data.names[i]);
+    Offset<Vector<uint8_t> > inventory = builder.CreateVector(
+      &data.inventory[0], static_cast<size_t>(i % 16 + 1));
+    Vec3 pos(1, 2, 3, i, Color_Green, Test(5, 6));
+    monsters.push_back(CreateMonster(builder, &pos, 150,
+                                     static_cast<int16_t>(i), name, inventory,
+                                     Color_Blue));
+  }
+  Offset<Vector<Offset<Monster> > > sorted =
+    builder.CreateVectorOfSortedTables(&monsters);
+  Offset<Vector<uint64_t> > keys = builder.CreateKeyIndex(monsters);
+  Offset<String> name = builder.CreateString("MyMonster");
+  MonsterBuilder root(builder);
+  root.add_name(name);
+  root.add_testarrayoftables(sorted);
+  root.add_testarrayoftables_keys(keys);
+  root.add_hp(80);
+  FinishMonsterBuffer(builder, root.Finish());
+}
+
+static void BuildWide(FlatBufferBuilder &builder) {
+  using namespace Bench;
+  const int ints[] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+  const double doubles[] = { 1.5, 2.5, 3.5, 4.5 };
+  const Point points[] = { Point(1, 2, 3), Point(4, 5, 6) };
+  Offset<String> strings[] = {
+    builder.CreateString("zero"), builder.CreateString("one"),
+    builder.CreateString("two"), builder.CreateString("three")
+  };
+  Offset<Vector<int32_t> > v0 = builder.CreateVector(ints, 8);
+  Offset<Vector<int32_t> > v1 = builder.CreateVector(ints, 4);
+  Offset<Vector<uint8_t> > v2 = builder.CreateVector(
+    reinterpret_cast<const uint8_t *>("abcdefgh"), 8);
+  Offset<Vector<double> > v3 = builder.CreateVector(doubles, 4);
+  Offset<Vector<Offset<String> > > t0 = builder.CreateVector(strings, 4);
+  Offset<Vector<const Point *> > t1 = builder.CreateVectorOfStructs(points,
+                                                                    2);
+  WideBuilder wide(builder);
+  wide.add_i0(1); wide.add_i1(2); wide.add_i2(3); wide.add_i3(4);
+  wide.add_i4(5); wide.add_i5(6); wide.add_i6(7); wide.add_i7(8);
+  wide.add_l0(10); wide.add_l1(20); wide.add_l2(30); wide.add_l3(40);
+  wide.add_d0(0.5); wide.add_d1(1.5); wide.add_d2(2.5); wide.add_d3(3.5);
+  wide.add_b0(true); wide.add_b1(true); wide.add_u0(7); wide.add_u1(9);
+  wide.add_p0(&points[0]); wide.add_p1(&points[1]);
+  wide.add_s0(strings[0]); wide.add_s1(strings[1]);
+  wide.add_s2(strings[2]); wide.add_s3(strings[3]);
+  wide.add_v0(v0); wide.add_v1(v1); wide.add_v2(v2); wide.add_v3(v3);
+  wide.add_t0(t0); wide.add_t1(t1);
+  FinishWideBuffer(builder, wide.Finish());
+}
+
+// A complete binary tree of Nodes, depth levels below this one.
+static Offset<Bench::Node> BuildNode(FlatBufferBuilder &builder, int depth,
+                                     int id) {
+  Offset<Vector<Offset<Bench::Node> > > children = 0;
+  if (depth) {
+    Offset<Bench::Node> nodes[] = {
+      BuildNode(builder, depth - 1, id * 2 + 1),
+      BuildNode(builder, depth - 1, id * 2 + 2)
+    };
+    children = builder.CreateVector(nodes, 2);
+  }
+  return Bench::CreateNode(builder, id, id * 0.5,
+                           builder.CreateString("node"), children);
+}
+
+static void BuildDeep(FlatBufferBuilder &builder) {
+  Bench::FinishNodeBuffer(builder, BuildNode(builder, kTreeDepth, 0));
+}
+
+static std::string Contents(const FlatBufferBuilder &builder) {
+  return std::string(reinterpret_cast<const char *>(
+                       builder.GetBufferPointer()), builder.GetSize());
+}
+
+static bool SetUp(Data &data) {
+  for (int i = 0; i < kNumMonsters; i++) {
+    // Not in the order they're built in, so sorting has work to do.
+    data.names.push_back("Monster" + NumToString(i * 7919 % 1000) + "_" +
+                         NumToString(i));
+  }
+  for (int i = 0; i < 16; i++) {
+    data.inventory.push_back(static_cast<uint8_t>(i));
+  }
+  uint32_t seed = 48271;
+  for (int i = 0; i < kNumMonsters; i++) data.order.push_back(i);
+  for (int i = kNumMonsters - 1; i > 0; i--) {
+    seed = static_cast<uint32_t>(static_cast<uint64_t>(seed) * 279470273UL %
+                                 4294967291UL);
+    std::swap(data.order[i], data.order[seed % (i + 1)]);
+  }
+  data.next = 0;
+
+  BuildMonsters(data, data.builder);
+  data.monster = Contents(data.builder);
+  data.builder.Clear();
+  BuildWide(data.builder);
+  data.wide = Contents(data.builder);
+  data.builder.Clear();
+  BuildDeep(data.builder);
+  data.deep = Contents(data.builder);
+
+  std::string schema;
+  const char *include_directories[] = { "tests", NULL };
+  if (!LoadFile("tests/monster_test.fbs", false, &schema) ||
+      !LoadFile("tests/monster_test.bfbs", true, &data.bfbs)) {
+    fprintf(stderr, "flatbench: can't load tests/monster_test.fbs and "
+                    "tests/monster_test.bfbs\n");
+    return false;
+  }
+  if (!data.parser.Parse(schema.c_str(), include_directories)) {
+    fprintf(stderr, "flatbench: %s\n", data.parser.error_.c_str());
+    return false;
+  }
+  GeneratorOptions opts;
+  GenerateText(data.parser, data.monster.c_str(), opts, &data.json);
+  data.resizable.assign(data.monster.begin(), data.monster.end());
+  return true;
+}
+
+// ------------------------- BENCHMARKS -------------------------
+
+// Each benchmark performs one operation, and returns the amount of bytes it
+// processed (or 0 if that doesn't apply).
+typedef size_t (*BenchmarkFunction)(Data &data);
+
+// Keeps the compiler from optimizing away what is read.
+static volatile double sink;
+
+static const Monster *GetTestMonster(const Data &data) {
+  return GetMonster(data.monster.c_str());
+}
+
+static size_t BuildReused(Data &data) {
+  data.builder.Clear();
+  BuildMonsters(data, data.builder);
+  return data.builder.GetSize();
+}
+
+static size_t BuildSimpleAllocator(Data &data) {
+  FlatBufferBuilder builder;
+  BuildMonsters(data, builder);
+  return builder.GetSize();
+}
+
+static size_t BuildPoolAllocator(Data &data) {
+  static pool_allocator pool;
+  FlatBufferBuilder builder(1024, &pool);
+  BuildMonsters(data, builder);
+  return builder.GetSize();
+}
+
+static size_t BuildArenaAllocator(Data &data) {
+  static arena_allocator arena;
+  size_t size;
+  {
+    FlatBufferBuilder builder(1024, &arena);
+    BuildMonsters(data, builder);
+    size = builder.GetSize();
+  }
+  arena.reset();
+  return size;
+}
+
+static size_t BuildChunked(Data &data) {
+  FlatBufferBuilder builder;
+  builder.UseChunkedStorage(4096);
+  BuildMonsters(data, builder);
+  return builder.GetSize();
+}
+
+static size_t BuildWideReused(Data &data) {
+  data.builder.Clear();
+  BuildWide(data.builder);
+  return data.builder.GetSize();
+}
+
+static size_t BuildDeepReused(Data &data) {
+  data.builder.Clear();
+  BuildDeep(data.builder);
+  return data.builder.GetSize();
+}
+
+static double ReadMonster(const Monster &monster) {
+  const Vec3 *pos = monster.pos();
+  return monster.hp() + monster.mana() + monster.color() +
+         monster.name()->size() + monster.inventory()->Get(0) +
+         pos->x() + pos->y() + pos->z() + pos->test1() + pos->test3().a();
+}
+
+static size_t AccessSequential(Data &data) {
+  const Vector<Offset<Monster> > &monsters =
+    *GetTestMonster(data)->testarrayoftables();
+  double sum = 0;
+  for (uoffset_t i = 0; i < monsters.size(); i++) {
+    sum += ReadMonster(*monsters.Get(i));
+  }
+  sink = sum;
+  return data.monster.size();
+}
+
+static size_t AccessRandom(Data &data) {
+  const Vector<Offset<Monster> > &monsters =
+    *GetTestMonster(data)->testarrayoftables();
+  double sum = 0;
+  for (size_t i = 0; i < data.order.size(); i++) {
+    sum += ReadMonster(*monsters.Get(data.order[i]));
+  }
+  sink = sum;
+  return data.monster.size();
+}
+
+static size_t AccessWide(Data &data) {
+  const Bench::Wide &w = *Bench::GetWide(data.wide.c_str());
+  double sum = w.i0() + w.i1() + w.i2() + w.i3() + w.i4() + w.i5() + w.i6() +
+               w.i7();
+  sum += static_cast<double>(w.l0() + w.l1() + w.l2() + w.l3());
+  sum += w.d0() + w.d1() + w.d2() + w.d3();
+  sum += w.b0() + w.b1() + w.u0() + w.u1();
+  sum += w.p0()->x() + w.p1()->z();
+  sum += w.s0()->size() + w.s1()->size() + w.s2()->size() + w.s3()->size();
+  sum += w.v0()->Get(7) + w.v1()->Get(3) + w.v2()->Get(7) + w.v3()->Get(3);
+  sum += w.t0()->Get(3)->size() + w.t1()->Get(1)->y();
+  sink = sum;
+  return data.wide.size();
+}
+
+static double SumNodes(const Bench::Node &node) {
+  double sum = node.id() + node.weight() + node.name()->size();
+  const Vector<Offset<Bench::Node> > *children = node.children();
+  if (children) {
+    for (uoffset_t i = 0; i < children->size(); i++) {
+      sum += SumNodes(*children->Get(i));
+    }
+  }
+  return sum;
+}
+
+static size_t AccessDeep(Data &data) {
+  sink = SumNodes(*Bench::GetNode(data.deep.c_str()));
+  return data.deep.size();
+}
+
+static size_t VerifyMonster(Data &data) {
+  Verifier verifier(reinterpret_cast<const uint8_t *>(data.monster.c_str()),
+                    data.monster.size());
+  sink = VerifyMonsterBuffer(verifier);
+  return data.monster.size();
+}
+
+static size_t VerifyWide(Data &data) {
+  Verifier verifier(reinterpret_cast<const uint8_t *>(data.wide.c_str()),
+                    data.wide.size());
+  sink = Bench::VerifyWideBuffer(verifier);
+  return data.wide.size();
+}
+
+static size_t VerifyDeep(Data &data) {
+  Verifier verifier(reinterpret_cast<const uint8_t *>(data.deep.c_str()),
+                    data.deep.size());
+  sink = Bench::VerifyNodeBuffer(verifier);
+  return data.deep.size();
+}
+
+static size_t ParseJson(Data &data) {
+  sink = data.parser.Parse(data.json.c_str());
+  return data.json.size();
+}
+
+static size_t GenerateJson(Data &data) {
+  data.text.clear();
+  GeneratorOptions opts;
+  GenerateText(data.parser, data.monster.c_str(), opts, &data.text);
+  return data.text.size();
+}
+
+static const std::string &NextName(Data &data) {
+  if (data.next == data.order.size()) data.next = 0;
+  return data.names[data.order[data.next++]];
+}
+
+static size_t LookupByKey(Data &data) {
+  const char *name = NextName(data).c_str();
+  sink = GetTestMonster(data)->testarrayoftables()->LookupByKey(name)->hp();
+  return 0;
+}
+
+static size_t LookupByKeyIndex(Data &data) {
+  const char *name = NextName(data).c_str();
+  sink = GetTestMonster(data)->testarrayoftables_by_key(name)->hp();
+  return 0;
+}
+
+static size_t ReflectionCopyTable(Data &data) {
+  const reflection::Schema &schema = *reflection::GetSchema(data.bfbs.c_str());
+  data.builder.Clear();
+  data.builder.Finish(CopyTable(data.builder, schema, *schema.root_table(),
+                                *GetAnyRoot(reinterpret_cast<const uint8_t *>(
+                                  data.monster.c_str()))));
+  return data.monster.size();
+}
+
+static size_t ReflectionSetString(Data &data) {
+  const reflection::Schema &schema = *reflection::GetSchema(data.bfbs.c_str());
+  const reflection::Field &name_field =
+    *schema.root_table()->fields()->LookupByKey("name");
+  const String *name = GetFieldS(*GetAnyRoot(&data.resizable[0]), name_field);
+  // Alternate between growing and shrinking the string.
+  SetString(schema, name->size() == 9 ? "A much longer name" : "MyMonster",
+            name, &data.resizable);
+  return data.resizable.size();
+}
+
+struct Benchmark {
+  const char *name;
+  BenchmarkFunction run;
+};
+
+static const Benchmark benchmarks[] = {
+  { "build/monster/reused", BuildReused },
+  { "build/monster/simple_allocator", BuildSimpleAllocator },
+  { "build/monster/pool_allocator", BuildPoolAllocator },
+  { "build/monster/arena_allocator", BuildArenaAllocator },
+  { "build/monster/chunked", BuildChunked },
+  { "build/wide", BuildWideReused },
+  { "build/deep", BuildDeepReused },
+  { "access/monster/sequential", AccessSequential },
+  { "access/monster/random", AccessRandom },
+  { "access/wide", AccessWide },
+  { "access/deep", AccessDeep },
+  { "verify/monster", VerifyMonster },
+  { "verify/wide", VerifyWide },
+  { "verify/deep", VerifyDeep },
+  { "json/parse", ParseJson },
+  { "json/generate", GenerateJson },
+  { "lookup/key", LookupByKey },
+  { "lookup/key_index", LookupByKeyIndex },
+  { "reflection/copy_table", ReflectionCopyTable },
+  { "reflection/set_string", ReflectionSetString },
+};
+
+// ------------------------- RUNNING -------------------------
+
+static double Seconds() {
+  #ifdef _WIN32
+    LARGE_INTEGER count, frequency;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&frequency);
+    return static_cast<double>(count.QuadPart) / frequency.QuadPart;
+  #else
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+  #endif
+}
+
+// Runs a benchmark for at least min_time seconds (after running it once to
+// warm up), and prints its results.
+static void RunBenchmark(const Benchmark &benchmark, Data &data,
+                         double min_time) {
+  benchmark.run(data);
+  unsigned long iterations = 1;
+  for (;;) {
+    size_t allocations = num_allocations;
+    size_t allocated_bytes = num_allocated_bytes;
+    double bytes = 0;
+    double start = Seconds();
+    for (unsigned long i = 0; i < iterations; i++) {
+      bytes += benchmark.run(data);
+    }
+    double elapsed = Seconds() - start;
+    if (elapsed >= min_time || iterations >= 1000000000UL) {
+      printf("%s,%lu,%.1f,%.1f,%.2f,%.1f\n", benchmark.name, iterations,
+             elapsed * 1e9 / iterations,
+             elapsed > 0 ? bytes / elapsed / 1e6 : 0.0,
+             static_cast<double>(num_allocations - allocations) / iterations,
+             static_cast<double>(num_allocated_bytes - allocated_bytes) /
+               iterations);
+      fflush(stdout);
+      return;
+    }
+    // Aim a little past min_time, growing at most 10x per round.
+    double factor = elapsed > 0 ? min_time * 1.2 / elapsed : 10;
+    iterations = static_cast<unsigned long>(
+      iterations * (factor < 10 ? factor : 10)) + 1;
+  }
+}
+
+static void Usage(const char *program_name) {
+  fprintf(stderr,
+    "Usage: %s [OPTION]...\n"
+    "  --filter TEXT   Only run benchmarks with TEXT in their name.\n"
+    "  --min-time S    Run each benchmark for at least S seconds "
+    "(default 0.5).\n"
+    "  --quick         Run each benchmark once, to check that they work.\n"
+    "  --list          List the benchmarks, without running them.\n",
+    program_name);
+  exit(1);
+}
+
+int main(int argc, const char *argv[]) {
+  const char *filter = "";
+  double min_time = 0.5;
+  bool list = false;
+  for (int argi = 1; argi < argc; argi++) {
+    std::string arg = argv[argi];
+    if (arg == "--filter" && argi + 1 < argc) {
+      filter = argv[++argi];
+    } else if (arg == "--min-time" && argi + 1 < argc) {
+      min_time = atof(argv[++argi]);
+    } else if (arg == "--quick") {
+      min_time = 0;
+    } else if (arg == "--list") {
+      list = true;
+    } else {
+      Usage(argv[0]);
+    }
+  }
+
+  Data data;
+  if (!list && !SetUp(data)) return 1;
+  if (!list) {
+    printf("name,iterations,ns_per_op,mb_per_s,allocs_per_op,"
+           "alloc_bytes_per_op\n");
+  }
+  for (size_t i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); i++) {
+    if (!strstr(benchmarks[i].name, filter)) continue;
+    if (list) printf("%s\n", benchmarks[i].name);
+    else RunBenchmark(benchmarks[i], data, min_time);
+  }
+  return 0;
+}
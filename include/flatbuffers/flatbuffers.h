@@ -26,10 +26,13 @@
 #include <string>
 #include <tr1/type_traits>
 #include <vector>
+#include <set>
 #include <algorithm>
 #include <tr1/functional>
 #include <tr1/memory>
 
+#include "flatbuffers/hash.h"
+
 #if __cplusplus <= 199711L && \
     (!defined(_MSC_VER) || _MSC_VER < 1600) && \
     (!defined(__GNUC__) || \
@@ -114,6 +117,17 @@ namespace static_assert_impl {
 #define FLATBUFFERS_STRING_EXPAND(X) #X
 #define FLATBUFFERS_STRING(X) FLATBUFFERS_STRING_EXPAND(X)
 
+// Define FLATBUFFERS_STATS to have FlatBufferBuilder, Verifier and Parser
+// count what they do (see BuilderStats etc.). Without it the counters are
+// never updated, and their stats are always zero. The counters are members
+// either way, so code compiled with and without it can be linked together
+// (e.g. with a library built without it).
+#ifdef FLATBUFFERS_STATS
+  #define FLATBUFFERS_STAT(X) X
+#else
+  #define FLATBUFFERS_STAT(X)
+#endif
+
 #if (!defined(_MSC_VER) || _MSC_VER > 1600) && \
     (!defined(__GNUC__) || (__GNUC__ * 100 + __GNUC_MINOR__ >= 407))
   #define FLATBUFFERS_FINAL_CLASS final
@@ -137,6 +151,10 @@ typedef uint16_t voffset_t;
 
 typedef uintmax_t largest_scalar_t;
 
+// Offsets of fields with the offset64 attribute, which refer to vectors
+// stored after the end of the buffer, see large_buffer.h.
+typedef uint64_t uoffset64_t;
+
 // Pointer to relinquished memory.
 typedef std::tr1::shared_ptr<uint8_t> unique_ptr_t;
     
@@ -149,6 +167,14 @@ template<typename T> struct Offset {
   Offset<void> Union() const { return Offset<void>(o); }
 };
 
+// Similarly for vectors in the region following a large buffer, where o is
+// the position in the region (see LargeBufferBuilder).
+template<typename T> struct Offset64 {
+  uoffset64_t o;
+  Offset64() : o(0) {}
+  Offset64(uoffset64_t _o) : o(_o) {}
+};
+
 inline void EndianCheck() {
   int endiantest = 1;
   // If this fails, see FLATBUFFERS_LITTLEENDIAN above.
@@ -466,12 +492,134 @@ protected:
   uoffset_t length_;
 };
 
+// A vector referred to by a field with the offset64 attribute, which may
+// hold more than 4G elements. Its size is 64bit, and it holds scalars or
+// structs only (for structs, T is the struct itself, use data()).
+template<typename T> class Vector64 {
+public:
+  uoffset64_t size() const { return EndianScalar(length_); }
+
+  T Get(uoffset64_t i) const {
+    assert(i < size());
+    return ReadScalar<T>(Data() + i * sizeof(T));
+  }
+
+  T operator[](uoffset64_t i) const { return Get(i); }
+
+  // The raw data in little endian format. Use with care.
+  const uint8_t *Data() const {
+    return reinterpret_cast<const uint8_t *>(&length_ + 1);
+  }
+
+  uint8_t *Data() {
+    return reinterpret_cast<uint8_t *>(&length_ + 1);
+  }
+
+  const T *data() const { return reinterpret_cast<const T *>(Data()); }
+  T *data() { return reinterpret_cast<T *>(Data()); }
+
+  // Scalars only, like Vector::Mutate().
+  void Mutate(uoffset64_t i, T val) {
+    assert(i < size());
+    WriteScalar(data() + i, val);
+  }
+
+protected:
+  Vector64();
+
+  uoffset64_t length_;
+};
+
 // Convenient helper function to get the length of any vector, regardless
 // of wether it is null or not (the field is not set).
 template<typename T> static inline size_t VectorLength(const Vector<T> *v) {
   return v ? v->Length() : 0;
 }
 
+// A view of the elements of a vector of scalars or structs as one
+// contiguous array of T, aligned for T and in native byte order, e.g. to
+// process them with SIMD instructions. Generated code has a name_view()
+// accessor returning one for such vector fields. When the buffer is little
+// endian already (always true for structs, whose accessors do their own
+// byte swapping) and suitably aligned, this points straight into the
+// buffer, so it must stay valid while the view is used. Otherwise the
+// elements are copied into storage owned by the view.
+template<typename T> class VectorView {
+ public:
+  VectorView() : data_(NULL), size_(0) {}
+
+  // A NULL vector (a field that wasn't set) results in an empty view. E is
+  // the element type of the vector, which for structs is const T *.
+  template<typename E> explicit VectorView(const Vector<E> *vec)
+    : data_(NULL), size_(0) {
+    if (!vec) return;
+    assert(IndirectHelper<E>::element_stride == sizeof(T));
+    size_ = vec->size();
+    const uint8_t *data = vec->Data();
+    const bool in_place = FLATBUFFERS_LITTLEENDIAN ||
+                          !std::tr1::is_scalar<T>::value;
+    if (in_place && !(reinterpret_cast<size_t>(data) & (AlignOf<T>() - 1))) {
+      data_ = reinterpret_cast<const T *>(data);
+    } else {
+      T *copy = Allocate();
+      memcpy(copy, data, size_ * sizeof(T));
+      if (!in_place) SwapElements(copy, std::tr1::is_scalar<T>());
+    }
+  }
+
+  VectorView(const VectorView &other) : data_(other.data_), size_(other.size_) {
+    if (!other.storage_.empty()) memcpy(Allocate(), other.data_, Bytes());
+  }
+
+  VectorView &operator=(const VectorView &other) {
+    if (&other != this) {
+      data_ = other.data_;
+      size_ = other.size_;
+      storage_.clear();
+      if (!other.storage_.empty()) memcpy(Allocate(), other.data_, Bytes());
+    }
+    return *this;
+  }
+
+  const T *data() const { return data_; }
+  uoffset_t size() const { return size_; }
+  bool empty() const { return !size_; }
+
+  const T &operator[](uoffset_t i) const {
+    assert(i < size_);
+    return data_[i];
+  }
+
+  const T *begin() const { return data_; }
+  const T *end() const { return data_ + size_; }
+
+  // Whether the elements had to be copied out of the buffer.
+  bool copied() const { return !storage_.empty(); }
+
+ private:
+  size_t Bytes() const { return size_ * sizeof(T); }
+
+  T *Allocate() {
+    // Room for aligning the start, which also avoids an empty storage_.
+    storage_.resize(Bytes() + AlignOf<T>());
+    uint8_t *p = &storage_[0];
+    p += (~reinterpret_cast<size_t>(p) + 1) & (AlignOf<T>() - 1);
+    T *copy = reinterpret_cast<T *>(p);
+    data_ = copy;
+    return copy;
+  }
+
+  void SwapElements(T *elems, std::tr1::true_type /*is_scalar*/) {
+    for (uoffset_t i = 0; i < size_; i++) elems[i] = EndianScalar(elems[i]);
+  }
+
+  void SwapElements(T *, std::tr1::false_type /*is_scalar*/) {}
+
+  const T *data_;
+  uoffset_t size_;
+  std::vector<uint8_t> storage_;
+};
+
 struct String : public Vector<char> {
   const char *c_str() const { return reinterpret_cast<const char *>(Data()); }
   std::string str() const { return c_str(); }
@@ -481,6 +629,142 @@ struct String : public Vector<char> {
   }
 };
 
+// Maps a key to a 64 bit value with the same order, for key indices (see
+// FlatBufferBuilder::CreateKeyIndex). Strings map to their first 8 bytes,
+// so different strings may map to the same value.
+inline uint64_t KeyIndexValue(uint64_t val) { return val; }
+inline uint64_t KeyIndexValue(uint32_t val) { return val; }
+inline uint64_t KeyIndexValue(uint16_t val) { return val; }
+inline uint64_t KeyIndexValue(uint8_t val) { return val; }
+inline uint64_t KeyIndexValue(int64_t val) {
+  return static_cast<uint64_t>(val) ^ (static_cast<uint64_t>(1) << 63);
+}
+inline uint64_t KeyIndexValue(int32_t val) {
+  return KeyIndexValue(static_cast<int64_t>(val));
+}
+inline uint64_t KeyIndexValue(int16_t val) {
+  return KeyIndexValue(static_cast<int64_t>(val));
+}
+inline uint64_t KeyIndexValue(int8_t val) {
+  return KeyIndexValue(static_cast<int64_t>(val));
+}
+inline uint64_t KeyIndexValue(bool val) { return val; }
+inline uint64_t KeyIndexValue(double val) {
+  if (val == 0) val = 0;  // -0.0 equals 0.0.
+  uint64_t bits;
+  memcpy(&bits, &val, sizeof(bits));
+  // Negative numbers order in reverse, and below the positive ones.
+  const uint64_t sign = static_cast<uint64_t>(1) << 63;
+  return bits & sign ? ~bits : bits | sign;
+}
+inline uint64_t KeyIndexValue(float val) {
+  return KeyIndexValue(static_cast<double>(val));
+}
+inline uint64_t KeyIndexValue(const char *val) {
+  uint64_t prefix = 0;
+  for (int i = 0; i < 8 && val[i]; i++) {
+    prefix |= static_cast<uint64_t>(static_cast<unsigned char>(val[i])) <<
+              (56 - 8 * i);
+  }
+  return prefix;
+}
+inline uint64_t KeyIndexValue(const String *val) {
+  return KeyIndexValue(val->c_str());
+}
+
+// Like vec->LookupByKey(key), but uses the key index (a vector with the
+// KeyIndexValue() of the key of each table in vec) to find the table, and
+// only reads the tables that may match. Without an index that fits the
+// vector, falls back to LookupByKey().
+template<typename T, typename K> const T *LookupByKeyIndex(
+    const Vector<Offset<T> > *vec, const Vector<uint64_t> *index, K key) {
+  if (!vec) return NULL;
+  if (!index || index->size() != vec->size()) return vec->LookupByKey(key);
+  uint64_t val = KeyIndexValue(key);
+  // Find the run of index values equal to val: [first, last).
+  const uint8_t *data = index->Data();
+  uoffset_t first = 0;
+  for (uoffset_t count = index->size(); count; ) {
+    uoffset_t half = count / 2;
+    if (ReadScalar<uint64_t>(data + (first + half) * sizeof(uint64_t)) < val) {
+      first += half + 1;
+      count -= half + 1;
+    } else {
+      count = half;
+    }
+  }
+  uoffset_t last = first;
+  for (uoffset_t count = index->size() - first; count; ) {
+    uoffset_t half = count / 2;
+    if (ReadScalar<uint64_t>(data + (last + half) * sizeof(uint64_t)) == val) {
+      last += half + 1;
+      count -= half + 1;
+    } else {
+      count = half;
+    }
+  }
+  // Only keys with a shared string prefix have the same index value, those
+  // are searched among by reading the tables.
+  while (first < last) {
+    uoffset_t mid = first + (last - first) / 2;
+    const T *table = vec->Get(mid);
+    int comp = table->KeyCompareWithValue(key);
+    if (!comp) return table;
+    if (comp < 0) first = mid + 1;
+    else last = mid;
+  }
+  return NULL;
+}
+
+// A table offset with the KeyIndexValue() of its key.
+struct KeyedOffset {
+  uint64_t key;
+  uoffset_t o;
+};
+
+// Stable LSD radix sort of v by key, a byte at a time. Bytes that are the
+// same in all keys are skipped, so small or shared-prefix keys sort faster.
+inline void RadixSortByKey(std::vector<KeyedOffset> &v) {
+  const size_t kBytes = sizeof(uint64_t);
+  std::vector<size_t> counts(kBytes * 256, 0);
+  for (size_t i = 0; i < v.size(); i++) {
+    for (size_t b = 0; b < kBytes; b++) {
+      counts[b * 256 + ((v[i].key >> (b * 8)) & 0xFF)]++;
+    }
+  }
+  std::vector<KeyedOffset> tmp(v.size());
+  for (size_t b = 0; b < kBytes; b++) {
+    size_t *count = &counts[b * 256];
+    if (count[(v[0].key >> (b * 8)) & 0xFF] == v.size()) continue;
+    // Turn the counts into the start position of each bucket.
+    for (size_t i = 0, pos = 0; i < 256; i++) {
+      size_t c = count[i];
+      count[i] = pos;
+      pos += c;
+    }
+    for (size_t i = 0; i < v.size(); i++) {
+      tmp[count[(v[i].key >> (b * 8)) & 0xFF]++] = v[i];
+    }
+    v.swap(tmp);
+  }
+}
+
+class FlatBufferBuilder;
+
+// Whether the table type T has the KeyIndexValueAt() and KeyIndexIsExact()
+// generated for its key field. Tables from headers generated before these
+// existed, or written by hand, are sorted with KeyCompareLessThan() only.
+template<typename T> class HasKeyIndexValueAt {
+  typedef uint64_t (*ValueAt)(const FlatBufferBuilder &, uoffset_t);
+  typedef bool (*IsExact)();
+  template<ValueAt, IsExact> struct Members {};
+  template<typename U> static char Test(
+    Members<&U::KeyIndexValueAt, &U::KeyIndexIsExact> *);
+  template<typename U> static int Test(...);
+ public:
+  static const bool value = sizeof(Test<T>(NULL)) == sizeof(char);
+};
+
 // Simple indirection for buffer allocation, to allow this to be overridden
 // with custom allocation (see the FlatBufferBuilder constructor).
 class simple_allocator {
@@ -490,9 +774,196 @@ class simple_allocator {
   virtual void deallocate(uint8_t *p) const { delete[] p; }
 };
 
+// Allocator that carves allocations out of large blocks, and only frees them
+// all at once, in reset() or when the allocator is destroyed.
+// E.g. give each request its own builder on top of one arena, and reset the
+// arena when the request is done: the blocks are then reused by the next
+// request without going back to the system allocator.
+// Memory released by a builder growing its buffer is only reclaimed on
+// reset(), so pick a block_size comfortably larger than the buffers built.
+// Not thread-safe.
+class arena_allocator : public simple_allocator {
+ public:
+  explicit arena_allocator(size_t block_size = 64 * 1024)
+    : block_size_(block_size), current_(0), used_(0) {}
+
+  ~arena_allocator() {
+    for (std::vector<Block>::const_iterator it = blocks_.begin();
+         it != blocks_.end(); ++it) {
+      delete[] it->data;
+    }
+  }
+
+  virtual uint8_t *allocate(size_t size) const {
+    size_t largest_align = sizeof(largest_scalar_t);
+    size = (size + (largest_align - 1)) & ~(largest_align - 1);
+    // Find the first block (at or after the current one) this fits in.
+    while (current_ < blocks_.size() &&
+           size > blocks_[current_].size - used_) {
+      current_++;
+      used_ = 0;
+    }
+    if (current_ == blocks_.size()) {
+      Block block = { NULL, std::max(size, block_size_) };
+      block.data = new uint8_t[block.size];
+      blocks_.push_back(block);
+    }
+    uint8_t *p = blocks_[current_].data + used_;
+    used_ += size;
+    return p;
+  }
+
+  // Individual allocations are never freed, see reset().
+  virtual void deallocate(uint8_t *) const {}
+
+  // Make all memory available again for future allocations. Nothing
+  // allocated from this arena may be in use anymore.
+  void reset() {
+    current_ = 0;
+    used_ = 0;
+  }
+
+ private:
+  arena_allocator(const arena_allocator &);
+  arena_allocator &operator=(const arena_allocator &);
+
+  struct Block {
+    uint8_t *data;
+    size_t size;
+  };
+
+  size_t block_size_;
+  mutable std::vector<Block> blocks_;
+  mutable size_t current_;  // Block we're currently allocating from.
+  mutable size_t used_;     // Bytes of blocks_[current_] already in use.
+};
+
+// Allocator that keeps freed memory in per size class free lists, so
+// buffers can be recycled from one builder to the next.
+// Sizes are rounded up to a power of 2 (larger ones than the biggest size
+// class are not pooled), and at most max_free_per_class blocks are kept
+// around per size class.
+// This does no locking, instead use one instance per thread, shared by all
+// builders on that thread. Memory must be deallocated on the same thread,
+// and before the pool is destroyed.
+class pool_allocator : public simple_allocator {
+ public:
+  explicit pool_allocator(size_t max_free_per_class = 16)
+    : max_free_per_class_(max_free_per_class) {}
+
+  ~pool_allocator() {
+    for (int i = 0; i < kNumSizeClasses; i++) {
+      for (std::vector<uint8_t *>::const_iterator it = free_[i].begin();
+           it != free_[i].end(); ++it) {
+        delete[] *it;
+      }
+    }
+  }
+
+  virtual uint8_t *allocate(size_t size) const {
+    int size_class = 0;
+    while (size_class < kNumSizeClasses && ClassSize(size_class) < size)
+      size_class++;
+    uint8_t *block;
+    if (size_class < kNumSizeClasses && !free_[size_class].empty()) {
+      block = free_[size_class].back();
+      free_[size_class].pop_back();
+    } else {
+      // We remember the size class in a header in front of the memory we
+      // hand out, kept at full alignment for the data that follows it.
+      block = new uint8_t[kHeaderSize + (size_class < kNumSizeClasses
+                                           ? ClassSize(size_class)
+                                           : size)];
+      *reinterpret_cast<int *>(block) = size_class;
+    }
+    return block + kHeaderSize;
+  }
+
+  virtual void deallocate(uint8_t *p) const {
+    if (!p) return;
+    uint8_t *block = p - kHeaderSize;
+    int size_class = *reinterpret_cast<int *>(block);
+    if (size_class < kNumSizeClasses &&
+        free_[size_class].size() < max_free_per_class_) {
+      free_[size_class].push_back(block);
+    } else {
+      delete[] block;
+    }
+  }
+
+ private:
+  pool_allocator(const pool_allocator &);
+  pool_allocator &operator=(const pool_allocator &);
+
+  // From 256 bytes to 64MB.
+  static const int kNumSizeClasses = 19;
+  static const size_t kHeaderSize = sizeof(largest_scalar_t);
+  static size_t ClassSize(int size_class) {
+    return static_cast<size_t>(256) << size_class;
+  }
+
+  size_t max_free_per_class_;
+  mutable std::vector<uint8_t *> free_[kNumSizeClasses];
+};
+
+// A finished buffer taken over from a FlatBufferBuilder, see
+// FlatBufferBuilder::Release(). Unlike unique_ptr_t, this simply remembers
+// the allocation and the allocator it came from, and hands it back to that
+// allocator when destroyed or reset() (so with a pool_allocator the memory
+// gets recycled).
+// Instances can't be copied, transfer ownership with swap() instead.
+class DetachedBuffer {
+ public:
+  DetachedBuffer()
+    : allocator_(NULL), buf_(NULL), data_(NULL), size_(0) {}
+
+  ~DetachedBuffer() { reset(); }
+
+  // The finished FlatBuffer, or NULL if this doesn't hold a buffer.
+  uint8_t *data() const { return data_; }
+  size_t size() const { return size_; }
+
+  // Free the buffer held (if any).
+  void reset() {
+    if (buf_) allocator_->deallocate(buf_);
+    allocator_ = NULL;
+    buf_ = data_ = NULL;
+    size_ = 0;
+  }
+
+  void swap(DetachedBuffer &other) {
+    std::swap(allocator_, other.allocator_);
+    std::swap(buf_, other.buf_);
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+  }
+
+ private:
+  friend class vector_downward;
+
+  DetachedBuffer(const DetachedBuffer &);
+  DetachedBuffer &operator=(const DetachedBuffer &);
+
+  const simple_allocator *allocator_;
+  uint8_t *buf_;   // Start of the allocation.
+  uint8_t *data_;  // Start of the FlatBuffer, somewhere inside buf_.
+  size_t size_;
+};
+
+// A contiguous piece of a finished buffer, see
+// FlatBufferBuilder::GetBufferSegments().
+struct BufferSegment {
+  const uint8_t *data;
+  size_t size;
+};
+
 // This is a minimal replication of std::vector<uint8_t> functionality,
 // except growing from higher to lower addresses. i.e push_back() inserts data
 // in the lowest address in the vector.
+// Optionally (see set_chunk_size()), it grows by adding chunks rather than
+// reallocating. The data then consists of several segments, each of which is
+// the used part of a chunk, with any single make_space() always being
+// contiguous.
 class vector_downward {
  public:
   explicit vector_downward(size_t initial_size,
@@ -500,27 +971,44 @@ class vector_downward {
     : reserved_(initial_size),
       buf_(allocator.allocate(reserved_)),
       cur_(buf_ + reserved_),
+      base_(0),
+      chunk_size_(0),
       allocator_(allocator) {
     assert((initial_size & (sizeof(largest_scalar_t) - 1)) == 0);
+    num_reallocations_ = num_chunks_ = 0;
   }
 
   ~vector_downward() {
     if (buf_)
       allocator_.deallocate(buf_);
+    free_chunks(0);
   }
 
   void clear() {
+    if (!chunks_.empty()) {
+      // Keep the first chunk, which is aligned for use at the end of the
+      // buffer.
+      allocator_.deallocate(buf_);
+      buf_ = chunks_[0].buf;
+      reserved_ = chunks_[0].top - chunks_[0].buf;
+      free_chunks(1);
+      chunks_.clear();
+      base_ = 0;
+    }
     if (buf_ == NULL)
       buf_ = allocator_.allocate(reserved_);
 
     cur_ = buf_ + reserved_;
+    num_reallocations_ = num_chunks_ = 0;
   }
 
   // Relinquish the pointer to the caller.
   unique_ptr_t release() {
+    flatten();
     // Actually deallocate from the start of the allocated memory.
+    // Bind the allocator by pointer, a copy would lose its actual type.
     std::tr1::function<void(uint8_t *)> deleter(
-      std::tr1::bind(&simple_allocator::deallocate, allocator_, buf_));
+      std::tr1::bind(&simple_allocator::deallocate, &allocator_, buf_));
 
     // Point to the desired offset.
     unique_ptr_t retval(data(), deleter);
@@ -532,23 +1020,34 @@ class vector_downward {
     return retval;
   }
 
+  // Relinquish the buffer to "detached", freeing whatever it held before.
+  void release(DetachedBuffer *detached) {
+    flatten();
+    detached->reset();
+    detached->allocator_ = &allocator_;
+    detached->buf_ = buf_;
+    detached->data_ = data();
+    detached->size_ = size();
+
+    buf_ = NULL;
+    cur_ = NULL;
+  }
+
+  // Grow by allocating chunks of (at least) chunk_size bytes from now on,
+  // rather than by reallocating the whole buffer. 0 switches back to the
+  // default once the buffer is contiguous again.
+  void set_chunk_size(size_t chunk_size) { chunk_size_ = chunk_size; }
+
+  // Whether the data is a single segment, i.e. data() points to all of it.
+  bool is_contiguous() const { return chunks_.empty(); }
+
   size_t growth_policy(size_t bytes) {
     return (bytes / 2) & ~(sizeof(largest_scalar_t) - 1);
   }
 
   uint8_t *make_space(size_t len) {
     if (len > static_cast<size_t>(cur_ - buf_)) {
-      uoffset_t old_size = size();
-      size_t largest_align = AlignOf<largest_scalar_t>();
-      reserved_ += std::max(len, growth_policy(reserved_));
-      // Round up to avoid undefined behavior from unaligned loads and stores.
-      reserved_ = (reserved_ + (largest_align - 1)) & ~(largest_align - 1);
-      uint8_t* new_buf = allocator_.allocate(reserved_);
-      uint8_t* new_cur = new_buf + reserved_ - old_size;
-      memcpy(new_cur, cur_, old_size);
-      cur_ = new_cur;
-      allocator_.deallocate(buf_);
-      buf_ = new_buf;
+      if (chunk_size_) new_chunk(len); else reallocate(len);
     }
     cur_ -= len;
     // Beyond this, signed offsets may not have enough range:
@@ -557,9 +1056,15 @@ class vector_downward {
     return cur_;
   }
 
+  // Ensure the next "len" bytes written end up in the same segment, so
+  // they can be accessed through data_at() as a whole afterwards.
+  void make_contiguous(size_t len) {
+    if (chunk_size_ && len > static_cast<size_t>(cur_ - buf_)) new_chunk(len);
+  }
+
   uoffset_t size() const {
     assert(cur_ != NULL && buf_ != NULL);
-    return static_cast<uoffset_t>(reserved_ - (cur_ - buf_));
+    return static_cast<uoffset_t>(base_ + reserved_ - (cur_ - buf_));
   }
 
   uint8_t *data() const {
@@ -567,31 +1072,169 @@ class vector_downward {
     return cur_;
   }
 
-  uint8_t *data_at(size_t offset) { return buf_ + reserved_ - offset; }
+  // The data "offset" bytes from the end of the buffer. With chunks, an
+  // object is only contiguous if it was written with a single make_space(),
+  // or after a make_contiguous().
+  uint8_t *data_at(size_t offset) const {
+    if (offset > base_ || chunks_.empty())
+      return buf_ + reserved_ - (offset - base_);
+    // The last chunk that starts before offset, except that offset 0 (the
+    // end of the buffer) is the end of the first chunk.
+    std::vector<Chunk>::const_iterator it =
+      std::lower_bound(chunks_.begin(), chunks_.end(), offset,
+                       ChunkBaseLess());
+    const Chunk &chunk = it == chunks_.begin() ? *it : *(it - 1);
+    return chunk.top - (offset - chunk.base);
+  }
+
+  // Append all segments of the data, front to back.
+  void segments(std::vector<BufferSegment> *segs) const {
+    BufferSegment seg = { cur_, reserved_ - (cur_ - buf_) };
+    if (seg.size) segs->push_back(seg);
+    for (std::vector<Chunk>::const_reverse_iterator it = chunks_.rbegin();
+         it != chunks_.rend(); ++it) {
+      BufferSegment chunk_seg = { it->top - it->size, it->size };
+      segs->push_back(chunk_seg);
+    }
+  }
+
+  // Copy all segments into a single new contiguous buffer.
+  void flatten() {
+    if (chunks_.empty()) return;
+    size_t largest_align = AlignOf<largest_scalar_t>();
+    size_t old_size = size();
+    size_t new_reserved =
+      (old_size + (largest_align - 1)) & ~(largest_align - 1);
+    uint8_t *new_buf = allocator_.allocate(new_reserved);
+    uint8_t *new_cur = new_buf + new_reserved - old_size;
+    std::vector<BufferSegment> segs;
+    segments(&segs);
+    uint8_t *dest = new_cur;
+    for (std::vector<BufferSegment>::const_iterator it = segs.begin();
+         it != segs.end(); ++it) {
+      memcpy(dest, it->data, it->size);
+      dest += it->size;
+    }
+    allocator_.deallocate(buf_);
+    free_chunks(0);
+    chunks_.clear();
+    base_ = 0;
+    reserved_ = new_reserved;
+    buf_ = new_buf;
+    cur_ = new_cur;
+  }
 
   // push() & fill() are most frequently called with small byte counts (<= 4),
-  // which is why we're using loops rather than calling memcpy/memset.
+  // which is why we're using loops for those rather than calling
+  // memcpy/memset.
   void push(const uint8_t *bytes, size_t num) {
     uint8_t* dest = make_space(num);
-    for (size_t i = 0; i < num; i++) dest[i] = bytes[i];
+    if (num > kSmallCopySize) {
+      memcpy(dest, bytes, num);
+    } else {
+      for (size_t i = 0; i < num; i++) dest[i] = bytes[i];
+    }
+  }
+
+  // Specialized version of push() for scalars, which are always small.
+  template<typename T> void push_small(T little_endian_t) {
+    uint8_t* dest = make_space(sizeof(T));
+    memcpy(dest, &little_endian_t, sizeof(T));
   }
 
   void fill(size_t zero_pad_bytes) {
     uint8_t* dest = make_space(zero_pad_bytes);
-    for (size_t i = 0; i < zero_pad_bytes; i++) dest[i] = 0;
+    if (zero_pad_bytes > kSmallCopySize) {
+      memset(dest, 0, zero_pad_bytes);
+    } else {
+      for (size_t i = 0; i < zero_pad_bytes; i++) dest[i] = 0;
+    }
+  }
+
+  void pop(size_t bytes_to_remove) {
+    // Can't pop across segments.
+    assert(bytes_to_remove <= reserved_ - static_cast<size_t>(cur_ - buf_));
+    cur_ += bytes_to_remove;
   }
 
-  void pop(size_t bytes_to_remove) { cur_ += bytes_to_remove; }
+  // Times make_space() reallocated, or added a chunk, since clear() (only
+  // counted with FLATBUFFERS_STATS).
+  size_t num_reallocations() const { return num_reallocations_; }
+  size_t num_chunks() const { return num_chunks_; }
 
  private:
   // You shouldn't really be copying instances of this class.
   vector_downward(const vector_downward &);
   vector_downward &operator=(const vector_downward &);
 
+  // A full chunk, whose used part is the "size" bytes below "top".
+  struct Chunk {
+    uint8_t *buf;
+    uint8_t *top;
+    size_t base;  // Amount of data in all chunks before this one.
+    size_t size;
+  };
+
+  static const size_t kSmallCopySize = 16;
+
+  struct ChunkBaseLess {
+    bool operator()(const Chunk &chunk, size_t offset) const {
+      return chunk.base < offset;
+    }
+  };
+
+  void reallocate(size_t len) {
+    FLATBUFFERS_STAT(num_reallocations_++);
+    uoffset_t old_size = size();
+    size_t largest_align = AlignOf<largest_scalar_t>();
+    reserved_ += std::max(len, growth_policy(reserved_));
+    // Round up to avoid undefined behavior from unaligned loads and stores.
+    reserved_ = (reserved_ + (largest_align - 1)) & ~(largest_align - 1);
+    uint8_t* new_buf = allocator_.allocate(reserved_);
+    uint8_t* new_cur = new_buf + reserved_ - old_size;
+    memcpy(new_cur, cur_, old_size);
+    cur_ = new_cur;
+    allocator_.deallocate(buf_);
+    buf_ = new_buf;
+  }
+
+  // Continue in a new chunk with room for at least "len" bytes.
+  void new_chunk(size_t len) {
+    FLATBUFFERS_STAT(num_chunks_++);
+    size_t used = reserved_ - (cur_ - buf_);
+    if (used) {
+      Chunk chunk = { buf_, buf_ + reserved_, base_, used };
+      chunks_.push_back(chunk);
+      base_ += used;
+    } else {
+      allocator_.deallocate(buf_);
+    }
+    size_t largest_align = AlignOf<largest_scalar_t>();
+    size_t alloc_size = std::max(chunk_size_, len + largest_align);
+    buf_ = allocator_.allocate(alloc_size);
+    // Skip a few bytes at the top if needed, such that data gets the same
+    // alignment relative to the end of the buffer as it would have had in a
+    // contiguous buffer.
+    reserved_ = alloc_size -
+      ((reinterpret_cast<uintptr_t>(buf_) + alloc_size + base_) &
+       (largest_align - 1));
+    cur_ = buf_ + reserved_;
+  }
+
+  void free_chunks(size_t first) {
+    for (size_t i = first; i < chunks_.size(); i++)
+      allocator_.deallocate(chunks_[i].buf);
+  }
+
   size_t reserved_;
   uint8_t *buf_;
   uint8_t *cur_;  // Points at location between empty (below) and used (above).
+  size_t base_;  // Amount of data in chunks_.
+  std::vector<Chunk> chunks_;  // Full chunks, oldest (end of buffer) first.
+  size_t chunk_size_;
   const simple_allocator &allocator_;
+  size_t num_reallocations_;
+  size_t num_chunks_;
 };
 
 // Converts a Field ID to a virtual table offset.
@@ -608,6 +1251,21 @@ inline size_t PaddingBytes(size_t buf_size, size_t scalar_size) {
   return ((~buf_size) + 1) & (scalar_size - 1);
 }
 
+// What a FlatBufferBuilder did since it was constructed or Clear()ed, see
+// FlatBufferBuilder::GetStats(). Only counted with FLATBUFFERS_STATS.
+struct BuilderStats {
+  BuilderStats()
+    : reallocations(0), chunks(0), padding_bytes(0), vtables_created(0),
+      vtables_reused(0), forced_default_bytes(0) {}
+
+  size_t reallocations;         // Times the buffer grew by being copied.
+  size_t chunks;                // Chunks added, with chunked storage.
+  size_t padding_bytes;         // Zeroes written to align data.
+  size_t vtables_created;
+  size_t vtables_reused;        // Tables that share an earlier vtable.
+  size_t forced_default_bytes;  // Written for defaults by ForceDefaults().
+};
+
 // Helper class to hold data needed in creation of a flat buffer.
 // To serialize data, you typically call one of the Create*() functions in
 // the generated code, which in turn call a sequence of StartTable/PushElement/
@@ -618,10 +1276,12 @@ class FlatBufferBuilder FLATBUFFERS_FINAL_CLASS {
  public:
   explicit FlatBufferBuilder(uoffset_t initial_size = 1024,
                              const simple_allocator *allocator = NULL)
-      : buf_(initial_size, allocator ? *allocator : default_allocator),
+      : buf_(initial_size, allocator ? *allocator : DefaultAllocator()),
+        string_pool_(StringOffsetCompare(buf_)), num_vtables_(0),
+        max_vtables_(0), fixed_vtable_(NULL), fixed_vtable_offset_(0),
         minalign_(1), force_defaults_(false) {
     offsetbuf_.reserve(16);  // Avoid first few reallocs.
-    vtables_.reserve(16);
+    vtables_.resize(16, 0);
     EndianCheck();
   }
 
@@ -630,31 +1290,89 @@ class FlatBufferBuilder FLATBUFFERS_FINAL_CLASS {
   void Clear() {
     buf_.clear();
     offsetbuf_.clear();
-    vtables_.clear();
+    string_pool_.clear();
+    std::fill(vtables_.begin(), vtables_.end(), 0);
+    num_vtables_ = 0;
+    fixed_vtable_ = NULL;
+    fixed_vtable_offset_ = 0;
     minalign_ = 1;
+    stats_ = BuilderStats();
+  }
+
+  // Counters of where the work and bytes of building went, e.g. to tune
+  // the initial_size given to the constructor, or a schema's layout. All
+  // zero unless compiled with FLATBUFFERS_STATS.
+  BuilderStats GetStats() const {
+    BuilderStats stats = stats_;
+    stats.reallocations = buf_.num_reallocations();
+    stats.chunks = buf_.num_chunks();
+    return stats;
   }
 
   // The current size of the serialized buffer, counting from the end.
   uoffset_t GetSize() const { return buf_.size(); }
 
+  // The alignment the serialized buffer needs (after you call Finish()).
+  size_t GetBufferMinAlignment() const { return minalign_; }
+
   // Get the serialized buffer (after you call Finish()).
-  uint8_t *GetBufferPointer() const { return buf_.data(); }
+  // With chunked storage, call Flatten() first.
+  uint8_t *GetBufferPointer() const {
+    assert(buf_.is_contiguous());
+    return buf_.data();
+  }
+
+  // Store the buffer in chunks of (at least) chunk_size bytes: when out of
+  // space, rather than allocating a bigger buffer and copying everything
+  // written so far, a new chunk is started. The finished buffer then
+  // consists of several segments, see GetBufferSegments().
+  // Call this before serializing anything.
+  void UseChunkedStorage(size_t chunk_size) {
+    assert(!GetSize());
+    buf_.set_chunk_size(chunk_size);
+  }
+
+  // Get the serialized buffer (after you call Finish()) as a list of
+  // segments, front to back, which together form the FlatBuffer (e.g. to
+  // pass to writev()). Without chunked storage, this is a single segment.
+  void GetBufferSegments(std::vector<BufferSegment> *segments) const {
+    buf_.segments(segments);
+  }
+
+  // Copy all segments of a chunked buffer into a single contiguous one.
+  void Flatten() { buf_.flatten(); }
 
   // Get the released pointer to the serialized buffer.
-  // Don't attempt to use this FlatBufferBuilder afterwards!
+  // Call Clear() before using this FlatBufferBuilder again, which will get a
+  // fresh buffer from the allocator (with a pool_allocator, that will be a
+  // recycled one if any released buffer has been freed in the mean time).
   // The unique_ptr returned has a special allocator that knows how to
   // deallocate this pointer (since it points to the middle of an allocation).
   // Thus, do not mix this pointer with other unique_ptr's, or call release() /
   // reset() on it.
+  // With chunked storage, the buffer is flattened first.
   unique_ptr_t ReleaseBufferPointer() { return buf_.release(); }
 
+  // Like ReleaseBufferPointer(), but hands the buffer to a DetachedBuffer,
+  // which avoids creating a deleter for it.
+  void Release(DetachedBuffer *buf) { buf_.release(buf); }
+
   void ForceDefaults(bool fd) { force_defaults_ = fd; }
 
-  void Pad(size_t num_bytes) { buf_.fill(num_bytes); }
+  // Limit the number of distinct vtables remembered for sharing between
+  // tables. Once the limit is reached, tables with a new layout still get
+  // their own vtable, it just won't be reused by later tables.
+  // 0 (the default) means no limit.
+  void MaxSharedVTables(size_t max_vtables) { max_vtables_ = max_vtables; }
+
+  void Pad(size_t num_bytes) {
+    FLATBUFFERS_STAT(stats_.padding_bytes += num_bytes);
+    buf_.fill(num_bytes);
+  }
 
   void Align(size_t elem_size) {
     if (elem_size > minalign_) minalign_ = elem_size;
-    buf_.fill(PaddingBytes(buf_.size(), elem_size));
+    Pad(PaddingBytes(buf_.size(), elem_size));
   }
 
   void PushBytes(const uint8_t *bytes, size_t size) {
@@ -676,7 +1394,7 @@ class FlatBufferBuilder FLATBUFFERS_FINAL_CLASS {
     AssertScalarT<T>();
     T litle_endian_element = EndianScalar(element);
     Align(sizeof(T));
-    PushBytes(reinterpret_cast<uint8_t *>(&litle_endian_element), sizeof(T));
+    buf_.push_small(litle_endian_element);
     return GetSize();
   }
 
@@ -695,7 +1413,10 @@ class FlatBufferBuilder FLATBUFFERS_FINAL_CLASS {
   // Like PushElement, but additionally tracks the field this represents.
   template<typename T> void AddElement(voffset_t field, T e, T def) {
     // We don't serialize values equal to the default.
-    if (e == def && !force_defaults_) return;
+    if (e == def) {
+      if (!force_defaults_) return;
+      FLATBUFFERS_STAT(stats_.forced_default_bytes += sizeof(T));
+    }
     uoffset_t off = PushElement(e);
     TrackField(field, off);
   }
@@ -705,6 +1426,17 @@ class FlatBufferBuilder FLATBUFFERS_FINAL_CLASS {
     AddElement(field, ReferTo(off.o), static_cast<uoffset_t>(0));
   }
 
+  // For fields with the offset64 attribute, refers to a vector created with
+  // a LargeBufferBuilder for this builder (see large_buffer.h).
+  template<typename T> void AddOffset64(voffset_t field, Offset64<T> off) {
+    if (!off.o) return;  // NULL, don't store.
+    Align(sizeof(uoffset64_t));
+    // The region starts where this buffer ends, and GetSize() is the
+    // distance to there: the offset is from the field to the vector.
+    AddElement(field, off.o + GetSize() + sizeof(uoffset64_t),
+               static_cast<uoffset64_t>(0));
+  }
+
   template<typename T> void AddStruct(voffset_t field, const T *structptr) {
     if (!structptr) return;  // Default, don't store.
     Align(AlignOf<T>());
@@ -748,6 +1480,7 @@ class FlatBufferBuilder FLATBUFFERS_FINAL_CLASS {
     // Write a vtable, which consists entirely of voffset_t elements.
     // It starts with the number of offsets, followed by a type id, followed
     // by the offsets themselves. In reverse:
+    buf_.make_contiguous(FieldIndexToOffset(numfields));
     buf_.fill(numfields * sizeof(voffset_t));
     uoffset_t table_object_size = vtableoffsetloc - start;
     assert(table_object_size < 0x10000);  // Vtable use 16bit offsets.
@@ -763,31 +1496,47 @@ class FlatBufferBuilder FLATBUFFERS_FINAL_CLASS {
       WriteScalar<voffset_t>(buf_.data() + field_location->id, pos);
     }
     offsetbuf_.clear();
-    voffset_t* vt1 = reinterpret_cast<voffset_t *>(buf_.data());
-    voffset_t vt1_size = ReadScalar<voffset_t>(vt1);
-    uoffset_t vt_use = GetSize();
-    // See if we already have generated a vtable with this exact same
-    // layout before. If so, make it point to the old one, remove this one.
-      for (std::vector<uoffset_t>::const_iterator it = vtables_.begin(); it != vtables_.end(); ++it) {
-      voffset_t* vt2 = reinterpret_cast<voffset_t *>(buf_.data_at(*it));
-      voffset_t vt2_size = *vt2;
-      if (vt1_size != vt2_size || memcmp(vt2, vt1, vt1_size)) continue;
-      vt_use = *it;
-      buf_.pop(GetSize() - vtableoffsetloc);
-      break;
+    bool remembered;
+    ShareVTable(vtableoffsetloc, &remembered);
+    return vtableoffsetloc;
+  }
+
+  // For tables whose layout is known up front, such as those built by
+  // generated Create functions when all fields are set (--gen-fixed-create):
+  // call StartFixedTable with the largest field size, push the fields in
+  // the order the vtable describes with PushElement, and pass the complete
+  // vtable (in native byte order) to EndFixedTable. This skips tracking the
+  // fields, and when the same vtable (by address, so usually a static
+  // array) was the last one passed, writing and comparing the vtable too.
+  uoffset_t StartFixedTable(size_t alignment) {
+    NotNested();
+    // Fixes the padding inside the table, so it matches the vtable.
+    Align(alignment < sizeof(soffset_t) ? sizeof(soffset_t) : alignment);
+    return GetSize();
+  }
+
+  uoffset_t EndFixedTable(uoffset_t start, const voffset_t *vtable) {
+    uoffset_t vtableoffsetloc = PushElement<soffset_t>(0);
+    // If this asserts, the fields pushed don't match the vtable.
+    assert(vtableoffsetloc - start == vtable[1]);
+    (void)start;
+    if (vtable == fixed_vtable_) {
+      FLATBUFFERS_STAT(stats_.vtables_reused++);
+      WriteScalar(buf_.data_at(vtableoffsetloc),
+                  static_cast<soffset_t>(fixed_vtable_offset_) -
+                    static_cast<soffset_t>(vtableoffsetloc));
+      return vtableoffsetloc;
     }
-    // If this is a new vtable, remember it.
-    if (vt_use == GetSize()) {
-      vtables_.push_back(vt_use);
+    buf_.make_contiguous(vtable[0]);
+    for (size_t i = vtable[0] / sizeof(voffset_t); i; ) {
+      PushElement<voffset_t>(vtable[--i]);
+    }
+    bool remembered;
+    uoffset_t vt_use = ShareVTable(vtableoffsetloc, &remembered);
+    if (remembered) {
+      fixed_vtable_ = vtable;
+      fixed_vtable_offset_ = vt_use;
     }
-    // Fill the vtable offset we created above.
-    // The offset points from the beginning of the object to where the
-    // vtable is stored.
-    // Offsets default direction is downward in memory for future format
-    // flexibility (storing all vtables at the start of the file).
-    WriteScalar(buf_.data_at(vtableoffsetloc),
-                static_cast<soffset_t>(vt_use) -
-                  static_cast<soffset_t>(vtableoffsetloc));
     return vtableoffsetloc;
   }
 
@@ -795,13 +1544,32 @@ class FlatBufferBuilder FLATBUFFERS_FINAL_CLASS {
   // just been constructed.
   template<typename T> void Required(Offset<T> table, voffset_t field) {
     uint8_t* table_ptr = buf_.data_at(table.o);
-    uint8_t* vtable_ptr = table_ptr - ReadScalar<soffset_t>(table_ptr);
+    // Same as table_ptr - soffset, but also works with chunked storage.
+    uint8_t* vtable_ptr =
+      buf_.data_at(table.o + ReadScalar<soffset_t>(table_ptr));
     bool ok = ReadScalar<voffset_t>(vtable_ptr + field) != 0;
     // If this fails, the caller will show what field needs to be set.
     assert(ok);
     (void)ok;
   }
 
+  // Read a field of a table built earlier, going through data_at() for the
+  // vtable and the string, so unlike the table's own accessors this also
+  // works on chunked storage that was not flattened. Generated code uses
+  // these for KeyIndexValueAt().
+  template<typename T> T GetFieldAt(uoffset_t table, voffset_t field,
+                                    T defaultval) const {
+    uoffset_t field_o = FieldOffsetAt(table, field);
+    return field_o ? ReadScalar<T>(buf_.data_at(field_o)) : defaultval;
+  }
+
+  const String *GetStringAt(uoffset_t table, voffset_t field) const {
+    uoffset_t field_o = FieldOffsetAt(table, field);
+    if (!field_o) return NULL;
+    uoffset_t str_o = field_o - ReadScalar<uoffset_t>(buf_.data_at(field_o));
+    return reinterpret_cast<const String *>(buf_.data_at(str_o));
+  }
+
   uoffset_t StartStruct(size_t alignment) {
     Align(alignment);
     return GetSize();
@@ -814,7 +1582,7 @@ class FlatBufferBuilder FLATBUFFERS_FINAL_CLASS {
   // Aligns such that when "len" bytes are written, an object can be written
   // after it with "alignment" without padding.
   void PreAlign(size_t len, size_t alignment) {
-    buf_.fill(PaddingBytes(GetSize() + len, alignment));
+    Pad(PaddingBytes(GetSize() + len, alignment));
   }
   template<typename T> void PreAlign(size_t len) {
     AssertScalarT<T>();
@@ -843,6 +1611,37 @@ class FlatBufferBuilder FLATBUFFERS_FINAL_CLASS {
     return CreateString(str->c_str(), str->Length());
   }
 
+  // Like CreateString, but if an identical string was already stored with
+  // this function since the last Clear(), that string is returned instead,
+  // so repeated values are only stored in the buffer once.
+  Offset<String> CreateSharedString(const char *str, size_t len) {
+    // The pool refers to strings by their offset in the buffer, so the
+    // string needs to be serialized before we can compare it.
+    buf_.make_contiguous(len + 1 + 2 * sizeof(uoffset_t));
+    uoffset_t size_before_string = GetSize();
+    Offset<String> off = CreateString(str, len);
+    StringOffsetMap::const_iterator it = string_pool_.find(off);
+    if (it != string_pool_.end()) {
+      // Reuse the existing string, and remove the one we just wrote.
+      buf_.pop(GetSize() - size_before_string);
+      return *it;
+    }
+    string_pool_.insert(off);
+    return off;
+  }
+
+  Offset<String> CreateSharedString(const char *str) {
+    return CreateSharedString(str, strlen(str));
+  }
+
+  Offset<String> CreateSharedString(const std::string &str) {
+    return CreateSharedString(str.c_str(), str.length());
+  }
+
+  Offset<String> CreateSharedString(const String *str) {
+    return CreateSharedString(str->c_str(), str->Length());
+  }
+
   uoffset_t EndVector(size_t len) {
     return PushElement(static_cast<uoffset_t>(len));
   }
@@ -859,9 +1658,7 @@ class FlatBufferBuilder FLATBUFFERS_FINAL_CLASS {
   template<typename T> Offset<Vector<T> > CreateVector(const T *v, size_t len) {
     NotNested();
     StartVector(len, sizeof(T));
-    for (size_t i = len; i > 0; ) {
-      PushElement(v[--i]);
-    }
+    PushElements(v, len, std::tr1::is_scalar<T>());
     return Offset<Vector<T> >(EndVector(len));
   }
 
@@ -883,6 +1680,19 @@ class FlatBufferBuilder FLATBUFFERS_FINAL_CLASS {
   }
   
 private:
+  // Below this, sorting the offsets directly is faster than extracting keys.
+  static const size_t kMinKeySortLength = 64;
+
+  // The offset (like GetSize()) of a field of a table, or 0 if it is not set.
+  uoffset_t FieldOffsetAt(uoffset_t table, voffset_t field) const {
+    const uint8_t *table_ptr = buf_.data_at(table);
+    const uint8_t *vtable_ptr =
+      buf_.data_at(table + ReadScalar<soffset_t>(table_ptr));
+    voffset_t field_voffset = field < ReadScalar<voffset_t>(vtable_ptr)
+      ? ReadScalar<voffset_t>(vtable_ptr + field) : 0;
+    return field_voffset ? table - field_voffset : 0;
+  }
+
    template <typename T>
    struct LessOffset
     {
@@ -898,10 +1708,58 @@ private:
         FlatBufferBuilder* mBuilder;
     };
     
+  template<typename T> void SortTables(Offset<T> *v, size_t len,
+                                       std::tr1::false_type /*by_key*/) {
+    // Comparing tables needs them to be contiguous.
+    buf_.flatten();
+    std::sort(v, v + len, LessOffset<T>(this));
+  }
+
+  template<typename T> void SortTables(Offset<T> *v, size_t len,
+                                       std::tr1::true_type /*by_key*/) {
+    // Rather than going through the vtables of two tables for every
+    // comparison, read each key once, and sort by its KeyIndexValue().
+    std::vector<KeyedOffset> keyed(len);
+    for (size_t i = 0; i < len; i++) {
+      keyed[i].key = T::KeyIndexValueAt(*this, v[i].o);
+      keyed[i].o = v[i].o;
+    }
+    RadixSortByKey(keyed);
+    for (size_t i = 0; i < len; i++) v[i] = Offset<T>(keyed[i].o);
+    if (!T::KeyIndexIsExact()) {
+      // Only string prefixes were compared, so tables with the same
+      // prefix still need sorting among themselves.
+      for (size_t i = 0, j; i < len; i = j) {
+        for (j = i + 1; j < len && keyed[j].key == keyed[i].key; j++) {}
+        if (j - i > 1) {
+          buf_.flatten();
+          std::sort(v + i, v + j, LessOffset<T>(this));
+        }
+      }
+    }
+  }
+
+  template<typename T> uint64_t KeyIndexValueOf(Offset<T> table,
+                                                std::tr1::true_type) {
+    return T::KeyIndexValueAt(*this, table.o);
+  }
+
+  template<typename T> uint64_t KeyIndexValueOf(Offset<T> table,
+                                                std::tr1::false_type) {
+    // The table's accessors need it to be contiguous.
+    buf_.flatten();
+    return reinterpret_cast<T *>(buf_.data_at(table.o))->KeyIndexValue();
+  }
+
 public:
   template<typename T> Offset<Vector<Offset<T> > > CreateVectorOfSortedTables(
                                                      Offset<T> *v, size_t len) {
-      std::sort(v, v + len, LessOffset<T>(this));
+      if (len < kMinKeySortLength) {
+        SortTables(v, len, std::tr1::false_type());
+      } else {
+        SortTables(v, len, std::tr1::integral_constant<bool,
+                             HasKeyIndexValueAt<T>::value>());
+      }
       return CreateVector(v, len);
   }
 
@@ -910,6 +1768,24 @@ public:
     return CreateVectorOfSortedTables(v->data(), v->size());
   }
 
+  // Creates a key index for a vector of tables created with
+  // CreateVectorOfSortedTables() from v (which that sorted), for fields with
+  // the key_index attribute. See LookupByKeyIndex().
+  template<typename T> Offset<Vector<uint64_t> > CreateKeyIndex(
+                                               const Offset<T> *v, size_t len) {
+    std::vector<uint64_t> keys(len);
+    for (size_t i = 0; i < len; i++) {
+      keys[i] = KeyIndexValueOf(v[i], std::tr1::integral_constant<bool,
+                                        HasKeyIndexValueAt<T>::value>());
+    }
+    return CreateVector(keys);
+  }
+
+  template<typename T> Offset<Vector<uint64_t> > CreateKeyIndex(
+                                        const std::vector<Offset<T> > &v) {
+    return CreateKeyIndex(v.data(), v.size());
+  }
+
   // Specialized version for non-copying use cases. Write the data any time
   // later to the returned buffer pointer `buf`.
   uoffset_t CreateUninitializedVector(size_t len, size_t elemsize,
@@ -926,6 +1802,50 @@ public:
                                      reinterpret_cast<uint8_t **>(buf));
   }
 
+  // Copies everything built in "child" so far into this builder, in a
+  // single copy. This way subtrees, such as the elements of a large vector
+  // of tables, can be built by separate builders on separate threads, and
+  // then be combined. All offsets within a buffer are relative, so nothing
+  // in the copy needs rewriting: to refer to something built in child, pass
+  // its offset to Relocate() with the value returned here.
+  // The vtables and shared strings of child are remembered too, so what is
+  // built later in this builder can share them. child must not have been
+  // finished, and is left as is (except that it is flattened).
+  uoffset_t Splice(FlatBufferBuilder &child) {
+    NotNested();
+    child.NotNested();
+    child.buf_.flatten();
+    size_t size = child.GetSize();
+    // Keep the copy in one piece with chunked storage, for the vtable and
+    // string comparisons below.
+    buf_.make_contiguous(size + child.minalign_);
+    Align(child.minalign_);
+    uoffset_t base = GetSize();
+    buf_.push(child.buf_.data(), size);
+    for (std::vector<uoffset_t>::const_iterator it = child.vtables_.begin();
+         it != child.vtables_.end(); ++it) {
+      if (!*it || (max_vtables_ && num_vtables_ >= max_vtables_)) continue;
+      const voffset_t *vt = reinterpret_cast<const voffset_t *>(
+                              buf_.data_at(base + *it));
+      uoffset_t *slot = FindVTable(vt, ReadScalar<voffset_t>(vt));
+      if (*slot) continue;
+      *slot = base + *it;
+      if (++num_vtables_ * 2 > vtables_.size()) GrowVTables();
+    }
+    for (StringOffsetMap::const_iterator it = child.string_pool_.begin();
+         it != child.string_pool_.end(); ++it) {
+      string_pool_.insert(Offset<String>(base + it->o));
+    }
+    return base;
+  }
+
+  // Turns an offset into a builder spliced into this one into an offset
+  // into this builder, see Splice().
+  template<typename T> static Offset<T> Relocate(Offset<T> off,
+                                                 uoffset_t base) {
+    return Offset<T>(off.o ? off.o + base : 0);
+  }
+
   static const size_t kFileIdentifierLength = 4;
 
   // Finish serializing a buffer by writing the root offset.
@@ -954,18 +1874,149 @@ public:
     voffset_t id;
   };
 
-  simple_allocator default_allocator;
+  // Used by CreateVector: vectors of scalars are written as a single block
+  // (byte-swapped on big endian machines), other vectors (i.e. of offsets)
+  // need to be written an element at a time.
+  template<typename T> void PushElements(const T *v, size_t len,
+                                         std::tr1::true_type /*is_scalar*/) {
+    if (!len) return;
+    // StartVector() already aligned, this just tracks minalign_.
+    Align(sizeof(T));
+    #if FLATBUFFERS_LITTLEENDIAN
+      PushBytes(reinterpret_cast<const uint8_t *>(v), len * sizeof(T));
+    #else
+      T *dest = reinterpret_cast<T *>(buf_.make_space(len * sizeof(T)));
+      for (size_t i = 0; i < len; i++) WriteScalar(dest + i, v[i]);
+    #endif
+  }
+
+  template<typename T> void PushElements(const T *v, size_t len,
+                                         std::tr1::false_type /*is_scalar*/) {
+    for (size_t i = len; i > 0; ) {
+      PushElement(v[--i]);
+    }
+  }
+
+  // Orders strings already in the buffer by their contents.
+  struct StringOffsetCompare {
+    explicit StringOffsetCompare(const vector_downward &buf) : buf_(&buf) {}
+    bool operator()(const Offset<String> &a, const Offset<String> &b) const {
+      const String *stra = reinterpret_cast<const String *>(buf_->data_at(a.o));
+      const String *strb = reinterpret_cast<const String *>(buf_->data_at(b.o));
+      uoffset_t lena = stra->Length(), lenb = strb->Length();
+      int cmp = memcmp(stra->c_str(), strb->c_str(), std::min(lena, lenb));
+      return cmp < 0 || (cmp == 0 && lena < lenb);
+    }
+   private:
+    const vector_downward *buf_;
+  };
+  typedef std::set<Offset<String>, StringOffsetCompare> StringOffsetMap;
+
+  static size_t HashVTable(const voffset_t *vt, voffset_t vt_size) {
+    // FNV-1a over the bytes of the vtable.
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(vt);
+    uint32_t hash = 2166136261u;
+    for (voffset_t i = 0; i < vt_size; i++) {
+      hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+  }
+
+  // Called with the vtable of the table at vtableoffsetloc just written in
+  // front of it (at the start of buf_). See if we already have generated a
+  // vtable with this exact same layout before. If so, make the table point
+  // to the old one, and remove this one. Sets *remembered to whether later
+  // tables may share the vtable used, and returns its offset.
+  uoffset_t ShareVTable(uoffset_t vtableoffsetloc, bool *remembered) {
+    voffset_t* vt1 = reinterpret_cast<voffset_t *>(buf_.data());
+    voffset_t vt1_size = ReadScalar<voffset_t>(vt1);
+    uoffset_t vt_use = GetSize();
+    uoffset_t *slot = FindVTable(vt1, vt1_size);
+    *remembered = true;
+    if (*slot) {
+      vt_use = *slot;
+      buf_.pop(GetSize() - vtableoffsetloc);
+      FLATBUFFERS_STAT(stats_.vtables_reused++);
+    } else {
+      FLATBUFFERS_STAT(stats_.vtables_created++);
+      if (!max_vtables_ || num_vtables_ < max_vtables_) {
+        // This is a new vtable, remember it.
+        *slot = vt_use;
+        if (++num_vtables_ * 2 > vtables_.size()) GrowVTables();
+      } else {
+        *remembered = false;
+      }
+    }
+    // Fill the vtable offset at the start of the table.
+    // The offset points from the beginning of the object to where the
+    // vtable is stored.
+    // Offsets default direction is downward in memory for future format
+    // flexibility (storing all vtables at the start of the file).
+    WriteScalar(buf_.data_at(vtableoffsetloc),
+                static_cast<soffset_t>(vt_use) -
+                  static_cast<soffset_t>(vtableoffsetloc));
+    return vt_use;
+  }
+
+  // Returns the slot in vtables_ holding a vtable identical to "vt", or the
+  // empty slot where it should be inserted if there is none.
+  uoffset_t *FindVTable(const voffset_t *vt, voffset_t vt_size) {
+    size_t mask = vtables_.size() - 1;
+    for (size_t i = HashVTable(vt, vt_size) & mask; ; i = (i + 1) & mask) {
+      uoffset_t *slot = &vtables_[i];
+      if (!*slot) return slot;
+      const voffset_t *vt2 =
+        reinterpret_cast<const voffset_t *>(buf_.data_at(*slot));
+      if (ReadScalar<voffset_t>(vt2) == vt_size && !memcmp(vt2, vt, vt_size))
+        return slot;
+    }
+  }
+
+  // Doubles the size of vtables_, re-inserting all vtables recorded so far.
+  void GrowVTables() {
+    std::vector<uoffset_t> old_vtables(vtables_.size() * 2, 0);
+    old_vtables.swap(vtables_);
+    for (std::vector<uoffset_t>::const_iterator it = old_vtables.begin();
+         it != old_vtables.end(); ++it) {
+      if (!*it) continue;
+      const voffset_t *vt = reinterpret_cast<const voffset_t *>(
+                              buf_.data_at(*it));
+      *FindVTable(vt, ReadScalar<voffset_t>(vt)) = *it;
+    }
+  }
+
+  // Shared by all builders, since buffers released from a builder refer to
+  // the allocator that needs to free them, and may outlive the builder.
+  static const simple_allocator &DefaultAllocator() {
+    static simple_allocator allocator;
+    return allocator;
+  }
 
   vector_downward buf_;
 
   // Accumulating offsets of table members while it is being built.
   std::vector<FieldLoc> offsetbuf_;
 
-  std::vector<uoffset_t> vtables_;  // todo: Could make this into a map?
+  // Strings created with CreateSharedString.
+  StringOffsetMap string_pool_;
+
+  // Offsets of the vtables written so far, so tables with the same layout
+  // can share one. This is an open addressing hash table keyed on the
+  // vtable contents, with 0 marking an empty slot (no vtable can be at
+  // offset 0). Its size is always a power of 2, kept at most half full.
+  std::vector<uoffset_t> vtables_;
+  size_t num_vtables_;
+  size_t max_vtables_;
+
+  // The vtable last passed to EndFixedTable(), and its offset.
+  const voffset_t *fixed_vtable_;
+  uoffset_t fixed_vtable_offset_;
 
   size_t minalign_;
 
   bool force_defaults_;  // Serialize values equal to their defaults anyway.
+
+  BuilderStats stats_;
 };
 
 // Helpers to get a typed pointer to the root object contained in the buffer.
@@ -985,15 +2036,100 @@ inline bool BufferHasIdentifier(const void *buf, const char *identifier) {
                  identifier, FlatBufferBuilder::kFileIdentifierLength) == 0;
 }
 
+// Interface to a thread pool (or anything else that can run tasks in
+// parallel), used by Verifier for parallel verification.
+class TaskRunner {
+ public:
+  virtual ~TaskRunner() {}
+  // Call task(context, i) for every i in [0, count), in any order and on any
+  // thread, and return once all of them have returned.
+  virtual void Run(size_t count, void (*task)(void *context, size_t index),
+                   void *context) = 0;
+};
+
+// One range of tables for CreateVectorOfTablesInParallel().
+template<typename T> struct BuildTablesTask {
+  static void Run(void *tasks, size_t index) {
+    BuildTablesTask &task = static_cast<BuildTablesTask *>(tasks)[index];
+    for (size_t i = task.begin; i < task.end; i++) {
+      task.offsets.push_back(task.build(*task.builder, i, task.context));
+    }
+  }
+
+  Offset<T> (*build)(FlatBufferBuilder &fbb, size_t i, void *context);
+  void *context;
+  FlatBufferBuilder *builder;
+  size_t begin, end;
+  std::vector<Offset<T> > offsets;
+};
+
+// Builds a vector of "count" tables in parallel using "runner": the tables
+// are split into num_tasks ranges, and the tables of each range are built
+// with build(builder, i, context) in a builder of their own. These are then
+// spliced into fbb in order (see FlatBufferBuilder::Splice()). The result
+// only depends on num_tasks, not on the order in which tasks run.
+template<typename T> Offset<Vector<Offset<T> > > CreateVectorOfTablesInParallel(
+    FlatBufferBuilder &fbb, size_t count,
+    Offset<T> (*build)(FlatBufferBuilder &fbb, size_t i, void *context),
+    void *context, TaskRunner *runner, size_t num_tasks) {
+  typedef BuildTablesTask<T> Task;
+  if (!num_tasks) num_tasks = 1;
+  if (num_tasks > count) num_tasks = count ? count : 1;
+  std::vector<Task> tasks(num_tasks);
+  for (size_t t = 0; t < num_tasks; t++) {
+    tasks[t].build = build;
+    tasks[t].context = context;
+    tasks[t].builder = new FlatBufferBuilder();
+    tasks[t].begin = count * t / num_tasks;
+    tasks[t].end = count * (t + 1) / num_tasks;
+  }
+  runner->Run(num_tasks, Task::Run, &tasks[0]);
+  std::vector<Offset<T> > offsets;
+  offsets.reserve(count);
+  for (size_t t = 0; t < num_tasks; t++) {
+    uoffset_t base = fbb.Splice(*tasks[t].builder);
+    delete tasks[t].builder;
+    for (size_t i = 0; i < tasks[t].offsets.size(); i++) {
+      offsets.push_back(FlatBufferBuilder::Relocate(tasks[t].offsets[i],
+                                                    base));
+    }
+  }
+  return fbb.CreateVector(offsets);
+}
+
 // Helper class to verify the integrity of a FlatBuffer
+// What a Verifier checked, see Verifier::GetStats(). Only counted with
+// FLATBUFFERS_STATS.
+struct VerifierStats {
+  VerifierStats() : tables(0), vectors(0), bytes(0), max_depth(0) {}
+
+  size_t tables;
+  size_t vectors;    // Including strings.
+  size_t bytes;      // Of all ranges checked (tables, fields and vectors).
+  size_t max_depth;  // Of nested tables.
+};
+
 class Verifier FLATBUFFERS_FINAL_CLASS {
  public:
   Verifier(const uint8_t *buf, size_t buf_len, size_t _max_depth = 64,
            size_t _max_tables = 1000000)
     : buf_(buf), end_(buf + buf_len), depth_(0), max_depth_(_max_depth),
-      num_tables_(0), max_tables_(_max_tables)
+      num_tables_(0), max_tables_(_max_tables), runner_(NULL),
+      tables_per_task_(0)
     {}
 
+  // Verify large vectors of tables in parallel using "runner": every vector
+  // this verifier encounters that holds at least 2 * tables_per_task tables
+  // is split into tasks of tables_per_task tables each, which are verified
+  // with a separate Verifier each (so vectors inside those tables are
+  // verified without further parallelism).
+  // Their table counts are added up afterwards, so the limits set in the
+  // constructor apply to the buffer as a whole, just like without runner.
+  void SetTaskRunner(TaskRunner *runner, size_t tables_per_task = 1024) {
+    runner_ = runner;
+    tables_per_task_ = tables_per_task ? tables_per_task : 1;
+  }
+
   // Central location where any verification failures register.
   bool Check(bool ok) const {
     #ifdef FLATBUFFERS_DEBUG_VERIFICATION_FAILURE
@@ -1004,6 +2140,7 @@ class Verifier FLATBUFFERS_FINAL_CLASS {
 
   // Verify any range within the buffer.
   bool Verify(const void *elem, size_t elem_len) const {
+    FLATBUFFERS_STAT(stats_.bytes += elem_len);
     return Check(elem >= buf_ && elem <= end_ - elem_len);
   }
 
@@ -1025,6 +2162,31 @@ class Verifier FLATBUFFERS_FINAL_CLASS {
                         &end);
   }
 
+  // Verify a pointer (may be NULL) to a vector with a 64bit size, see
+  // Table::VerifyOffset64() for the field referring to it.
+  template<typename T> bool Verify(const Vector64<T> *vec) const {
+    return !vec ||
+           VerifyVector64(reinterpret_cast<const uint8_t *>(vec), sizeof(T));
+  }
+
+  // Common code between vectors of different element types.
+  bool VerifyVector64(const uint8_t *vec, size_t elem_size) const {
+    FLATBUFFERS_STAT(stats_.vectors++);
+    if (!Verify<uoffset64_t>(vec)) return false;
+    // Divide rather than multiply, which could overflow.
+    uoffset64_t size = ReadScalar<uoffset64_t>(vec);
+    size_t room = static_cast<size_t>(end_ - vec) - sizeof(uoffset64_t);
+    if (!Check(size <= room / elem_size)) return false;
+    FLATBUFFERS_STAT(stats_.bytes += static_cast<size_t>(size) * elem_size);
+    return true;
+  }
+
+  // Check a 64bit offset at p stays inside the buffer.
+  bool VerifyOffset64(const uint8_t *p) const {
+    return Check(ReadScalar<uoffset64_t>(p) <
+                 static_cast<uoffset64_t>(end_ - p));
+  }
+
   // Verify a pointer (may be NULL) to string.
   bool Verify(const String *str) const {
     const uint8_t *end;
@@ -1037,6 +2199,7 @@ class Verifier FLATBUFFERS_FINAL_CLASS {
   // Common code between vectors and strings.
   bool VerifyVector(const uint8_t *vec, size_t elem_size,
                     const uint8_t **end) const {
+    FLATBUFFERS_STAT(stats_.vectors++);
     // Check we can read the size field.
     if (!Verify<uoffset_t>(vec)) return false;
     // Check the whole array. If this is a string, the byte past the array
@@ -1060,6 +2223,8 @@ class Verifier FLATBUFFERS_FINAL_CLASS {
   // Special case for table contents, after the above has been called.
   template<typename T> bool VerifyVectorOfTables(const Vector<Offset<T> > *vec) {
     if (vec) {
+      if (runner_ && vec->size() >= 2 * tables_per_task_)
+        return VerifyVectorOfTablesInParallel(vec);
       for (uoffset_t i = 0; i < vec->size(); i++) {
         if (!vec->Get(i)->Verify(*this)) return false;
       }
@@ -1075,6 +2240,50 @@ class Verifier FLATBUFFERS_FINAL_CLASS {
         Verify(*this);
   }
 
+  // Lazy verification, for code generated with --gen-lazy-verify: rather
+  // than checking the whole buffer up front, each table is checked by
+  // T::VerifyShallow (its own fields, strings and vectors, but not the
+  // tables it refers to) the first time it is accessed through here.
+  // Tables that passed are remembered along with their type (a buffer may
+  // refer to the same table as different types), so accessing them again
+  // as the same type is cheap.
+  // Returns the table, or NULL if it is NULL or failed verification.
+  template<typename T> const T *VerifyTableLazily(const T *table) {
+    if (!table) return NULL;
+    VerifiedTable key(table, TypeTag<T>());
+    if (verified_.find(key) != verified_.end()) return table;
+    if (!table->VerifyShallow(*this)) return NULL;
+    verified_.insert(key);
+    return table;
+  }
+
+  // Lazily verify element i of a vector of tables (which itself must have
+  // been reached through lazy verification), NULL if out of range or bad.
+  template<typename T> const T *VerifyTableLazily(
+                                  const Vector<Offset<T> > *vec, uoffset_t i) {
+    return vec && Check(i < vec->size()) ? VerifyTableLazily(vec->Get(i))
+                                         : NULL;
+  }
+
+  // Lazily verify the root table of type T, NULL on failure.
+  template<typename T> const T *VerifyRootLazily() {
+    if (!Verify<uoffset_t>(buf_)) return NULL;
+    return VerifyTableLazily(
+             reinterpret_cast<const T *>(buf_ + ReadScalar<uoffset_t>(buf_)));
+  }
+
+  // Number of distinct tables (and types they were accessed as) verified so
+  // far by VerifyTableLazily.
+  size_t GetNumLazilyVerified() const { return verified_.size(); }
+
+  // Counters of everything verified so far, including by parallel tasks.
+  // All zero unless compiled with FLATBUFFERS_STATS.
+  VerifierStats GetStats() const {
+    VerifierStats stats = stats_;
+    FLATBUFFERS_STAT(stats.tables = num_tables_);
+    return stats;
+  }
+
   // Called at the start of a table to increase counters measuring data
   // structure depth and amount, and possibly bails out with false if
   // limits set by the constructor have been hit. Needs to be balanced
@@ -1082,6 +2291,7 @@ class Verifier FLATBUFFERS_FINAL_CLASS {
   bool VerifyComplexity() {
     depth_++;
     num_tables_++;
+    FLATBUFFERS_STAT(stats_.max_depth = std::max(stats_.max_depth, depth_));
     return Check(depth_ <= max_depth_ && num_tables_ <= max_tables_);
   }
 
@@ -1092,14 +2302,111 @@ class Verifier FLATBUFFERS_FINAL_CLASS {
   }
 
  private:
+  // A distinct address for each type T, without needing RTTI.
+  template<typename T> static const void *TypeTag() {
+    static const char tag = 0;
+    return &tag;
+  }
+
+  // One task verifies tables [index * per_task, (index + 1) * per_task).
+  template<typename T> struct VectorOfTablesTask {
+    const Verifier *parent;
+    const Vector<Offset<T> > *vec;
+    std::vector<size_t> num_tables;
+    std::vector<uint8_t> ok;
+    std::vector<VerifierStats> stats;
+
+    static void Verify(void *context, size_t index) {
+      VectorOfTablesTask &task = *reinterpret_cast<VectorOfTablesTask *>(
+                                   context);
+      const Verifier &parent = *task.parent;
+      Verifier verifier(parent.buf_, parent.end_ - parent.buf_,
+                        parent.max_depth_,
+                        parent.max_tables_ - parent.num_tables_);
+      verifier.depth_ = parent.depth_;
+      size_t begin = index * parent.tables_per_task_;
+      size_t end = std::min<size_t>(task.vec->size(),
+                                    begin + parent.tables_per_task_);
+      bool ok = true;
+      for (size_t i = begin; ok && i < end; i++) {
+        ok = task.vec->Get(static_cast<uoffset_t>(i))->Verify(verifier);
+      }
+      task.ok[index] = ok;
+      task.num_tables[index] = verifier.num_tables_;
+      FLATBUFFERS_STAT(task.stats[index] = verifier.stats_);
+    }
+  };
+
+  template<typename T> bool VerifyVectorOfTablesInParallel(
+                                           const Vector<Offset<T> > *vec) {
+    size_t num_tasks = (vec->size() + tables_per_task_ - 1) / tables_per_task_;
+    VectorOfTablesTask<T> task;
+    task.parent = this;
+    task.vec = vec;
+    task.num_tables.resize(num_tasks, 0);
+    task.ok.resize(num_tasks, 0);
+    FLATBUFFERS_STAT(task.stats.resize(num_tasks));
+    runner_->Run(num_tasks, &VectorOfTablesTask<T>::Verify, &task);
+    // Merge the results.
+    bool ok = true;
+    for (size_t i = 0; i < num_tasks; i++) {
+      ok = ok && task.ok[i];
+      num_tables_ += task.num_tables[i];
+      #ifdef FLATBUFFERS_STATS
+        stats_.vectors += task.stats[i].vectors;
+        stats_.bytes += task.stats[i].bytes;
+        stats_.max_depth = std::max(stats_.max_depth, task.stats[i].max_depth);
+      #endif
+    }
+    return ok && Check(num_tables_ <= max_tables_);
+  }
+
   const uint8_t *buf_;
   const uint8_t *end_;
   size_t depth_;
   size_t max_depth_;
   size_t num_tables_;
   size_t max_tables_;
+  TaskRunner *runner_;
+  size_t tables_per_task_;
+  // A table verified lazily, and the TypeTag of the type it was verified as.
+  typedef std::pair<const void *, const void *> VerifiedTable;
+  std::set<VerifiedTable> verified_;
+  mutable VerifierStats stats_;
 };
 
+// Used by VerifyBuffers() below.
+template<typename T> struct VerifyBuffersTask {
+  const uint8_t *const *bufs;
+  const size_t *lens;
+  bool *results;
+  size_t max_depth;
+  size_t max_tables;
+
+  static void Verify(void *context, size_t index) {
+    VerifyBuffersTask &task = *reinterpret_cast<VerifyBuffersTask *>(context);
+    Verifier verifier(task.bufs[index], task.lens[index], task.max_depth,
+                      task.max_tables);
+    task.results[index] = verifier.VerifyBuffer<T>();
+  }
+};
+
+// Verify "count" independent buffers with root type T in parallel using
+// "runner", storing whether bufs[i] (of length lens[i]) is ok in results[i].
+// Returns true if all of them are ok.
+template<typename T> bool VerifyBuffers(const uint8_t *const *bufs,
+                                        const size_t *lens, size_t count,
+                                        bool *results, TaskRunner *runner,
+                                        size_t max_depth = 64,
+                                        size_t max_tables = 1000000) {
+  VerifyBuffersTask<T> task = { bufs, lens, results, max_depth, max_tables };
+  runner->Run(count, &VerifyBuffersTask<T>::Verify, &task);
+  for (size_t i = 0; i < count; i++) {
+    if (!results[i]) return false;
+  }
+  return true;
+}
+
 // "structs" are flat structures that do not have an offset table, thus
 // always have all members present and do not support forwards/backwards
 // compatible extensions.
@@ -1158,6 +2465,19 @@ class Table {
     return const_cast<Table *>(this)->GetPointer<P>(field);
   }
 
+  // For fields with the offset64 attribute.
+  template<typename P> P GetPointer64(voffset_t field) {
+    voffset_t field_offset = GetOptionalFieldOffset(field);
+    uint8_t* p = data_ + field_offset;
+    return field_offset
+      ? reinterpret_cast<P>(p + static_cast<size_t>(
+                                  ReadScalar<uoffset64_t>(p)))
+      : NULL;
+  }
+  template<typename P> P GetPointer64(voffset_t field) const {
+    return const_cast<Table *>(this)->GetPointer64<P>(field);
+  }
+
   template<typename P> P GetStruct(voffset_t field) const {
     voffset_t field_offset = GetOptionalFieldOffset(field);
     uint8_t* p = const_cast<uint8_t *>(data_ + field_offset);
@@ -1222,6 +2542,16 @@ class Table {
            verifier.Verify<T>(data_ + field_offset);
   }
 
+  // VerifyField for fields with the offset64 attribute, which also checks
+  // the offset points inside the buffer before it is added to a pointer.
+  bool VerifyOffset64(const Verifier &verifier, voffset_t field,
+                      bool required = false) const {
+    voffset_t field_offset = GetOptionalFieldOffset(field);
+    if (!field_offset) return verifier.Check(!required);
+    return verifier.Verify<uoffset64_t>(data_ + field_offset) &&
+           verifier.VerifyOffset64(data_ + field_offset);
+  }
+
  private:
   // private constructor & copy constructor: you obtain instances of this
   // class by pointing to existing data only
@@ -20,6 +20,16 @@
 #include <stdint.h>
 #include <cstring>
 
+// Functions marked with this can be evaluated at compile time, e.g. to turn
+// the hash of a string literal into a constant.
+#ifndef FLATBUFFERS_CONSTEXPR
+  #if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900)
+    #define FLATBUFFERS_CONSTEXPR constexpr
+  #else
+    #define FLATBUFFERS_CONSTEXPR
+  #endif
+#endif
+
 namespace flatbuffers {
 
 template <typename T>
@@ -60,22 +70,306 @@ T HashFnv1a(const char *input) {
   return hash;
 }
 
+// xxHash (XXH32 and XXH64), which reads 4 or 8 bytes at a time. The
+// functions below are the building blocks of both the runtime and the
+// compile time versions.
+const uint32_t kXXH32Prime1 = 2654435761U;
+const uint32_t kXXH32Prime2 = 2246822519U;
+const uint32_t kXXH32Prime3 = 3266489917U;
+const uint32_t kXXH32Prime4 = 668265263U;
+const uint32_t kXXH32Prime5 = 374761393U;
+
+const uint64_t kXXH64Prime1 = 11400714785074694791ULL;
+const uint64_t kXXH64Prime2 = 14029467366897019727ULL;
+const uint64_t kXXH64Prime3 = 1609587929392839161ULL;
+const uint64_t kXXH64Prime4 = 9650029242287828579ULL;
+const uint64_t kXXH64Prime5 = 2870177450012600261ULL;
+
+inline FLATBUFFERS_CONSTEXPR uint32_t XXH32Rotl(uint32_t x, int r) {
+  return (x << r) | (x >> (32 - r));
+}
+
+inline FLATBUFFERS_CONSTEXPR uint64_t XXH64Rotl(uint64_t x, int r) {
+  return (x << r) | (x >> (64 - r));
+}
+
+inline FLATBUFFERS_CONSTEXPR uint32_t XXHByte(const char *p) {
+  return static_cast<unsigned char>(*p);
+}
+
+// Little endian reads. Compilers turn these into a single load.
+inline FLATBUFFERS_CONSTEXPR uint32_t XXHRead32(const char *p) {
+  return XXHByte(p) | XXHByte(p + 1) << 8 | XXHByte(p + 2) << 16 |
+         XXHByte(p + 3) << 24;
+}
+
+inline FLATBUFFERS_CONSTEXPR uint64_t XXHRead64(const char *p) {
+  return XXHRead32(p) | static_cast<uint64_t>(XXHRead32(p + 4)) << 32;
+}
+
+inline FLATBUFFERS_CONSTEXPR uint32_t XXH32Round(uint32_t acc, uint32_t in) {
+  return XXH32Rotl(acc + in * kXXH32Prime2, 13) * kXXH32Prime1;
+}
+
+inline FLATBUFFERS_CONSTEXPR uint32_t XXH32Converge(uint32_t v1, uint32_t v2,
+                                                    uint32_t v3, uint32_t v4) {
+  return XXH32Rotl(v1, 1) + XXH32Rotl(v2, 7) + XXH32Rotl(v3, 12) +
+         XXH32Rotl(v4, 18);
+}
+
+inline FLATBUFFERS_CONSTEXPR uint32_t XXH32Tail4(uint32_t h, const char *p) {
+  return XXH32Rotl(h + XXHRead32(p) * kXXH32Prime3, 17) * kXXH32Prime4;
+}
+
+inline FLATBUFFERS_CONSTEXPR uint32_t XXH32Tail1(uint32_t h, const char *p) {
+  return XXH32Rotl(h + XXHByte(p) * kXXH32Prime5, 11) * kXXH32Prime1;
+}
+
+inline FLATBUFFERS_CONSTEXPR uint32_t XXH32Avalanche3(uint32_t h) {
+  return h ^ (h >> 16);
+}
+
+inline FLATBUFFERS_CONSTEXPR uint32_t XXH32Avalanche2(uint32_t h) {
+  return XXH32Avalanche3((h ^ (h >> 13)) * kXXH32Prime3);
+}
+
+inline FLATBUFFERS_CONSTEXPR uint32_t XXH32Avalanche(uint32_t h) {
+  return XXH32Avalanche2((h ^ (h >> 15)) * kXXH32Prime2);
+}
+
+inline FLATBUFFERS_CONSTEXPR uint64_t XXH64Round(uint64_t acc, uint64_t in) {
+  return XXH64Rotl(acc + in * kXXH64Prime2, 31) * kXXH64Prime1;
+}
+
+inline FLATBUFFERS_CONSTEXPR uint64_t XXH64Merge(uint64_t h, uint64_t v) {
+  return (h ^ XXH64Round(0, v)) * kXXH64Prime1 + kXXH64Prime4;
+}
+
+inline FLATBUFFERS_CONSTEXPR uint64_t XXH64Converge(uint64_t v1, uint64_t v2,
+                                                    uint64_t v3, uint64_t v4) {
+  return XXH64Merge(XXH64Merge(XXH64Merge(XXH64Merge(
+           XXH64Rotl(v1, 1) + XXH64Rotl(v2, 7) + XXH64Rotl(v3, 12) +
+           XXH64Rotl(v4, 18), v1), v2), v3), v4);
+}
+
+inline FLATBUFFERS_CONSTEXPR uint64_t XXH64Tail8(uint64_t h, const char *p) {
+  return XXH64Rotl(h ^ XXH64Round(0, XXHRead64(p)), 27) * kXXH64Prime1 +
+         kXXH64Prime4;
+}
+
+inline FLATBUFFERS_CONSTEXPR uint64_t XXH64Tail4(uint64_t h, const char *p) {
+  return XXH64Rotl(h ^ (XXHRead32(p) * kXXH64Prime1), 23) * kXXH64Prime2 +
+         kXXH64Prime3;
+}
+
+inline FLATBUFFERS_CONSTEXPR uint64_t XXH64Tail1(uint64_t h, const char *p) {
+  return XXH64Rotl(h ^ (XXHByte(p) * kXXH64Prime5), 11) * kXXH64Prime1;
+}
+
+inline FLATBUFFERS_CONSTEXPR uint64_t XXH64Avalanche3(uint64_t h) {
+  return h ^ (h >> 32);
+}
+
+inline FLATBUFFERS_CONSTEXPR uint64_t XXH64Avalanche2(uint64_t h) {
+  return XXH64Avalanche3((h ^ (h >> 29)) * kXXH64Prime3);
+}
+
+inline FLATBUFFERS_CONSTEXPR uint64_t XXH64Avalanche(uint64_t h) {
+  return XXH64Avalanche2((h ^ (h >> 33)) * kXXH64Prime2);
+}
+
+inline uint32_t HashXXH32(const char *data, size_t len, uint32_t seed) {
+  const char *p = data;
+  const char *end = data + len;
+  uint32_t h;
+  if (len >= 16) {
+    uint32_t v1 = seed + kXXH32Prime1 + kXXH32Prime2;
+    uint32_t v2 = seed + kXXH32Prime2;
+    uint32_t v3 = seed;
+    uint32_t v4 = seed - kXXH32Prime1;
+    for (; p + 16 <= end; p += 16) {
+      v1 = XXH32Round(v1, XXHRead32(p));
+      v2 = XXH32Round(v2, XXHRead32(p + 4));
+      v3 = XXH32Round(v3, XXHRead32(p + 8));
+      v4 = XXH32Round(v4, XXHRead32(p + 12));
+    }
+    h = XXH32Converge(v1, v2, v3, v4);
+  } else {
+    h = seed + kXXH32Prime5;
+  }
+  h += static_cast<uint32_t>(len);
+  for (; p + 4 <= end; p += 4) h = XXH32Tail4(h, p);
+  for (; p < end; p++) h = XXH32Tail1(h, p);
+  return XXH32Avalanche(h);
+}
+
+inline uint64_t HashXXH64(const char *data, size_t len, uint64_t seed) {
+  const char *p = data;
+  const char *end = data + len;
+  uint64_t h;
+  if (len >= 32) {
+    uint64_t v1 = seed + kXXH64Prime1 + kXXH64Prime2;
+    uint64_t v2 = seed + kXXH64Prime2;
+    uint64_t v3 = seed;
+    uint64_t v4 = seed - kXXH64Prime1;
+    for (; p + 32 <= end; p += 32) {
+      v1 = XXH64Round(v1, XXHRead64(p));
+      v2 = XXH64Round(v2, XXHRead64(p + 8));
+      v3 = XXH64Round(v3, XXHRead64(p + 16));
+      v4 = XXH64Round(v4, XXHRead64(p + 24));
+    }
+    h = XXH64Converge(v1, v2, v3, v4);
+  } else {
+    h = seed + kXXH64Prime5;
+  }
+  h += len;
+  for (; p + 8 <= end; p += 8) h = XXH64Tail8(h, p);
+  if (p + 4 <= end) {
+    h = XXH64Tail4(h, p);
+    p += 4;
+  }
+  for (; p < end; p++) h = XXH64Tail1(h, p);
+  return XXH64Avalanche(h);
+}
+
+inline uint32_t HashXXH32(const char *input) {
+  return HashXXH32(input, std::strlen(input), 0);
+}
+
+inline uint64_t HashXXH64(const char *input) {
+  return HashXXH64(input, std::strlen(input), 0);
+}
+
+// Compile time versions of the hash functions above, for string literals
+// (with a C++11 compiler). They give the same results as the runtime ones,
+// e.g. ConstHashFnv1a<uint32_t>("foo") == HashFnv1a<uint32_t>("foo").
+// Each of these is a single return statement, so they recurse rather than
+// loop.
+template <typename T>
+FLATBUFFERS_CONSTEXPR T ConstHashFnv1Step(const char *input, T hash) {
+  return *input
+    ? ConstHashFnv1Step<T>(input + 1, static_cast<T>(
+        static_cast<T>(hash * FnvTraits<T>::kFnvPrime) ^
+        static_cast<unsigned char>(*input)))
+    : hash;
+}
+
+template <typename T>
+FLATBUFFERS_CONSTEXPR T ConstHashFnv1aStep(const char *input, T hash) {
+  return *input
+    ? ConstHashFnv1aStep<T>(input + 1, static_cast<T>(
+        static_cast<T>(hash ^ static_cast<unsigned char>(*input)) *
+        FnvTraits<T>::kFnvPrime))
+    : hash;
+}
+
+template <typename T>
+FLATBUFFERS_CONSTEXPR T ConstHashFnv1(const char *input) {
+  return ConstHashFnv1Step<T>(input, FnvTraits<T>::kOffsetBasis);
+}
+
+template <typename T>
+FLATBUFFERS_CONSTEXPR T ConstHashFnv1a(const char *input) {
+  return ConstHashFnv1aStep<T>(input, FnvTraits<T>::kOffsetBasis);
+}
+
+inline FLATBUFFERS_CONSTEXPR size_t ConstStrLen(const char *input) {
+  return *input ? 1 + ConstStrLen(input + 1) : 0;
+}
+
+inline FLATBUFFERS_CONSTEXPR uint32_t ConstXXH32Tail(const char *p,
+                                                     size_t len, uint32_t h) {
+  return len >= 4 ? ConstXXH32Tail(p + 4, len - 4, XXH32Tail4(h, p))
+       : len ? ConstXXH32Tail(p + 1, len - 1, XXH32Tail1(h, p))
+       : XXH32Avalanche(h);
+}
+
+inline FLATBUFFERS_CONSTEXPR uint32_t ConstXXH32Stripes(
+    const char *p, size_t len, uint32_t v1, uint32_t v2, uint32_t v3,
+    uint32_t v4) {
+  return len >= 16
+    ? ConstXXH32Stripes(p + 16, len - 16, XXH32Round(v1, XXHRead32(p)),
+                        XXH32Round(v2, XXHRead32(p + 4)),
+                        XXH32Round(v3, XXHRead32(p + 8)),
+                        XXH32Round(v4, XXHRead32(p + 12)))
+    : XXH32Converge(v1, v2, v3, v4);
+}
+
+inline FLATBUFFERS_CONSTEXPR uint32_t ConstHashXXH32(const char *data,
+                                                     size_t len,
+                                                     uint32_t seed) {
+  return ConstXXH32Tail(data + (len & ~static_cast<size_t>(15)), len & 15,
+                        (len >= 16
+                          ? ConstXXH32Stripes(data, len,
+                                              seed + kXXH32Prime1 +
+                                                kXXH32Prime2,
+                                              seed + kXXH32Prime2, seed,
+                                              seed - kXXH32Prime1)
+                          : seed + kXXH32Prime5) +
+                        static_cast<uint32_t>(len));
+}
+
+inline FLATBUFFERS_CONSTEXPR uint64_t ConstXXH64Tail(const char *p,
+                                                     size_t len, uint64_t h) {
+  return len >= 8 ? ConstXXH64Tail(p + 8, len - 8, XXH64Tail8(h, p))
+       : len >= 4 ? ConstXXH64Tail(p + 4, len - 4, XXH64Tail4(h, p))
+       : len ? ConstXXH64Tail(p + 1, len - 1, XXH64Tail1(h, p))
+       : XXH64Avalanche(h);
+}
+
+inline FLATBUFFERS_CONSTEXPR uint64_t ConstXXH64Stripes(
+    const char *p, size_t len, uint64_t v1, uint64_t v2, uint64_t v3,
+    uint64_t v4) {
+  return len >= 32
+    ? ConstXXH64Stripes(p + 32, len - 32, XXH64Round(v1, XXHRead64(p)),
+                        XXH64Round(v2, XXHRead64(p + 8)),
+                        XXH64Round(v3, XXHRead64(p + 16)),
+                        XXH64Round(v4, XXHRead64(p + 24)))
+    : XXH64Converge(v1, v2, v3, v4);
+}
+
+inline FLATBUFFERS_CONSTEXPR uint64_t ConstHashXXH64(const char *data,
+                                                     size_t len,
+                                                     uint64_t seed) {
+  return ConstXXH64Tail(data + (len & ~static_cast<size_t>(31)), len & 31,
+                        (len >= 32
+                          ? ConstXXH64Stripes(data, len,
+                                              seed + kXXH64Prime1 +
+                                                kXXH64Prime2,
+                                              seed + kXXH64Prime2, seed,
+                                              seed - kXXH64Prime1)
+                          : seed + kXXH64Prime5) + len);
+}
+
+inline FLATBUFFERS_CONSTEXPR uint32_t ConstHashXXH32(const char *input) {
+  return ConstHashXXH32(input, ConstStrLen(input), 0);
+}
+
+inline FLATBUFFERS_CONSTEXPR uint64_t ConstHashXXH64(const char *input) {
+  return ConstHashXXH64(input, ConstStrLen(input), 0);
+}
+
 template <typename T>
 struct NamedHashFunction {
   const char *name;
 
   typedef T (*HashFunction)(const char*);
   HashFunction function;
+
+  // The compile time version of function, as C++ source (for generated code).
+  const char *const_function;
 };
 
 const NamedHashFunction<uint32_t> kHashFunctions32[] = {
-  { "fnv1_32",  HashFnv1<uint32_t> },
-  { "fnv1a_32", HashFnv1a<uint32_t> },
+  { "fnv1_32",  HashFnv1<uint32_t>,  "flatbuffers::ConstHashFnv1<uint32_t>" },
+  { "fnv1a_32", HashFnv1a<uint32_t>, "flatbuffers::ConstHashFnv1a<uint32_t>" },
+  { "xxh32",    HashXXH32,           "flatbuffers::ConstHashXXH32" },
 };
 
 const NamedHashFunction<uint64_t> kHashFunctions64[] = {
-  { "fnv1_64",  HashFnv1<uint64_t> },
-  { "fnv1a_64", HashFnv1a<uint64_t> },
+  { "fnv1_64",  HashFnv1<uint64_t>,  "flatbuffers::ConstHashFnv1<uint64_t>" },
+  { "fnv1a_64", HashFnv1a<uint64_t>, "flatbuffers::ConstHashFnv1a<uint64_t>" },
+  { "xxh64",    HashXXH64,           "flatbuffers::ConstHashXXH64" },
 };
 
 inline NamedHashFunction<uint32_t>::HashFunction FindHashFunction32(
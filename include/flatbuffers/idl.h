@@ -17,6 +17,7 @@
 #ifndef FLATBUFFERS_IDL_H_
 #define FLATBUFFERS_IDL_H_
 
+#include <stdio.h>
 #include <map>
 #include <set>
 #include <stack>
@@ -188,6 +189,14 @@ template<typename T> class SymbolTable {
     return it == dict.end() ? NULL : it->second;
   }
 
+  // The names elements were added under, e.g. to make a copy of the table.
+  const std::map<std::string, T *> &dictionary() const { return dict; }
+
+  void swap(SymbolTable &other) {
+    dict.swap(other.dict);
+    vec.swap(other.vec);
+  }
+
  private:
   std::map<std::string, T *> dict;      // quick lookup
 
@@ -218,8 +227,8 @@ struct Definition {
 };
 
 struct FieldDef : public Definition {
-  FieldDef() : deprecated(false), required(false), key(false), padding(0),
-               used(false) {}
+  FieldDef() : deprecated(false), required(false), key(false),
+               offset64(false), padding(0) {}
 
   Offset<reflection::Field> Serialize(FlatBufferBuilder *builder, uint16_t id)
                                                                           const;
@@ -229,8 +238,8 @@ struct FieldDef : public Definition {
                    // written in new data nor accessed in new code.
   bool required;   // Field must always be present.
   bool key;        // Field functions as a key for creating sorted vectors.
+  bool offset64;   // Vector stored after the buffer, see large_buffer.h.
   size_t padding;  // Bytes to always pad after this field.
-  bool used;       // Used during JSON parsing to check for repeated fields.
 };
 
 struct StructDef : public Definition {
@@ -305,15 +314,94 @@ struct EnumDef : public Definition {
   Type underlying_type;
 };
 
+// A cache of parsed include files, which lets a Parser restore the
+// definitions of an include file it has seen before instead of parsing it
+// again. An entry is only used if the parser is in the same state as when the
+// entry was made (i.e. the same files were included before this one, in the
+// same order), and the include file and all files it includes in turn are
+// unchanged.
+// Entries are kept in memory, and if a directory is given, also stored there
+// so they can be shared between processes, e.g. runs of flatc. They hold the
+// full parser state rather than a reflection::Schema (.bfbs), since the
+// latter leaves out doc comments, attributes and namespaces.
+// Not thread-safe: use one cache per thread.
+class SchemaCache {
+ public:
+  explicit SchemaCache(const std::string &directory = "")
+    : directory_(directory), hits_(0), misses_(0) {}
+
+  // Number of include files restored from / not found in the cache.
+  size_t hits() const { return hits_; }
+  size_t misses() const { return misses_; }
+
+ private:
+  friend class Parser;
+
+  struct Entry {
+    std::string state_before;   // Parser::schema_state_ before the include.
+    std::string include_paths;
+    // Path and contents of all files parsed, starting with the include file.
+    std::vector<std::pair<std::string, std::string> > files;
+    // All includes seen, and whether they had been included beforehand.
+    std::vector<std::pair<std::string, bool> > includes;
+    // Files newly included, with the files they include.
+    std::map<std::string, std::set<std::string> > new_files;
+    std::string parser_state;  // See Parser::WriteSchemaState().
+    std::string state_after;
+  };
+
+  static std::string Key(const std::string &state,
+                         const std::string &include_paths,
+                         const std::string &filepath,
+                         const std::string &contents);
+  static void WriteEntry(const Entry &entry, std::string *out);
+  static bool ReadEntry(const std::string &in, Entry *entry);
+
+  const Entry *Lookup(const std::string &key);
+  void Store(const std::string &key, const Entry &entry);
+  std::string FileName(const std::string &key) const;
+
+  std::string directory_;
+  std::map<std::string, Entry> entries_;
+  size_t hits_;
+  size_t misses_;
+};
+
+// What a Parser did since it was constructed, see Parser::GetStats(). Only
+// counted with FLATBUFFERS_STATS (see flatbuffers.h).
+struct ParserStats {
+  ParserStats()
+    : bytes(0), tokens(0), json_objects(0), schema_seconds(0),
+      json_seconds(0) {}
+
+  // Of source text parsed. A file is parsed again after each include file
+  // it brings in, which counts again.
+  size_t bytes;
+  size_t tokens;
+  size_t json_objects;    // Root tables parsed from JSON.
+  double schema_seconds;  // Processor time spent parsing declarations,
+  double json_seconds;    // and JSON.
+};
+
 class Parser {
+  friend class JsonConverter;
+
  public:
-  Parser(bool strict_json = false, bool proto_mode = false)
+  // If share_strings is set, identical strings in JSON data are only stored
+  // once in builder_ (see FlatBufferBuilder::CreateSharedString).
+  Parser(bool strict_json = false, bool proto_mode = false,
+         bool share_strings = false)
     : root_struct_def_(NULL),
       source_(NULL),
       cursor_(NULL),
+      source_end_(NULL),
       line_(1),
+      schema_(this),
+      json_builder_(&builder_),
       proto_mode_(proto_mode),
-      strict_json_(strict_json) {
+      strict_json_(strict_json),
+      share_strings_(share_strings),
+      schema_cache_(NULL) {
     // Just in case none are declared:
     namespaces_.push_back(new Namespace());
     known_attributes_.insert("deprecated");
@@ -325,6 +413,9 @@ class Parser {
     known_attributes_.insert("bit_flags");
     known_attributes_.insert("original_order");
     known_attributes_.insert("nested_flatbuffer");
+    known_attributes_.insert("key_index");
+    known_attributes_.insert("offset64");
+    if (!proto_mode) schema_state_ = "initial";
   }
 
   ~Parser() {
@@ -345,6 +436,10 @@ class Parser {
   bool Parse(const char *_source, const char **include_paths = NULL,
              const char *source_filename = NULL);
 
+  // Restore include files from cache where possible, and add any include
+  // files parsed to it. The cache must outlive the parser.
+  void SetSchemaCache(SchemaCache *cache) { schema_cache_ = cache; }
+
   // Set the root type. May override the one set in the schema.
   bool SetRootType(const char *name);
 
@@ -366,6 +461,11 @@ class Parser {
   // See reflection/reflection.fbs
   void Serialize();
 
+  // Counters of the parsing done so far (all zero unless compiled with
+  // FLATBUFFERS_STATS). builder_.GetStats() has those of the last data
+  // parsed.
+  ParserStats GetStats() const { return stats_; }
+
  private:
   int64_t ParseHexNum(int nibbles);
   void Next();
@@ -396,6 +496,10 @@ class Parser {
   void ParseDecl();
   void ParseProtoDecl();
   Type ParseTypeFromProtoType();
+  bool ParseInclude(const std::string &contents, const std::string &filepath,
+                    const char **include_paths);
+  void WriteSchemaState(std::string *out) const;
+  bool ReadSchemaState(const std::string &in);
 
  public:
   SymbolTable<StructDef> structs_;
@@ -413,18 +517,82 @@ class Parser {
 
  private:
   const char *source_, *cursor_;
+  const char *source_end_;  // the terminating 0 of source_
   int line_;  // the current line being parsed
   int token_;
+  const Parser *schema_;  // where enums are looked up, normally this
+  FlatBufferBuilder *json_builder_;  // where JSON goes, normally &builder_
   std::stack<std::string> files_being_parsed_;
   bool proto_mode_;
   bool strict_json_;
+  bool share_strings_;
   std::string attribute_;
   std::vector<std::string> doc_comment_;
 
   std::vector<std::pair<Value, FieldDef *> > field_stack_;
   std::vector<uint8_t> struct_stack_;
+  std::vector<bool> field_seen_;
+
+  SchemaCache *schema_cache_;
+  // Identifies the state of the schema while only include files have been
+  // parsed into it, empty once that no longer holds.
+  std::string schema_state_;
+  // Cache entries being recorded, one per include file being parsed.
+  std::vector<SchemaCache::Entry *> cache_recordings_;
 
   std::set<std::string> known_attributes_;
+
+  ParserStats stats_;
+};
+
+// Converts any number of JSON objects into FlatBuffers, using a schema
+// (including its root_type) that was parsed by a Parser beforehand.
+// The schema Parser is only read from, so multiple converters, e.g. one per
+// thread, can share it as long as no more schemas are parsed into it.
+// Each converter has its own parsing state and builder, both of which keep
+// their memory from one object to the next.
+class JsonConverter {
+ public:
+  // Called for every object converted, with the finished buffer, which is
+  // only valid until the next object is converted. Return false to stop.
+  typedef bool (*Callback)(void *context, const uint8_t *buf, size_t len);
+
+  // If builder is NULL, an internal one is used.
+  explicit JsonConverter(const Parser &schema,
+                         FlatBufferBuilder *builder = NULL,
+                         bool strict_json = false,
+                         bool share_strings = false);
+
+  // Convert a single JSON object into builder(), which is cleared first.
+  bool Convert(const char *json);
+
+  // Convert a sequence of JSON objects separated by whitespace, such as
+  // newline-delimited JSON, calling callback for each of them as soon as
+  // it is finished.
+  bool ConvertAll(const char *json, Callback callback, void *context);
+
+  FlatBufferBuilder &builder() { return *parser_.json_builder_; }
+
+  // A Parser with the root type, file identifier and extension of the
+  // schema, whose builder_ is the internal builder (if used). This is what
+  // GenerateBinary() and GenerateTextFile() need to write out the result.
+  const Parser &parser() const { return parser_; }
+
+  // Counters of all conversions so far, see Parser::GetStats().
+  ParserStats GetStats() const { return parser_.GetStats(); }
+
+  // User readable error if Convert() or ConvertAll() returned false.
+  const std::string &error() const { return parser_.error_; }
+
+  // Number of objects converted by the last ConvertAll().
+  size_t count() const { return count_; }
+
+ private:
+  bool ConvertObjects(const char *json, bool single, Callback callback,
+                      void *context);
+
+  Parser parser_;
+  size_t count_;
 };
 
 // Utility functions for multiple generators:
@@ -447,6 +615,8 @@ struct GeneratorOptions {
   bool prefixed_enums;
   bool include_dependence_headers;
   bool mutable_buffer;
+  bool lazy_verify;
+  bool fixed_create;
   bool one_file;
 
   // Possible options for the more general generator below.
@@ -460,6 +630,8 @@ struct GeneratorOptions {
                        output_enum_identifiers(true), prefixed_enums(true),
                        include_dependence_headers(true),
                        mutable_buffer(false),
+                       lazy_verify(false),
+                       fixed_create(false),
                        one_file(false),
                        lang(GeneratorOptions::kJava) {}
 };
@@ -474,6 +646,145 @@ extern void GenerateText(const Parser &parser,
                          const void *flatbuffer,
                          const GeneratorOptions &opts,
                          std::string *text);
+
+// Output for streaming text generation. Text is collected in a fixed size
+// buffer, which is passed on to Write() whenever it is full, so generating
+// text for a large buffer never holds more than that in memory.
+// Derived classes flush any remaining output when destroyed.
+class TextSink {
+ public:
+  explicit TextSink(size_t buffer_size = 16384)
+    : buf_(buffer_size ? buffer_size : 1), used_(0), ok_(true) {}
+  virtual ~TextSink() {}
+
+  void append(const char *s, size_t len) {
+    if (len > buf_.size() - used_) {
+      Flush();
+      if (len >= buf_.size()) {  // Too big to buffer, write it directly.
+        ok_ = Write(s, len) && ok_;
+        return;
+      }
+    }
+    memcpy(&buf_[used_], s, len);
+    used_ += len;
+  }
+
+  void append(size_t n, char c) {
+    while (n) {
+      if (used_ == buf_.size()) Flush();
+      size_t len = std::min(n, buf_.size() - used_);
+      memset(&buf_[used_], c, len);
+      used_ += len;
+      n -= len;
+    }
+  }
+
+  TextSink &operator+=(const std::string &s) {
+    append(s.c_str(), s.length());
+    return *this;
+  }
+  TextSink &operator+=(const char *s) {
+    append(s, strlen(s));
+    return *this;
+  }
+  TextSink &operator+=(char c) {
+    if (used_ == buf_.size()) Flush();
+    buf_[used_++] = c;
+    return *this;
+  }
+
+  // Write out any buffered text. Returns false if any write so far failed.
+  bool Flush() {
+    if (used_) {
+      ok_ = Write(&buf_[0], used_) && ok_;
+      used_ = 0;
+    }
+    return ok_;
+  }
+
+ protected:
+  // Write len bytes of text, return false on error.
+  virtual bool Write(const char *data, size_t len) = 0;
+
+ private:
+  TextSink(const TextSink &);
+  TextSink &operator=(const TextSink &);
+
+  std::vector<char> buf_;
+  size_t used_;
+  bool ok_;
+};
+
+// Appends text to a std::string.
+class StringTextSink : public TextSink {
+ public:
+  explicit StringTextSink(std::string *str) : str_(str) {}
+  ~StringTextSink() { Flush(); }
+
+ protected:
+  bool Write(const char *data, size_t len) {
+    str_->append(data, len);
+    return true;
+  }
+
+ private:
+  std::string *str_;
+};
+
+// Writes text to a stdio file. The file is not closed.
+class FileTextSink : public TextSink {
+ public:
+  explicit FileTextSink(FILE *file, size_t buffer_size = 16384)
+    : TextSink(buffer_size), file_(file) {}
+  ~FileTextSink() { Flush(); }
+
+ protected:
+  bool Write(const char *data, size_t len);
+
+ private:
+  FILE *file_;
+};
+
+// Writes text to a file descriptor. The descriptor is not closed.
+class FdTextSink : public TextSink {
+ public:
+  explicit FdTextSink(int fd, size_t buffer_size = 16384)
+    : TextSink(buffer_size), fd_(fd) {}
+  ~FdTextSink() { Flush(); }
+
+ protected:
+  bool Write(const char *data, size_t len);
+
+ private:
+  int fd_;
+};
+
+// Passes text on to a callback, which returns false on error.
+class CallbackTextSink : public TextSink {
+ public:
+  typedef bool (*Callback)(void *context, const char *data, size_t len);
+
+  CallbackTextSink(Callback callback, void *context,
+                   size_t buffer_size = 16384)
+    : TextSink(buffer_size), callback_(callback), context_(context) {}
+  ~CallbackTextSink() { Flush(); }
+
+ protected:
+  bool Write(const char *data, size_t len) {
+    return callback_(context_, data, len);
+  }
+
+ private:
+  Callback callback_;
+  void *context_;
+};
+
+// Same as GenerateText above, but streams the text to "sink" as it is
+// generated. Returns false if writing any of it failed.
+extern bool GenerateText(const Parser &parser,
+                         const void *flatbuffer,
+                         const GeneratorOptions &opts,
+                         TextSink *sink);
 extern bool GenerateTextFile(const Parser &parser,
                              const std::string &path,
                              const std::string &file_name,
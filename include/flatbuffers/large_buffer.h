@@ -0,0 +1,162 @@
+/*
+ * Copyright 2015 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLATBUFFERS_LARGE_BUFFER_H_
+#define FLATBUFFERS_LARGE_BUFFER_H_
+
+#include <ostream>
+
+#include "flatbuffers/flatbuffers.h"
+
+// A large buffer is a regular FlatBuffer (which stays below 2GB), followed
+// by a region of vectors of any size, e.g. model weights or nested
+// FlatBuffers. Tables refer to those with fields that have the offset64
+// attribute, which hold a 64bit offset from the field to the vector.
+// The whole can be mapped (see MappedFile), and accessed in place with
+// GetRoot<T>() and the generated accessors, which return a Vector64 for
+// such fields. The generated Verify() functions check them too.
+//
+// Layout of the region: each vector is its size (uoffset64_t) followed by
+// the elements, aligned to the larger of 8 and their own alignment. Since
+// these offsets reach past the end of the buffer, such fields can't be
+// copied into other buffers (e.g. by Splice() or CopyTable()).
+
+namespace flatbuffers {
+
+// Lays out the region following the buffer built by a FlatBufferBuilder,
+// then writes both.
+class LargeBufferBuilder {
+ public:
+  explicit LargeBufferBuilder(FlatBufferBuilder &fbb)
+    : fbb_(fbb), size_(1) {}  // Nothing at position 0, which means NULL.
+
+  // Adds a vector of scalars or structs to the region, to be passed to the
+  // add_ function (or the Create function) of a field with the offset64
+  // attribute. len may exceed the size of any FlatBuffer. The elements
+  // aren't copied, so they must stay valid until Write(), e.g. in a mapped
+  // input file.
+  template<typename T> Offset64<Vector64<T> > CreateVector(const T *v,
+                                                           uoffset64_t len) {
+    return Offset64<Vector64<T> >(
+             Add(v, len, sizeof(T), AlignOf<T>(),
+                 std::tr1::is_scalar<T>::value));
+  }
+
+  template<typename T> Offset64<Vector64<T> > CreateVector(
+                                                 const std::vector<T> &v) {
+    return CreateVector(v.empty() ? NULL : &v[0], v.size());
+  }
+
+  // The size the buffer and region will have once written (as soon as the
+  // buffer is finished).
+  uoffset64_t GetSize() const {
+    return entries_.empty() ? fbb_.GetSize() : fbb_.GetSize() + size_;
+  }
+
+  // Writes the finished buffer, followed by the region. Returns false if
+  // the stream failed.
+  bool Write(std::ostream &out) const {
+    out.write(reinterpret_cast<const char *>(fbb_.GetBufferPointer()),
+              fbb_.GetSize());
+    uoffset64_t pos = 0;
+    for (std::vector<Entry>::const_iterator it = entries_.begin();
+         it != entries_.end(); ++it) {
+      static const char zeros[16] = { 0 };
+      for (uoffset64_t padding = it->pos - pos; padding; ) {
+        size_t n = padding < sizeof(zeros) ? static_cast<size_t>(padding)
+                                           : sizeof(zeros);
+        out.write(zeros, static_cast<std::streamsize>(n));
+        padding -= n;
+      }
+      uint8_t size[sizeof(uoffset64_t)];
+      WriteScalar(size, it->len);
+      out.write(reinterpret_cast<const char *>(size), sizeof(size));
+      WriteElements(out, *it);
+      pos = it->pos + sizeof(uoffset64_t) + it->len * it->elem_size;
+    }
+    out.flush();
+    return out.good();
+  }
+
+ private:
+  LargeBufferBuilder(const LargeBufferBuilder &);
+  LargeBufferBuilder &operator=(const LargeBufferBuilder &);
+
+  struct Entry {
+    const uint8_t *data;
+    uoffset64_t len;
+    size_t elem_size;
+    bool swap;  // Scalars to byte swap when writing, on big endian machines.
+    uoffset64_t pos;  // Of the size, the elements follow.
+  };
+
+  uoffset64_t Add(const void *v, uoffset64_t len, size_t elem_size,
+                  size_t elem_align, bool is_scalar) {
+    fbb_.NotNested();
+    size_t alignment = elem_align > sizeof(uoffset64_t)
+                       ? elem_align : sizeof(uoffset64_t);
+    // The region starts where the buffer ends, so the buffer must end
+    // aligned: this only ensures it will when finished.
+    fbb_.Align(alignment);
+    Entry entry;
+    entry.data = reinterpret_cast<const uint8_t *>(v);
+    entry.len = len;
+    entry.elem_size = elem_size;
+    entry.swap = is_scalar && !FLATBUFFERS_LITTLEENDIAN && elem_size > 1;
+    entry.pos = ((size_ + sizeof(uoffset64_t) + alignment - 1) &
+                 ~static_cast<uoffset64_t>(alignment - 1)) -
+                sizeof(uoffset64_t);
+    size_ = entry.pos + sizeof(uoffset64_t) + len * elem_size;
+    entries_.push_back(entry);
+    return entry.pos;
+  }
+
+  static void WriteElements(std::ostream &out, const Entry &entry) {
+    uoffset64_t bytes = entry.len * entry.elem_size;
+    if (!entry.swap) {
+      // Written in pieces, since streamsize may be 32bit.
+      for (uoffset64_t done = 0; done < bytes; ) {
+        uoffset64_t n = bytes - done < (1U << 30) ? bytes - done
+                                                  : (1U << 30);
+        out.write(reinterpret_cast<const char *>(entry.data + done),
+                  static_cast<std::streamsize>(n));
+        done += n;
+      }
+      return;
+    }
+    char swapped[4096];  // A multiple of any scalar size.
+    for (uoffset64_t done = 0; done < bytes; ) {
+      size_t n = bytes - done < sizeof(swapped)
+                 ? static_cast<size_t>(bytes - done) : sizeof(swapped);
+      for (size_t i = 0; i < n; i += entry.elem_size) {
+        for (size_t b = 0; b < entry.elem_size; b++) {
+          swapped[i + b] = static_cast<char>(
+                             entry.data[done + i + entry.elem_size - 1 - b]);
+        }
+      }
+      out.write(swapped, static_cast<std::streamsize>(n));
+      done += n;
+    }
+  }
+
+  FlatBufferBuilder &fbb_;
+  uoffset64_t size_;  // Of the region.
+  std::vector<Entry> entries_;
+};
+
+}  // namespace flatbuffers
+
+#endif  // FLATBUFFERS_LARGE_BUFFER_H_
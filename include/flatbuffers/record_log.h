@@ -0,0 +1,258 @@
+/*
+ * Copyright 2015 Google Inc. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLATBUFFERS_RECORD_LOG_H_
+#define FLATBUFFERS_RECORD_LOG_H_
+
+#include <ostream>
+
+#include "flatbuffers/flatbuffers.h"
+#include "flatbuffers/util.h"
+
+// A record log stores many finished FlatBuffers in one file or stream, each
+// of which can be accessed in place, in O(1) by record number.
+//
+// Layout (all integers little endian):
+// - Header (16 bytes): "FBLG", the file identifier of the records (or 4 zero
+//   bytes), the record alignment (uint32), and 4 reserved zero bytes.
+// - Records: zero padding, the size of the buffer (uoffset_t), and the
+//   buffer itself, starting at a multiple of the record alignment.
+// - An end marker, framed like a record of size 0, followed by the index:
+//   the offset of each buffer from the start of the log (uint64).
+// - Trailer (24 bytes): the offset of the index, the amount of records
+//   (both uint64), and "FBLGINDX".
+// A log that was never finished (e.g. as its writer crashed) has no index,
+// but the records can still be found by following their sizes.
+
+namespace flatbuffers {
+
+static const char kRecordLogMagic[] = "FBLG";
+static const char kRecordLogIndexMagic[] = "FBLGINDX";
+static const size_t kRecordLogHeaderSize = 16;
+static const size_t kRecordLogTrailerSize = 24;
+
+// Appends finished buffers to a stream (e.g. an std::ofstream opened in
+// binary mode), writing the index when finished.
+class RecordLogWriter {
+ public:
+  // If file_identifier is given, only buffers with that identifier may be
+  // appended. alignment must be a power of 2, and at least the alignment of
+  // any buffer appended.
+  explicit RecordLogWriter(std::ostream &out,
+                           const char *file_identifier = NULL,
+                           size_t alignment = sizeof(largest_scalar_t))
+    : out_(out), pos_(0), alignment_(alignment), finished_(false) {
+    assert(alignment >= sizeof(uoffset_t) && !(alignment & (alignment - 1)));
+    char header[kRecordLogHeaderSize];
+    memset(header, 0, sizeof(header));
+    memcpy(header, kRecordLogMagic, 4);
+    if (file_identifier) {
+      assert(strlen(file_identifier) ==
+             FlatBufferBuilder::kFileIdentifierLength);
+      memcpy(header + 4, file_identifier, 4);
+      file_identifier_.assign(file_identifier, 4);
+    }
+    WriteScalar(header + 8, static_cast<uint32_t>(alignment));
+    Write(header, sizeof(header));
+  }
+
+  // Appends a finished buffer, which becomes record num_records() - 1.
+  // Returns false if the buffer is too small or lacks the file identifier,
+  // or if the stream failed.
+  bool Append(const uint8_t *buf, size_t len) {
+    assert(!finished_);
+    if (len < sizeof(uoffset_t)) return false;  // Not a buffer.
+    if (!file_identifier_.empty() &&
+        (len < sizeof(uoffset_t) + FlatBufferBuilder::kFileIdentifierLength ||
+         !BufferHasIdentifier(buf, file_identifier_.c_str())))
+      return false;
+    uint64_t start = Frame(static_cast<uoffset_t>(len));
+    Write(buf, len);
+    offsets_.push_back(start);
+    return out_.good();
+  }
+
+  bool Append(const FlatBufferBuilder &fbb) {
+    assert(fbb.GetBufferMinAlignment() <= alignment_);
+    return Append(fbb.GetBufferPointer(), fbb.GetSize());
+  }
+
+  // Writes the end marker, index and trailer. Nothing may be appended
+  // afterwards.
+  bool Finish() {
+    assert(!finished_);
+    finished_ = true;
+    uint64_t index = Frame(0);
+    for (size_t i = 0; i < offsets_.size(); i++) {
+      uint8_t offset[sizeof(uint64_t)];
+      WriteScalar(offset, offsets_[i]);
+      Write(offset, sizeof(offset));
+    }
+    char trailer[kRecordLogTrailerSize];
+    WriteScalar(trailer, index);
+    WriteScalar(trailer + 8, static_cast<uint64_t>(offsets_.size()));
+    memcpy(trailer + 16, kRecordLogIndexMagic, 8);
+    Write(trailer, sizeof(trailer));
+    out_.flush();
+    return out_.good();
+  }
+
+  size_t num_records() const { return offsets_.size(); }
+
+ private:
+  RecordLogWriter(const RecordLogWriter &);
+  RecordLogWriter &operator=(const RecordLogWriter &);
+
+  void Write(const void *data, size_t len) {
+    out_.write(reinterpret_cast<const char *>(data), len);
+    pos_ += len;
+  }
+
+  // Writes padding and a size, returns where the data will begin.
+  uint64_t Frame(uoffset_t size) {
+    static const char zeros[256] = { 0 };
+    uint64_t start = (pos_ + sizeof(uoffset_t) + alignment_ - 1) &
+                     ~static_cast<uint64_t>(alignment_ - 1);
+    for (size_t padding = static_cast<size_t>(start - sizeof(uoffset_t) -
+                                              pos_);
+         padding; ) {
+      size_t n = padding < sizeof(zeros) ? padding : sizeof(zeros);
+      Write(zeros, n);
+      padding -= n;
+    }
+    uint8_t prefix[sizeof(uoffset_t)];
+    WriteScalar(prefix, size);
+    Write(prefix, sizeof(prefix));
+    return start;
+  }
+
+  std::ostream &out_;
+  uint64_t pos_;
+  size_t alignment_;
+  std::string file_identifier_;
+  std::vector<uint64_t> offsets_;
+  bool finished_;
+};
+
+// Reads records from a log in memory (or mapped by Open()), without
+// copying them.
+class RecordLogReader {
+ public:
+  RecordLogReader()
+    : log_(NULL), index_(NULL), index_end_(0), num_records_(0) {}
+
+  // Reads a log from memory, which must stay valid while this is used, and
+  // be aligned to the record alignment. Returns false if it isn't a record
+  // log. Unfinished logs are scanned once to find their records.
+  bool Init(const uint8_t *log, size_t len) {
+    log_ = NULL;
+    index_ = NULL;
+    num_records_ = 0;
+    scanned_.clear();
+    if (len < kRecordLogHeaderSize || memcmp(log, kRecordLogMagic, 4))
+      return false;
+    uint32_t alignment = ReadScalar<uint32_t>(log + 8);
+    if (alignment < sizeof(uoffset_t) || (alignment & (alignment - 1)))
+      return false;
+    log_ = log;
+    if (len >= kRecordLogHeaderSize + kRecordLogTrailerSize &&
+        !memcmp(log + len - 8, kRecordLogIndexMagic, 8)) {
+      const uint8_t *trailer = log + len - kRecordLogTrailerSize;
+      uint64_t index = ReadScalar<uint64_t>(trailer);
+      uint64_t num_records = ReadScalar<uint64_t>(trailer + 8);
+      uint64_t index_end = len - kRecordLogTrailerSize;
+      if (index >= kRecordLogHeaderSize && index <= index_end &&
+          (index_end - index) / sizeof(uint64_t) == num_records &&
+          !((index_end - index) % sizeof(uint64_t))) {
+        index_ = log + index;
+        index_end_ = index;
+        num_records_ = static_cast<size_t>(num_records);
+        return true;
+      }
+    }
+    // No (valid) index: follow the sizes. This stops at the end marker, or
+    // at a record that was only partially written.
+    for (uint64_t pos = kRecordLogHeaderSize; ; ) {
+      uint64_t start = (pos + sizeof(uoffset_t) + alignment - 1) &
+                       ~static_cast<uint64_t>(alignment - 1);
+      if (start > len) break;
+      uoffset_t size = ReadScalar<uoffset_t>(log + start - sizeof(uoffset_t));
+      if (!size || size > len - start) break;
+      scanned_.push_back(start);
+      pos = start + size;
+    }
+    num_records_ = scanned_.size();
+    index_end_ = len;
+    return true;
+  }
+
+  // Maps file "name", and reads the log in it (see Init()).
+  bool Open(const char *name,
+            MappedFile::Access access = MappedFile::kAccessRandom) {
+    return file_.Map(name, access) && Init(file_.data(), file_.size());
+  }
+
+  // True if the log was finished, so records didn't need to be scanned.
+  bool has_index() const { return index_ != NULL; }
+
+  size_t num_records() const { return num_records_; }
+
+  // The file identifier given to the writer, or "" if none was.
+  std::string file_identifier() const {
+    return log_ && log_[4]
+      ? std::string(reinterpret_cast<const char *>(log_ + 4),
+                    FlatBufferBuilder::kFileIdentifierLength)
+      : std::string();
+  }
+
+  // Returns record i and sets *len to its size, or returns NULL if i is out
+  // of range or the log is corrupt. The result can be passed to Verifier and
+  // GetRoot<T>().
+  const uint8_t *Get(size_t i, size_t *len) const {
+    if (i >= num_records_) return NULL;
+    uint64_t start = index_
+      ? ReadScalar<uint64_t>(index_ + i * sizeof(uint64_t))
+      : scanned_[i];
+    if (start < kRecordLogHeaderSize + sizeof(uoffset_t) ||
+        start > index_end_)
+      return NULL;
+    uoffset_t size = ReadScalar<uoffset_t>(log_ + start - sizeof(uoffset_t));
+    if (size > index_end_ - start) return NULL;
+    *len = size;
+    return log_ + start;
+  }
+
+  template<typename T> const T *GetRoot(size_t i) const {
+    size_t len;
+    const uint8_t *buf = Get(i, &len);
+    return buf ? flatbuffers::GetRoot<T>(buf) : NULL;
+  }
+
+ private:
+  RecordLogReader(const RecordLogReader &);
+  RecordLogReader &operator=(const RecordLogReader &);
+
+  MappedFile file_;
+  const uint8_t *log_;
+  const uint8_t *index_;
+  uint64_t index_end_;  // Records end before this offset.
+  size_t num_records_;
+  std::vector<uint64_t> scanned_;  // Record offsets, without index_.
+};
+
+}  // namespace flatbuffers
+
+#endif  // FLATBUFFERS_RECORD_LOG_H_
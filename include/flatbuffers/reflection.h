@@ -17,6 +17,8 @@
 #ifndef FLATBUFFERS_REFLECTION_H_
 #define FLATBUFFERS_REFLECTION_H_
 
+#include <map>
+
 // This is somewhat of a circular dependency because flatc (and thus this
 // file) is needed to generate this header in the first place.
 // Should normally not be a problem since it can be generated by the
@@ -89,6 +91,15 @@ template<typename T> Vector<T> *GetFieldV(const Table &table,
   return table.GetPointer<Vector<T> *>(field.offset());
 }
 
+// Get a field, if you know it's a vector with the offset64 attribute.
+template<typename T> Vector64<T> *GetFieldV64(const Table &table,
+                                              const reflection::Field &field) {
+  assert(field.type()->base_type() == reflection::Vector &&
+         field.offset64() &&
+         sizeof(T) == GetTypeSize(field.type()->element()));
+  return table.GetPointer64<Vector64<T> *>(field.offset());
+}
+
 // Get a field, if you know it's a vector, generically.
 // To actually access elements, use the return value together with
 // field.type()->element() in any of GetAnyVectorElemI below etc.
@@ -390,6 +401,57 @@ void ResizeVector(const reflection::Schema &schema, uoffset_t newsize, T val,
   }
 }
 
+// Collects any number of the above string changes and vector resizes, and
+// applies them together: the offsets in the FlatBuffer are adjusted in one
+// pass over its tables, and the buffer is rebuilt in one copy, rather than
+// doing both for every change.
+// Strings and vectors are passed as pointers into flatbuf as it is before
+// Apply() (which invalidates them), and each may only be changed once per
+// batch.
+class ResizeBatch {
+ public:
+  ResizeBatch(const reflection::Schema &schema, std::vector<uint8_t> *flatbuf,
+              const reflection::Object *root_table = NULL);
+
+  void SetString(const String *str, const std::string &val);
+
+  // New elements are set to val (elem_size bytes), or 0 if NULL.
+  void ResizeAnyVector(const VectorOfAny *vec, uoffset_t num_elems,
+                       uoffset_t newsize, uoffset_t elem_size,
+                       const uint8_t *val = NULL);
+
+  template <typename T> void ResizeVector(const Vector<T> *vec,
+                                          uoffset_t newsize, T val) {
+    uint8_t elem[sizeof(T)];
+    bool is_scalar = std::tr1::is_scalar<T>::value;
+    if (is_scalar) {
+      WriteScalar(elem, val);
+    } else {  // struct
+      memcpy(elem, &val, sizeof(T));
+    }
+    ResizeAnyVector(reinterpret_cast<const VectorOfAny *>(vec), vec->size(),
+                    newsize, static_cast<uoffset_t>(sizeof(T)), elem);
+  }
+
+  // Apply all changes, after which the batch may be used for more.
+  void Apply();
+
+ private:
+  struct Change {
+    uoffset_t object;  // Offset of the string or vector in flatbuf.
+    uoffset_t old_length;
+    uoffset_t new_length;
+    uoffset_t elem_size;
+    bool is_string;
+    std::string data;  // The new string, or the value of new elements.
+  };
+
+  const reflection::Schema &schema_;
+  std::vector<uint8_t> *flatbuf_;
+  const reflection::Object *root_table_;
+  std::vector<Change> changes_;
+};
+
 // Adds any new data (in the form of a new FlatBuffer) to an existing
 // FlatBuffer. This can be used when any of the above methods are not
 // sufficient, in particular for adding new tables and new fields.
@@ -416,11 +478,425 @@ inline bool SetFieldT(Table *table, const reflection::Field &field,
 // to remove.
 // Note: this does not deal with DAGs correctly. If the table passed forms a
 // DAG, the copy will be a tree instead (with duplicates).
+// If use_string_pooling is set, strings are written with CreateSharedString,
+// so each distinct string is only stored once in the copy.
+// Fields with the offset64 attribute are left out of the copy, since their
+// vectors lie past the end of the buffer (use a CopyPlan to detect them).
 
 Offset<const Table *> CopyTable(FlatBufferBuilder &fbb,
                                 const reflection::Schema &schema,
                                 const reflection::Object &objectdef,
-                                const Table &table);
+                                const Table &table,
+                                bool use_string_pooling = false);
+
+// Copies tables like CopyTable(), but only the fields selected, by a plan
+// compiled from the schema once: a flat list of the fields to copy for each
+// table, with how to copy them. Fields not selected are never visited.
+// Paths select fields of the root table, and fields of the tables within
+// them separated by dots, e.g. "pos", "name" and "testarrayoftables.name".
+// Selecting a table (or vector of tables, or union) without going into it
+// selects all of it, as does an empty path for the root table itself, and
+// selecting a union also selects its type field.
+// A plan can be shared between threads.
+class CopyPlan {
+ public:
+  // Copies all fields.
+  explicit CopyPlan(const reflection::Schema &schema,
+                    const reflection::Object *root_table = NULL);
+  CopyPlan(const reflection::Schema &schema,
+           const std::vector<std::string> &paths,
+           const reflection::Object *root_table = NULL);
+
+  // False if any of the paths didn't name a field (those are ignored), or
+  // if fields with the offset64 attribute were selected (those are skipped).
+  bool ok() const { return ok_; }
+
+  // Copy a root table into fbb. With use_sharing, strings are written with
+  // CreateSharedString, and tables that the source refers to more than once
+  // are only copied once, so sharing in the source is kept in the copy.
+  Offset<const Table *> Copy(FlatBufferBuilder &fbb, const Table &table,
+                             bool use_sharing = false) const;
+
+  // Copy a root table into fbb like Copy() with use_sharing, but also store
+  // identical vectors and tables only once, wherever they are in the source:
+  // objects are compared by their contents after their own subobjects have
+  // been shared, so identical subtrees all become a single copy.
+  Offset<const Table *> Compact(FlatBufferBuilder &fbb,
+                                const Table &table) const;
+
+ private:
+  enum FieldKind {
+    kInline,            // Scalars and structs.
+    kString,
+    kTable,
+    kUnion,
+    kVector,            // Of scalars or structs, copied in one go.
+    kVectorOfStrings,
+    kVectorOfTables,
+    kVector64           // Of scalars or structs, with the offset64 attribute.
+  };
+
+  struct FieldPlan {
+    voffset_t offset;
+    voffset_t type_offset;  // Of the type field, for unions.
+    uint8_t kind;
+    // Size and alignment of the field (kInline) or vector element (kVector).
+    size_t size;
+    size_t align;
+    // Plan index for tables, or index into union_plans_ for unions.
+    size_t index;
+  };
+
+  struct ObjectPlan {
+    size_t fields_start;
+    size_t fields_end;
+    voffset_t num_fields;  // Size of the vtable.
+  };
+
+  // The fields selected from a table, each with the index of the Selection
+  // of what's selected within it.
+  struct Selection {
+    Selection() : all(false) {}
+    bool all;
+    std::map<std::string, size_t> fields;
+  };
+  typedef std::vector<Selection> Selections;
+
+  struct CopyState;
+
+  void Compile(const Selections &selections);
+  bool Select(Selections *selections, const std::string &path) const;
+  // A NULL selection selects everything.
+  int CompileObject(int object_index, const Selections &selections,
+                    const Selection *selection);
+  size_t CompileUnion(const reflection::Field &fielddef,
+                      const Selections &selections);
+  uoffset_t CopyString(CopyState &state, const String *str) const;
+  uoffset_t EndVectorOfOffsets(CopyState &state, size_t start) const;
+  uoffset_t CopyObject(CopyState &state, size_t index,
+                       const Table &table) const;
+  // With Compact(), returns the copy of an object with these contents if
+  // there is one, or else remembers the copy about to be made.
+  uoffset_t FindShared(CopyState &state, const std::string &contents) const;
+  void AddShared(CopyState &state, const std::string &contents,
+                 uoffset_t offset) const;
+
+  const reflection::Schema &schema_;
+  const reflection::Object *root_table_;
+  bool ok_;
+  int root_index_;  // -1 if there is no root table.
+  std::map<const reflection::Object *, int> object_indices_;
+  std::vector<ObjectPlan> objects_;
+  std::vector<FieldPlan> fields_;
+  // The plan selecting everything for each object, or -1 if not compiled.
+  std::vector<int> all_plans_;
+  // For each union field, the plan for every union type value, or -1 for
+  // NONE and undefined values.
+  std::vector<std::vector<int> > union_plans_;
+};
+
+// Rebuilds the buffer buf (of len bytes) into fbb, with CopyPlan::Compact()
+// copying all fields, so that identical strings, vectors and tables are only
+// stored once, and bytes that nothing refers to are dropped. fbb is
+// finished with the identifier of buf, if the schema has one.
+// If buf is not the schema's root table, pass in its root table type.
+// Returns false if buf doesn't pass the SchemaVerifier (below).
+bool CompactBuffer(const reflection::Schema &schema, const uint8_t *buf,
+                   size_t len, FlatBufferBuilder *fbb,
+                   const reflection::Object *root_table = NULL);
+
+// ------------------------- VERIFYING -------------------------
+
+// Verifies FlatBuffers of any type in a schema, without generated code.
+// The constructor compiles every object in the schema into a plan: a flat
+// list of the field offsets, kinds and sizes to check. Verifying then just
+// runs down that list, so it performs the same checks as the generated
+// Verify() functions, and at a similar speed.
+// The schema must itself have been verified (or be trusted).
+class SchemaVerifier {
+ public:
+  explicit SchemaVerifier(const reflection::Schema &schema);
+
+  // Verify a whole buffer. If its root table is not the schema's root
+  // table, pass in the root table type as well.
+  bool VerifyBuffer(const uint8_t *buf, size_t buf_len,
+                    const reflection::Object *root_table = NULL,
+                    size_t max_depth = 64,
+                    size_t max_tables = 1000000) const;
+
+  // Verify a table of type objectdef (which must be part of the schema).
+  // Just like generated Verify() functions, this can be used as part of
+  // verifying a larger buffer.
+  bool VerifyTable(Verifier &verifier, const reflection::Object &objectdef,
+                   const Table *table) const {
+    return VerifyObject(verifier, GetObjectIndex(objectdef), table);
+  }
+
+ private:
+  enum FieldKind {
+    kInline,            // Scalars and structs.
+    kString,
+    kTable,
+    kUnion,
+    kVector,            // Of scalars or structs.
+    kVectorOfStrings,
+    kVectorOfTables,
+    kVector64           // Of scalars or structs, with the offset64 attribute.
+  };
+
+  struct FieldPlan {
+    voffset_t offset;
+    voffset_t type_offset;  // Of the type field, for unions.
+    uint8_t kind;
+    bool required;
+    // Size of the field (kInline) or vector element (kVector, kVector64).
+    size_t size;
+    // Object index for tables, or index into union_objects_ for unions.
+    size_t index;
+  };
+
+  struct ObjectPlan {
+    size_t fields_start;
+    size_t fields_end;
+  };
+
+  int GetObjectIndex(const reflection::Object &objectdef) const;
+  bool VerifyObject(Verifier &verifier, int index, const Table *table) const;
+  bool VerifyUnion(Verifier &verifier, const FieldPlan &field,
+                   const Table &table, const Table *value) const;
+
+  std::map<const reflection::Object *, int> object_indices_;
+  int root_index_;  // -1 if the schema has no root table.
+  std::vector<ObjectPlan> objects_;
+  // All fields of all objects, in order of their offset, without
+  // deprecated fields (or fields of structs, which are verified as a whole).
+  std::vector<FieldPlan> fields_;
+  // For each union type, the object index for every union type value, or
+  // -1 for NONE and undefined values.
+  std::vector<std::vector<int> > union_objects_;
+};
+
+// Compacts buffers like CompactBuffer(), compiling the CopyPlan and the
+// SchemaVerifier for the schema only once, for when there are many buffers.
+// If the buffers are not the schema's root table, pass in their root table
+// type. Like those, a BufferCompactor can be shared between threads.
+class BufferCompactor {
+ public:
+  explicit BufferCompactor(const reflection::Schema &schema,
+                           const reflection::Object *root_table = NULL);
+
+  // Same as CompactBuffer().
+  bool Compact(const uint8_t *buf, size_t len, FlatBufferBuilder *fbb) const;
+
+ private:
+  const reflection::Schema &schema_;
+  const reflection::Object *root_table_;
+  CopyPlan plan_;
+  SchemaVerifier verifier_;
+};
+
+// ------------------------- INDEXING -------------------------
+
+// Everything needed to access a field, decoded from its reflection::Field.
+struct FieldDescriptor {
+  // The vtable offset of a table field, or the offset of a struct field.
+  voffset_t offset;
+  reflection::BaseType base_type;
+  reflection::BaseType element;  // Only set for vectors.
+  int type_index;                // Object or enum index, -1 if none.
+  size_t inline_size;            // Size of the field in its table or struct.
+  int64_t default_integer;
+  double default_real;
+  const reflection::Field *field;
+};
+
+struct ObjectDescriptor {
+  bool is_struct;
+  size_t bytesize;  // Only set for structs.
+  // The fields of this object, sorted by name like in the schema.
+  const FieldDescriptor *fields;
+  size_t num_fields;
+  const reflection::Object *object;
+};
+
+// Resolves names in a schema to the descriptors above, through hash tables
+// built by the constructor, so finding a field by name doesn't need a binary
+// search and string compares on the schema, and accessing it doesn't decode
+// its reflection::Field again. The accessors below take the descriptors
+// wherever the ones above take a reflection::Field.
+// The schema must outlive the index.
+class SchemaIndex {
+ public:
+  explicit SchemaIndex(const reflection::Schema &schema);
+
+  // Objects are looked up by their name in the schema. NULL if not found.
+  const ObjectDescriptor *LookupObject(const char *name) const;
+  const ObjectDescriptor *GetObjectDesc(
+      const reflection::Object &objectdef) const {
+    return LookupObject(objectdef.name()->c_str());
+  }
+  const ObjectDescriptor *GetObjectDesc(int index) const {
+    return &objects_[index];
+  }
+  const ObjectDescriptor *root_table() const { return root_table_; }
+
+  const FieldDescriptor *LookupField(const ObjectDescriptor &objectdesc,
+                                     const char *name) const;
+
+ private:
+  SchemaIndex(const SchemaIndex &);
+  SchemaIndex &operator=(const SchemaIndex &);
+
+  struct Slot {
+    uint32_t hash;
+    uint32_t index;  // Plus one, 0 for empty slots.
+  };
+
+  static uint32_t FieldHash(const ObjectDescriptor &objectdesc,
+                            uint32_t name_hash);
+  static void Insert(std::vector<Slot> &slots, uint32_t hash, size_t index);
+
+  std::vector<ObjectDescriptor> objects_;
+  std::vector<FieldDescriptor> fields_;
+  const ObjectDescriptor *root_table_;
+  // Open addressing tables (with a power of two size) of indices into
+  // objects_ and fields_.
+  std::vector<Slot> object_slots_;
+  std::vector<Slot> field_slots_;
+};
+
+template<typename T> T GetFieldI(const Table &table,
+                                 const FieldDescriptor &field) {
+  assert(sizeof(T) == GetTypeSize(field.base_type));
+  return table.GetField<T>(field.offset,
+                           static_cast<T>(field.default_integer));
+}
+
+template<typename T> T GetFieldF(const Table &table,
+                                 const FieldDescriptor &field) {
+  assert(sizeof(T) == GetTypeSize(field.base_type));
+  return table.GetField<T>(field.offset, static_cast<T>(field.default_real));
+}
+
+inline const String *GetFieldS(const Table &table,
+                               const FieldDescriptor &field) {
+  assert(field.base_type == reflection::String);
+  return table.GetPointer<const String *>(field.offset);
+}
+
+template<typename T> Vector<T> *GetFieldV(const Table &table,
+                                          const FieldDescriptor &field) {
+  assert(field.base_type == reflection::Vector &&
+         sizeof(T) == GetTypeSize(field.element));
+  return table.GetPointer<Vector<T> *>(field.offset);
+}
+
+inline VectorOfAny *GetFieldAnyV(const Table &table,
+                                 const FieldDescriptor &field) {
+  return table.GetPointer<VectorOfAny *>(field.offset);
+}
+
+inline Table *GetFieldT(const Table &table, const FieldDescriptor &field) {
+  assert(field.base_type == reflection::Obj ||
+         field.base_type == reflection::Union);
+  return table.GetPointer<Table *>(field.offset);
+}
+
+inline int64_t GetAnyFieldI(const Table &table, const FieldDescriptor &field) {
+  const uint8_t* field_ptr = table.GetAddressOf(field.offset);
+  return field_ptr ? GetAnyValueI(field.base_type, field_ptr)
+                   : field.default_integer;
+}
+
+inline double GetAnyFieldF(const Table &table, const FieldDescriptor &field) {
+  const uint8_t* field_ptr = table.GetAddressOf(field.offset);
+  return field_ptr ? GetAnyValueF(field.base_type, field_ptr)
+                   : field.default_real;
+}
+
+inline std::string GetAnyFieldS(const Table &table,
+                                const FieldDescriptor &field,
+                                const reflection::Schema *schema) {
+  const uint8_t* field_ptr = table.GetAddressOf(field.offset);
+  return field_ptr ? GetAnyValueS(field.base_type, field_ptr, schema,
+                                  field.type_index)
+                   : "";
+}
+
+inline int64_t GetAnyFieldI(const Struct &st, const FieldDescriptor &field) {
+  return GetAnyValueI(field.base_type, st.GetAddressOf(field.offset));
+}
+
+inline double GetAnyFieldF(const Struct &st, const FieldDescriptor &field) {
+  return GetAnyValueF(field.base_type, st.GetAddressOf(field.offset));
+}
+
+inline std::string GetAnyFieldS(const Struct &st,
+                                const FieldDescriptor &field) {
+  return GetAnyValueS(field.base_type, st.GetAddressOf(field.offset), NULL,
+                      -1);
+}
+
+template<typename T> T *GetAnyFieldAddressOf(const Table &table,
+                                             const FieldDescriptor &field) {
+  return (T *)table.GetAddressOf(field.offset);
+}
+
+template<typename T> T *GetAnyFieldAddressOf(const Struct &st,
+                                             const FieldDescriptor &field) {
+  return (T *)st.GetAddressOf(field.offset);
+}
+
+template<typename T> bool SetField(Table *table, const FieldDescriptor &field,
+                                   T val) {
+  assert(sizeof(T) == GetTypeSize(field.base_type));
+  return table->SetField(field.offset, val);
+}
+
+inline bool SetAnyFieldI(Table *table, const FieldDescriptor &field,
+                         int64_t val) {
+  uint8_t* field_ptr = table->GetAddressOf(field.offset);
+  if (!field_ptr) return false;
+  SetAnyValueI(field.base_type, field_ptr, val);
+  return true;
+}
+
+inline bool SetAnyFieldF(Table *table, const FieldDescriptor &field,
+                         double val) {
+  uint8_t* field_ptr = table->GetAddressOf(field.offset);
+  if (!field_ptr) return false;
+  SetAnyValueF(field.base_type, field_ptr, val);
+  return true;
+}
+
+inline bool SetAnyFieldS(Table *table, const FieldDescriptor &field,
+                         const char *val) {
+  uint8_t* field_ptr = table->GetAddressOf(field.offset);
+  if (!field_ptr) return false;
+  SetAnyValueS(field.base_type, field_ptr, val);
+  return true;
+}
+
+inline void SetAnyFieldI(Struct *st, const FieldDescriptor &field,
+                         int64_t val) {
+  SetAnyValueI(field.base_type, st->GetAddressOf(field.offset), val);
+}
+
+inline void SetAnyFieldF(Struct *st, const FieldDescriptor &field,
+                         double val) {
+  SetAnyValueF(field.base_type, st->GetAddressOf(field.offset), val);
+}
+
+inline void SetAnyFieldS(Struct *st, const FieldDescriptor &field,
+                         const char *val) {
+  SetAnyValueS(field.base_type, st->GetAddressOf(field.offset), val);
+}
+
+inline bool SetFieldT(Table *table, const FieldDescriptor &field,
+                      const uint8_t *val) {
+  assert(sizeof(uoffset_t) == GetTypeSize(field.base_type));
+  return table->SetPointer(field.offset, val);
+}
 
 }  // namespace flatbuffers
 
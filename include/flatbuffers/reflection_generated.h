@@ -85,6 +85,9 @@ struct EnumVal FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
   int64_t value() const { return GetField<int64_t>(6, 0); }
   bool KeyCompareLessThan(const EnumVal *o) const { return value() < o->value(); }
   int KeyCompareWithValue(int64_t val) const { return value() < val ? -1 : value() > val; }
+  uint64_t KeyIndexValue() const { return flatbuffers::KeyIndexValue(value()); }
+  static uint64_t KeyIndexValueAt(const flatbuffers::FlatBufferBuilder &fbb, flatbuffers::uoffset_t o) { return flatbuffers::KeyIndexValue(fbb.GetFieldAt<int64_t>(o, 6, 0)); }
+  static bool KeyIndexIsExact() { return true; }
   const Object *object() const { return GetPointer<const Object *>(8); }
   bool Verify(flatbuffers::Verifier &verifier) const {
     return VerifyTableStart(verifier) &&
@@ -127,6 +130,9 @@ struct Enum FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
   const flatbuffers::String *name() const { return GetPointer<const flatbuffers::String *>(4); }
   bool KeyCompareLessThan(const Enum *o) const { return *name() < *o->name(); }
   int KeyCompareWithValue(const char *val) const { return strcmp(name()->c_str(), val); }
+  uint64_t KeyIndexValue() const { return flatbuffers::KeyIndexValue(name()); }
+  static uint64_t KeyIndexValueAt(const flatbuffers::FlatBufferBuilder &fbb, flatbuffers::uoffset_t o) { return flatbuffers::KeyIndexValue(fbb.GetStringAt(o, 4)); }
+  static bool KeyIndexIsExact() { return false; }
   const flatbuffers::Vector<flatbuffers::Offset<EnumVal> > *values() const { return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<EnumVal> > *>(6); }
   uint8_t is_union() const { return GetField<uint8_t>(8, 0); }
   const Type *underlying_type() const { return GetPointer<const Type *>(10); }
@@ -179,6 +185,9 @@ struct Field FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
   const flatbuffers::String *name() const { return GetPointer<const flatbuffers::String *>(4); }
   bool KeyCompareLessThan(const Field *o) const { return *name() < *o->name(); }
   int KeyCompareWithValue(const char *val) const { return strcmp(name()->c_str(), val); }
+  uint64_t KeyIndexValue() const { return flatbuffers::KeyIndexValue(name()); }
+  static uint64_t KeyIndexValueAt(const flatbuffers::FlatBufferBuilder &fbb, flatbuffers::uoffset_t o) { return flatbuffers::KeyIndexValue(fbb.GetStringAt(o, 4)); }
+  static bool KeyIndexIsExact() { return false; }
   const Type *type() const { return GetPointer<const Type *>(6); }
   uint16_t id() const { return GetField<uint16_t>(8, 0); }
   uint16_t offset() const { return GetField<uint16_t>(10, 0); }
@@ -187,6 +196,7 @@ struct Field FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
   uint8_t deprecated() const { return GetField<uint8_t>(16, 0); }
   uint8_t required() const { return GetField<uint8_t>(18, 0); }
   uint8_t key() const { return GetField<uint8_t>(20, 0); }
+  uint8_t offset64() const { return GetField<uint8_t>(22, 0); }
   bool Verify(flatbuffers::Verifier &verifier) const {
     return VerifyTableStart(verifier) &&
            VerifyFieldRequired<flatbuffers::uoffset_t>(verifier, 4 /* name */) &&
@@ -200,6 +210,7 @@ struct Field FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
            VerifyField<uint8_t>(verifier, 16 /* deprecated */) &&
            VerifyField<uint8_t>(verifier, 18 /* required */) &&
            VerifyField<uint8_t>(verifier, 20 /* key */) &&
+           VerifyField<uint8_t>(verifier, 22 /* offset64 */) &&
            verifier.EndTable();
   }
 };
@@ -216,10 +227,11 @@ struct FieldBuilder {
   void add_deprecated(uint8_t deprecated) { fbb_.AddElement<uint8_t>(16, deprecated, 0); }
   void add_required(uint8_t required) { fbb_.AddElement<uint8_t>(18, required, 0); }
   void add_key(uint8_t key) { fbb_.AddElement<uint8_t>(20, key, 0); }
+  void add_offset64(uint8_t offset64) { fbb_.AddElement<uint8_t>(22, offset64, 0); }
   FieldBuilder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
   FieldBuilder &operator=(const FieldBuilder &);
   flatbuffers::Offset<Field> Finish() {
-    flatbuffers::Offset<Field> o = flatbuffers::Offset<Field>(fbb_.EndTable(start_, 9));
+    flatbuffers::Offset<Field> o = flatbuffers::Offset<Field>(fbb_.EndTable(start_, 10));
     fbb_.Required(o, 4);  // name
     fbb_.Required(o, 6);  // type
     return o;
@@ -235,7 +247,8 @@ inline flatbuffers::Offset<Field> CreateField(flatbuffers::FlatBufferBuilder &_f
    double default_real = 0.0,
    uint8_t deprecated = 0,
    uint8_t required = 0,
-   uint8_t key = 0) {
+   uint8_t key = 0,
+   uint8_t offset64 = 0) {
   FieldBuilder builder_(_fbb);
   builder_.add_default_real(default_real);
   builder_.add_default_integer(default_integer);
@@ -243,6 +256,7 @@ inline flatbuffers::Offset<Field> CreateField(flatbuffers::FlatBufferBuilder &_f
   builder_.add_name(name);
   builder_.add_offset(offset);
   builder_.add_id(id);
+  builder_.add_offset64(offset64);
   builder_.add_key(key);
   builder_.add_required(required);
   builder_.add_deprecated(deprecated);
@@ -253,6 +267,9 @@ struct Object FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
   const flatbuffers::String *name() const { return GetPointer<const flatbuffers::String *>(4); }
   bool KeyCompareLessThan(const Object *o) const { return *name() < *o->name(); }
   int KeyCompareWithValue(const char *val) const { return strcmp(name()->c_str(), val); }
+  uint64_t KeyIndexValue() const { return flatbuffers::KeyIndexValue(name()); }
+  static uint64_t KeyIndexValueAt(const flatbuffers::FlatBufferBuilder &fbb, flatbuffers::uoffset_t o) { return flatbuffers::KeyIndexValue(fbb.GetStringAt(o, 4)); }
+  static bool KeyIndexIsExact() { return false; }
   const flatbuffers::Vector<flatbuffers::Offset<Field> > *fields() const { return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<Field> > *>(6); }
   uint8_t is_struct() const { return GetField<uint8_t>(8, 0); }
   int32_t minalign() const { return GetField<int32_t>(10, 0); }
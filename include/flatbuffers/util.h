@@ -22,7 +22,10 @@
 #include <string>
 #include <sstream>
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
 #include <assert.h>
+#include <tr1/type_traits>
 #ifdef _WIN32
 #ifndef WIN32_LEAN_AND_MEAN
   #define WIN32_LEAN_AND_MEAN
@@ -35,45 +38,329 @@
 #include <direct.h>
 #else
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <limits.h>
 #endif
 
 namespace flatbuffers {
 
-// Convert an integer or floating point value to a string.
-// In contrast to std::stringstream, "char" values are
-// converted to a string of digits, and we don't use scientific notation.
-template<typename T> std::string NumToString(T t) {
-  std::stringstream ss;
-  ss << t;
-  return ss.str();
+// Fast, locale independent number formatting, used by NumToString below.
+// Floating point values are written with digits that always parse back to
+// exactly the same value, and are usually (though not always) the fewest
+// that do, using the Grisu2 algorithm by Florian Loitsch ("Printing
+// Floating-Point Numbers Quickly and Accurately with Integers"), in plain
+// decimal notation (no exponent).
+
+// The largest amount of chars any FormatNumber() call below writes
+// (the smallest denormal double takes 2 + 323 + 1 digits, plus a sign).
+static const size_t kMaxFormattedNumberSize = 328;
+
+// Writes the digits of val into buf, returns the amount of chars written.
+inline size_t FormatUnsigned(uint64_t val, char *buf) {
+  static const char digit_pairs[] =
+    "0001020304050607080910111213141516171819202122232425262728293031323334"
+    "3536373839404142434445464748495051525354555657585960616263646566676869"
+    "707172737475767778798081828384858687888990919293949596979899";
+  // Write the digits backwards, two at a time, into a temporary buffer.
+  char digits[20];
+  char *end = digits + sizeof(digits);
+  char *p = end;
+  while (val >= 100) {
+    size_t i = static_cast<size_t>(val % 100) * 2;
+    val /= 100;
+    *--p = digit_pairs[i + 1];
+    *--p = digit_pairs[i];
+  }
+  if (val >= 10) {
+    size_t i = static_cast<size_t>(val) * 2;
+    *--p = digit_pairs[i + 1];
+    *--p = digit_pairs[i];
+  } else {
+    *--p = static_cast<char>('0' + val);
+  }
+  memcpy(buf, p, end - p);
+  return end - p;
 }
-// Avoid char types used as character data.
-template<> inline std::string NumToString<signed char>(signed char t) {
-  return NumToString(static_cast<int>(t));
+
+inline size_t FormatSigned(int64_t val, char *buf) {
+  if (val >= 0) return FormatUnsigned(static_cast<uint64_t>(val), buf);
+  *buf = '-';
+  return 1 + FormatUnsigned(0 - static_cast<uint64_t>(val), buf + 1);
 }
-template<> inline std::string NumToString<unsigned char>(unsigned char t) {
-  return NumToString(static_cast<int>(t));
+
+namespace grisu {
+
+// A floating point number with a 64bit significand: f * 2^e.
+struct DiyFp {
+  DiyFp(uint64_t _f, int _e) : f(_f), e(_e) {}
+
+  DiyFp operator-(const DiyFp &o) const { return DiyFp(f - o.f, e); }
+
+  // Multiply and round to 64 bits.
+  DiyFp operator*(const DiyFp &o) const {
+    const uint64_t m32 = 0xFFFFFFFF;
+    uint64_t a = f >> 32, b = f & m32, c = o.f >> 32, d = o.f & m32;
+    uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+    uint64_t tmp = (bd >> 32) + (ad & m32) + (bc & m32);
+    tmp += 1U << 31;  // Round.
+    return DiyFp(ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), e + o.e + 64);
+  }
+
+  DiyFp Normalize() const {
+    DiyFp r = *this;
+    while (!(r.f & (static_cast<uint64_t>(1) << 63))) { r.f <<= 1; r.e--; }
+    return r;
+  }
+
+  uint64_t f;
+  int e;
+};
+
+// Cached powers of ten: 10^k for k = -348, -340, ..., 340, normalized.
+inline DiyFp CachedPower(size_t index) {
+  static const uint64_t significands[] = {
+    0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL,
+    0xcf42894a5dce35eaULL, 0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL,
+    0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL, 0xbe5691ef416bd60cULL,
+    0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+    0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL,
+    0xc21094364dfb5637ULL, 0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL,
+    0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL, 0xb23867fb2a35b28eULL,
+    0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+    0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL,
+    0xb5b5ada8aaff80b8ULL, 0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL,
+    0x964e858c91ba2655ULL, 0xdff9772470297ebdULL, 0xa6dfbd9fb8e5b88fULL,
+    0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+    0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL,
+    0xaa242499697392d3ULL, 0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL,
+    0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL, 0x9c40000000000000ULL,
+    0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+    0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL,
+    0x9f4f2726179a2245ULL, 0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL,
+    0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL, 0x924d692ca61be758ULL,
+    0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+    0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL,
+    0x952ab45cfa97a0b3ULL, 0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL,
+    0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL, 0x88fcf317f22241e2ULL,
+    0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+    0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL,
+    0x8bab8eefb6409c1aULL, 0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL,
+    0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL, 0x80444b5e7aa7cf85ULL,
+    0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+    0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL
+  };
+  static const int16_t exponents[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+    -954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+    -688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+    -422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+    -157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+    109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+    641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+    907, 933, 960, 986, 1013, 1039, 1066
+  };
+  return DiyFp(significands[index], exponents[index]);
 }
 
-// Special versions for floats/doubles.
-template<> inline std::string NumToString<double>(double t) {
-  // to_string() prints different numbers of digits for floats depending on
-  // platform and isn't available on Android, so we use stringstream
-  std::stringstream ss;
-  // Use std::fixed to surpress scientific notation.
-  ss << std::fixed << t;
-    std::string s = ss.str();
-  // Sadly, std::fixed turns "1" into "1.00000", so here we undo that.
-  size_t p = s.find_last_not_of('0');
-  if (p != std::string::npos) {
-    s.resize(p + 1);  // Strip trailing zeroes.
-    if (s[s.size()-1] == '.') s.erase(s.size()-1, 1);  // Strip '.' if a whole number.
+// Get a cached power c such that w * c has a binary exponent in [-60, -32],
+// with k its decimal exponent negated.
+inline DiyFp CachedPowerForExponent(int e, int *k) {
+  double dk = (-61 - e) * 0.30102999566398114 + 347;  // dk must be positive.
+  int ik = static_cast<int>(dk);
+  if (dk - ik > 0.0) ik++;
+  size_t index = static_cast<size_t>((ik >> 3) + 1);
+  *k = -(-348 + static_cast<int>(index << 3));
+  return CachedPower(index);
+}
+
+inline void Round(char *buffer, int len, uint64_t delta, uint64_t rest,
+                  uint64_t ten_kappa, uint64_t wp_w) {
+  while (rest < wp_w && delta - rest >= ten_kappa &&
+         (rest + ten_kappa < wp_w ||  // Closer.
+          wp_w - rest > rest + ten_kappa - wp_w)) {
+    buffer[len - 1]--;
+    rest += ten_kappa;
   }
-  return s;
 }
-template<> inline std::string NumToString<float>(float t) {
-  return NumToString(static_cast<double>(t));
+
+// Generate as few digits as possible for w, which lies within
+// [mp - delta, mp].
+inline void DigitGen(const DiyFp &w, const DiyFp &mp, uint64_t delta,
+                     char *buffer, int *len, int *k) {
+  static const uint64_t pow10[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+    10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+    100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+    100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+    100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+  };
+  const DiyFp one(static_cast<uint64_t>(1) << -mp.e, mp.e);
+  const DiyFp wp_w = mp - w;
+  uint32_t p1 = static_cast<uint32_t>(mp.f >> -one.e);
+  uint64_t p2 = mp.f & (one.f - 1);
+  int kappa = 1;
+  while (kappa < 10 && p1 >= pow10[kappa]) kappa++;
+  *len = 0;
+  // Integral part.
+  while (kappa > 0) {
+    uint32_t div = static_cast<uint32_t>(pow10[kappa - 1]);
+    uint32_t d = p1 / div;
+    p1 %= div;
+    if (d || *len) buffer[(*len)++] = static_cast<char>('0' + d);
+    kappa--;
+    uint64_t rest = (static_cast<uint64_t>(p1) << -one.e) + p2;
+    if (rest <= delta) {
+      *k += kappa;
+      Round(buffer, *len, delta, rest, pow10[kappa] << -one.e, wp_w.f);
+      return;
+    }
+  }
+  // Fractional part.
+  for (;;) {
+    p2 *= 10;
+    delta *= 10;
+    char d = static_cast<char>(p2 >> -one.e);
+    if (d || *len) buffer[(*len)++] = static_cast<char>('0' + d);
+    p2 &= one.f - 1;
+    kappa--;
+    if (p2 < delta) {
+      *k += kappa;
+      int index = -kappa;
+      Round(buffer, *len, delta, p2, one.f,
+            wp_w.f * (index < 20 ? pow10[index] : 0));
+      return;
+    }
+  }
+}
+
+// Generate digits for the positive value v = f * 2^e that round-trip and are
+// usually the shortest, such that value = digits * 10^k. hidden_bit is the
+// implicit leading bit of the floating point type v came from, which
+// determines its neighbours.
+inline void Grisu2(uint64_t f, int e, uint64_t hidden_bit, char *buffer,
+                   int *len, int *k) {
+  const DiyFp v(f, e);
+  // The boundaries halfway to the neighbouring values: those may still be
+  // printed instead of v, as they round back to it. The lower neighbour is
+  // closer if f is a power of two.
+  DiyFp plus = DiyFp((f << 1) + 1, e - 1).Normalize();
+  DiyFp minus = f == hidden_bit ? DiyFp((f << 2) - 1, e - 2)
+                                : DiyFp((f << 1) - 1, e - 1);
+  minus.f <<= minus.e - plus.e;
+  minus.e = plus.e;
+  const DiyFp c_mk = CachedPowerForExponent(plus.e, k);
+  const DiyFp w = v.Normalize() * c_mk;
+  DiyFp wp = plus * c_mk;
+  DiyFp wm = minus * c_mk;
+  wm.f++;
+  wp.f--;
+  DigitGen(w, wp, wp.f - wm.f, buffer, len, k);
+}
+
+// Write digits * 10^k in decimal notation.
+inline size_t FormatDecimal(const char *digits, int len, int k, char *buf) {
+  char *p = buf;
+  int point = len + k;  // Position of the decimal point.
+  if (k >= 0) {
+    memcpy(p, digits, len);
+    p += len;
+    memset(p, '0', k);
+    p += k;
+  } else if (point > 0) {
+    memcpy(p, digits, point);
+    p += point;
+    *p++ = '.';
+    memcpy(p, digits + point, len - point);
+    p += len - point;
+  } else {
+    *p++ = '0';
+    *p++ = '.';
+    memset(p, '0', -point);
+    p += -point;
+    memcpy(p, digits, len);
+    p += len;
+  }
+  return p - buf;
+}
+
+// Shared by doubles and floats: bits is the IEEE representation, with
+// significand_size explicitly stored bits and an exponent_size bits exponent.
+inline size_t FormatFloatingPoint(uint64_t bits, int significand_size,
+                                  int exponent_size, char *buf) {
+  char *p = buf;
+  uint64_t hidden_bit = static_cast<uint64_t>(1) << significand_size;
+  uint64_t significand = bits & (hidden_bit - 1);
+  int exponent_mask = (1 << exponent_size) - 1;
+  int biased_e = static_cast<int>(bits >> significand_size) & exponent_mask;
+  if (bits >> (significand_size + exponent_size)) *p++ = '-';
+  if (biased_e == exponent_mask) {
+    const char *special = significand ? "nan" : "inf";
+    if (significand) p = buf;  // No sign for nan.
+    memcpy(p, special, 3);
+    return p + 3 - buf;
+  }
+  if (!biased_e && !significand) {
+    *p++ = '0';
+    return p - buf;
+  }
+  int bias = (exponent_mask >> 1) + significand_size;
+  uint64_t f = biased_e ? significand + hidden_bit : significand;
+  int e = biased_e ? biased_e - bias : 1 - bias;
+  char digits[20];
+  int len, k;
+  Grisu2(f, e, hidden_bit, digits, &len, &k);
+  return p - buf + FormatDecimal(digits, len, k, p);
+}
+
+}  // namespace grisu
+
+inline size_t FormatDouble(double val, char *buf) {
+  uint64_t bits;
+  memcpy(&bits, &val, sizeof(bits));
+  return grisu::FormatFloatingPoint(bits, 52, 11, buf);
+}
+
+inline size_t FormatFloat(float val, char *buf) {
+  uint32_t bits;
+  memcpy(&bits, &val, sizeof(bits));
+  return grisu::FormatFloatingPoint(bits, 23, 8, buf);
+}
+
+// Writes any integer or floating point value into buf (which must have room
+// for kMaxFormattedNumberSize chars), returns the amount of chars written.
+// Like NumToString, "char" values are written as a number.
+template<typename T> size_t FormatNumber(T t, char *buf) {
+  return std::tr1::is_signed<T>::value
+    ? FormatSigned(static_cast<int64_t>(t), buf)
+    : FormatUnsigned(static_cast<uint64_t>(t), buf);
+}
+template<> inline size_t FormatNumber<double>(double t, char *buf) {
+  return FormatDouble(t, buf);
+}
+template<> inline size_t FormatNumber<float>(float t, char *buf) {
+  return FormatFloat(t, buf);
+}
+
+template<typename T> std::string NumToStringImpl(T t, std::tr1::true_type) {
+  char buf[kMaxFormattedNumberSize];
+  return std::string(buf, FormatNumber(t, buf));
+}
+template<typename T> std::string NumToStringImpl(T t, std::tr1::false_type) {
+  std::stringstream ss;
+  ss << t;
+  return ss.str();
+}
+
+// Convert an integer or floating point value to a string.
+// In contrast to std::stringstream, "char" values are
+// converted to a string of digits, and we don't use scientific notation.
+// Floating point values are written such that they parse back to exactly
+// the same value. Other types (e.g. enums) use std::stringstream.
+template<typename T> std::string NumToString(T t) {
+  return NumToStringImpl(t, std::tr1::is_arithmetic<T>());
 }
 
 // Convert an integer value to a hexadecimal string.
@@ -91,6 +378,23 @@ inline std::string IntToStringHex(int i, int xdigits) {
 
 // Portable implementation of strtoull().
 inline int64_t StringToInt(const char *str, int base = 10) {
+  // Plain decimal numbers (what the parser produces for nearly all integer
+  // constants) are converted inline. Up to 18 digits can't overflow, anything
+  // longer or more exotic is left to the C library.
+  if (base == 10) {
+    const char *p = str;
+    bool negative = *p == '-';
+    if (negative) p++;
+    const char *digits = p;
+    uint64_t val = 0;
+    while (*p >= '0' && *p <= '9' && p - digits < 19) {
+      val = val * 10 + static_cast<uint64_t>(*p - '0');
+      p++;
+    }
+    if (p != digits && p - digits < 19) {
+      return static_cast<int64_t>(negative ? 0 - val : val);
+    }
+  }
   #ifdef _MSC_VER
     return _strtoui64(str, NULL, base);
   #else
@@ -137,6 +441,129 @@ inline bool SaveFile(const char *name, const std::string &buf, bool binary) {
   return SaveFile(name, buf.c_str(), buf.size(), binary);
 }
 
+// A read-only memory mapping of a file. Unlike LoadFile, nothing is read
+// or copied up front: pages are read when first accessed, and are shared
+// through the page cache with other processes mapping the same file.
+// data() can be passed straight to Verifier, GetRoot<T>() or GetAnyRoot().
+class MappedFile {
+ public:
+  // How the mapping is going to be accessed, to tune read-ahead.
+  enum Access {
+    kAccessNormal,
+    kAccessRandom,      // E.g. lookups in a large buffer: no read-ahead.
+    kAccessSequential,  // E.g. converting all of a buffer: more read-ahead.
+    kAccessWillNeed     // Start reading all of the file in now.
+  };
+
+  MappedFile() : data_(NULL), size_(0) {}
+  ~MappedFile() { Unmap(); }
+
+  // Maps file "name", returning true if successful. Empty files map to a
+  // NULL data() of size 0. With "huge_pages", asks for transparent huge
+  // pages (Linux only, where the filesystem supports them), which means
+  // fewer TLB misses for random access to large files.
+  bool Map(const char *name, Access access = kAccessNormal,
+           bool huge_pages = false) {
+    Unmap();
+    #ifdef _WIN32
+      (void)huge_pages;
+      HANDLE file = CreateFileA(name, GENERIC_READ, FILE_SHARE_READ, NULL,
+                                OPEN_EXISTING,
+                                access == kAccessRandom
+                                  ? FILE_FLAG_RANDOM_ACCESS
+                                  : access == kAccessSequential
+                                    ? FILE_FLAG_SEQUENTIAL_SCAN
+                                    : FILE_ATTRIBUTE_NORMAL,
+                                NULL);
+      if (file == INVALID_HANDLE_VALUE) return false;
+      LARGE_INTEGER size;
+      bool ok = GetFileSizeEx(file, &size) != 0 &&
+                static_cast<uint64_t>(size.QuadPart) <=
+                  static_cast<size_t>(-1);
+      if (ok && size.QuadPart) {
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0,
+                                            NULL);
+        ok = mapping != NULL;
+        if (ok) {
+          data_ = static_cast<uint8_t *>(MapViewOfFile(mapping, FILE_MAP_READ,
+                                                       0, 0, 0));
+          // The view keeps the mapping alive.
+          CloseHandle(mapping);
+          ok = data_ != NULL;
+          if (ok) size_ = static_cast<size_t>(size.QuadPart);
+        }
+      }
+      CloseHandle(file);
+      return ok;
+    #else
+      int fd = open(name, O_RDONLY);
+      if (fd < 0) return false;
+      struct stat st;
+      bool ok = fstat(fd, &st) == 0 &&
+                static_cast<uint64_t>(st.st_size) <= static_cast<size_t>(-1);
+      if (ok && st.st_size) {
+        void *data = mmap(NULL, static_cast<size_t>(st.st_size), PROT_READ,
+                          MAP_SHARED, fd, 0);
+        ok = data != MAP_FAILED;
+        if (ok) {
+          data_ = static_cast<uint8_t *>(data);
+          size_ = static_cast<size_t>(st.st_size);
+          #ifdef MADV_HUGEPAGE
+            if (huge_pages) madvise(data_, size_, MADV_HUGEPAGE);
+          #else
+            (void)huge_pages;
+          #endif
+          Advise(access);
+        }
+      }
+      // The mapping keeps the file alive.
+      close(fd);
+      return ok;
+    #endif
+  }
+
+  // Changes the access hint for all of the mapping. Only a hint, so it
+  // returns false where not supported, with the mapping still usable.
+  bool Advise(Access access) {
+    if (!data_) return false;
+    #ifdef _WIN32
+      (void)access;
+      return false;
+    #else
+      int advice = MADV_NORMAL;
+      switch (access) {
+        case kAccessNormal:     advice = MADV_NORMAL; break;
+        case kAccessRandom:     advice = MADV_RANDOM; break;
+        case kAccessSequential: advice = MADV_SEQUENTIAL; break;
+        case kAccessWillNeed:   advice = MADV_WILLNEED; break;
+      }
+      return madvise(data_, size_, advice) == 0;
+    #endif
+  }
+
+  void Unmap() {
+    if (data_) {
+      #ifdef _WIN32
+        UnmapViewOfFile(data_);
+      #else
+        munmap(data_, size_);
+      #endif
+    }
+    data_ = NULL;
+    size_ = 0;
+  }
+
+  const uint8_t *data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  MappedFile(const MappedFile &);
+  MappedFile &operator=(const MappedFile &);
+
+  uint8_t *data_;
+  size_t size_;
+};
+
 // Functionality for minimalistic portable path handling:
 
 static const char kPosixPathSeparator = '/';
@@ -24,4 +24,13 @@ else:
         memoryview_type = memoryview
         struct_bool_decl = "?"
 
+
+def import_numpy():
+    """ Returns the numpy module if it is installed, or None otherwise. """
+    try:
+        import numpy
+    except ImportError:
+        return None
+    return numpy
+
 # NOTE: Future Jython support may require code here (look at `six`).
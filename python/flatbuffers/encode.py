@@ -13,10 +13,14 @@
 # limitations under the License.
 
 import ctypes
+import struct
+import sys
 
 from . import number_types as N
 from . import packer
-from .compat import memoryview_type
+from .compat import import_numpy, memoryview_type
+
+numpy = import_numpy()
 
 
 def Get(packer_type, buf, head):
@@ -27,3 +31,22 @@ def Get(packer_type, buf, head):
 def Write(packer_type, buf, head, n):
     """ Write encodes `n` at buf[head:] using `packer_type`. """
     packer_type.pack_into(buf, head, n)
+
+
+def GetArray(flags, buf, head, count):
+    """ GetArray decodes `count` consecutive values of the type specified by
+    `flags` at buf[head:], without a call per value. The result is a
+    numpy.ndarray sharing memory with `buf` if NumPy is installed, else a
+    memoryview of it if the host is little endian and memoryviews can be
+    cast (Python 3.3+), else a tuple. """
+    fmt = flags.packer_type.format
+    if not isinstance(fmt, str):
+        fmt = fmt.decode("ascii")
+    fmt = fmt[-1]  # Without the byte order.
+    if numpy is not None:
+        return numpy.frombuffer(buf, dtype=numpy.dtype("<" + fmt),
+                                count=count, offset=head)
+    if sys.byteorder == "little" and hasattr(memoryview_type, "cast"):
+        view = memoryview_type(buf)[head:head + count * flags.bytewidth]
+        return view.cast(fmt)
+    return struct.unpack_from("<%d%s" % (count, fmt), buf, head)
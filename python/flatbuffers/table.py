@@ -74,6 +74,17 @@ class Table(object):
         x += N.UOffsetTFlags.bytewidth
         return x
 
+    def VectorAsArray(self, flags, off, width=1):
+        """VectorAsArray retrieves all elements of the vector of scalars (of
+           the type specified by `flags`) whose offset is stored at "off" in
+           this object at once, see encode.GetArray. For vectors of structs,
+           pass Uint8Flags and the size of the struct as `width`, to get
+           their bytes."""
+        N.enforce_number(off, N.UOffsetTFlags)
+
+        count = self.VectorLen(off) * width
+        return encode.GetArray(flags, self.Bytes, self.Vector(off), count)
+
     def Union(self, t2, off):
         """Union initializes any Table-derived type to point to the union at
            the given offset."""
@@ -39,6 +39,8 @@ inline const char *EnumNameAny(Any e) { return EnumNamesAny()[e]; }
 
 inline bool VerifyAny(flatbuffers::Verifier &verifier, const void *union_obj, Any type);
 
+inline bool VerifyAnyLazily(flatbuffers::Verifier &verifier, const void *union_obj, Any type);
+
 MANUALLY_ALIGNED_STRUCT(4) Vec3 FLATBUFFERS_FINAL_CLASS {
  private:
   float x_;
@@ -69,6 +71,7 @@ struct Monster FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
   flatbuffers::String *mutable_name() { return GetPointer<flatbuffers::String *>(10); }
   const flatbuffers::Vector<uint8_t > *inventory() const { return GetPointer<const flatbuffers::Vector<uint8_t > *>(14); }
   flatbuffers::Vector<uint8_t > *mutable_inventory() { return GetPointer<flatbuffers::Vector<uint8_t > *>(14); }
+  flatbuffers::VectorView<uint8_t> inventory_view() const { return flatbuffers::VectorView<uint8_t>(inventory()); }
   Color color() const { return static_cast<Color>(GetField<int8_t>(16, 2)); }
   bool mutate_color(Color color) { return SetField(16, static_cast<int8_t>(color)); }
   bool Verify(flatbuffers::Verifier &verifier) const {
@@ -83,6 +86,18 @@ struct Monster FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
            VerifyField<int8_t>(verifier, 16 /* color */) &&
            verifier.EndTable();
   }
+  bool VerifyShallow(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<Vec3>(verifier, 4 /* pos */) &&
+           VerifyField<int16_t>(verifier, 6 /* mana */) &&
+           VerifyField<int16_t>(verifier, 8 /* hp */) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, 10 /* name */) &&
+           verifier.Verify(name()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, 14 /* inventory */) &&
+           verifier.Verify(inventory()) &&
+           VerifyField<int8_t>(verifier, 16 /* color */) &&
+           verifier.EndTable();
+  }
 };
 
 struct MonsterBuilder {
@@ -127,12 +142,22 @@ inline bool VerifyAny(flatbuffers::Verifier &verifier, const void *union_obj, An
   }
 }
 
+inline bool VerifyAnyLazily(flatbuffers::Verifier &verifier, const void *union_obj, Any type) {
+  switch (type) {
+    case Any_NONE: return true;
+    case Any_Monster: return verifier.VerifyTableLazily(reinterpret_cast<const Monster *>(union_obj)) != NULL;
+    default: return false;
+  }
+}
+
 inline const MyGame::Sample::Monster *GetMonster(const void *buf) { return flatbuffers::GetRoot<MyGame::Sample::Monster>(buf); }
 
 inline Monster *GetMutableMonster(void *buf) { return flatbuffers::GetMutableRoot<Monster>(buf); }
 
 inline bool VerifyMonsterBuffer(flatbuffers::Verifier &verifier) { return verifier.VerifyBuffer<MyGame::Sample::Monster>(); }
 
+inline const MyGame::Sample::Monster *GetMonsterLazily(flatbuffers::Verifier &verifier) { return verifier.VerifyRootLazily<MyGame::Sample::Monster>(); }
+
 inline void FinishMonsterBuffer(flatbuffers::FlatBufferBuilder &fbb, flatbuffers::Offset<MyGame::Sample::Monster> root) { fbb.Finish(root); }
 
 }  // namespace Sample
@@ -16,8 +16,19 @@
 
 #include "flatbuffers/flatbuffers.h"
 #include "flatbuffers/idl.h"
+#include "flatbuffers/reflection.h"
 #include "flatbuffers/util.h"
 
+#ifdef _WIN32
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #include <windows.h>
+  #include <process.h>
+#else
+  #include <pthread.h>
+#endif
+
 static void Error(const std::string &err, bool usage = false,
                   bool show_exe_name = true);
 
@@ -31,6 +42,7 @@ struct Generator {
   const char *generator_opt;
   const char *lang_name;
   flatbuffers::GeneratorOptions::Language lang;
+  bool offset64;  // Supports fields with the offset64 attribute.
   const char *generator_help;
 
   std::string (*make_rule)(const flatbuffers::Parser &parser,
@@ -41,36 +53,315 @@ struct Generator {
 
 const Generator generators[] = {
   { flatbuffers::GenerateBinary,   "-b", "binary",
-    flatbuffers::GeneratorOptions::kMAX,
+    flatbuffers::GeneratorOptions::kMAX, true,
     "Generate wire format binaries for any data definitions",
     flatbuffers::BinaryMakeRule },
   { flatbuffers::GenerateTextFile, "-t", "text",
-    flatbuffers::GeneratorOptions::kMAX,
+    flatbuffers::GeneratorOptions::kMAX, true,
     "Generate text output for any data definitions",
     flatbuffers::TextMakeRule },
   { flatbuffers::GenerateCPP,      "-c", "C++",
-    flatbuffers::GeneratorOptions::kMAX,
+    flatbuffers::GeneratorOptions::kMAX, true,
     "Generate C++ headers for tables/structs",
     flatbuffers::CPPMakeRule },
   { flatbuffers::GenerateGo,       "-g", "Go",
-    flatbuffers::GeneratorOptions::kGo,
+    flatbuffers::GeneratorOptions::kGo, false,
     "Generate Go files for tables/structs",
     flatbuffers::GeneralMakeRule },
   { flatbuffers::GenerateGeneral,  "-j", "Java",
-    flatbuffers::GeneratorOptions::kJava,
+    flatbuffers::GeneratorOptions::kJava, false,
     "Generate Java classes for tables/structs",
     flatbuffers::GeneralMakeRule },
   { flatbuffers::GenerateGeneral,  "-n", "C#",
-    flatbuffers::GeneratorOptions::kCSharp,
+    flatbuffers::GeneratorOptions::kCSharp, false,
     "Generate C# classes for tables/structs",
     flatbuffers::GeneralMakeRule },
   { flatbuffers::GeneratePython,   "-p", "Python",
-    flatbuffers::GeneratorOptions::kMAX,
+    flatbuffers::GeneratorOptions::kMAX, false,
     "Generate Python files for tables/structs",
     flatbuffers::GeneralMakeRule },
 };
 
 const char *program_name = NULL;
+const size_t num_generators = sizeof(generators) / sizeof(generators[0]);
+
+// Called by RunTasks() for every task index, thread is the index of the
+// thread it runs on.
+typedef void (*Task)(void *context, size_t thread, size_t index);
+
+struct Worker {
+  Task task;
+  void *context;
+  size_t thread;
+  size_t num_threads;
+  size_t num_tasks;
+};
+
+static void RunWorker(const Worker &worker) {
+  for (size_t i = worker.thread; i < worker.num_tasks; i += worker.num_threads)
+    worker.task(worker.context, worker.thread, i);
+}
+
+#ifdef _WIN32
+static unsigned __stdcall WorkerThread(void *worker) {
+  RunWorker(*static_cast<Worker *>(worker));
+  return 0;
+}
+#else
+static void *WorkerThread(void *worker) {
+  RunWorker(*static_cast<Worker *>(worker));
+  return NULL;
+}
+#endif
+
+// Run num_tasks tasks on up to num_threads threads, the calling thread being
+// one of them. Thread t runs tasks t, t + num_threads, etc., so results can't
+// depend on timing as long as tasks only touch their own data (and that of
+// their thread).
+static void RunTasks(size_t num_tasks, size_t num_threads, Task task,
+                     void *context) {
+  num_threads = std::max(static_cast<size_t>(1),
+                         std::min(num_threads, num_tasks));
+  std::vector<Worker> workers(num_threads);
+  for (size_t t = 0; t < num_threads; t++) {
+    Worker worker = { task, context, t, num_threads, num_tasks };
+    workers[t] = worker;
+  }
+  #ifdef _WIN32
+    std::vector<HANDLE> threads(num_threads, static_cast<HANDLE>(NULL));
+  #else
+    std::vector<pthread_t> threads(num_threads);
+  #endif
+  std::vector<char> started(num_threads, false);
+  for (size_t t = 1; t < num_threads; t++) {
+    #ifdef _WIN32
+      threads[t] = reinterpret_cast<HANDLE>(
+                     _beginthreadex(NULL, 0, WorkerThread, &workers[t], 0,
+                                    NULL));
+      started[t] = threads[t] != NULL;
+    #else
+      started[t] = pthread_create(&threads[t], NULL, WorkerThread,
+                                  &workers[t]) == 0;
+    #endif
+  }
+  RunWorker(workers[0]);
+  for (size_t t = 1; t < num_threads; t++) {
+    if (!started[t]) {
+      // Couldn't get a thread, do its share here instead.
+      RunWorker(workers[t]);
+      continue;
+    }
+    #ifdef _WIN32
+      WaitForSingleObject(threads[t], INFINITE);
+      CloseHandle(threads[t]);
+    #else
+      pthread_join(threads[t], NULL);
+    #endif
+  }
+}
+
+// The generators enabled for one input file, which all only read from the
+// same parser, so can run in parallel.
+struct GeneratorRun {
+  const flatbuffers::Parser *parser;
+  const std::string *output_path;
+  const std::string *filebase;
+  const flatbuffers::GeneratorOptions *opts;
+  std::vector<size_t> generators;  // Indices into generators[].
+  std::vector<char> ok;
+};
+
+static void RunGenerator(void *context, size_t /*thread*/, size_t index) {
+  GeneratorRun &run = *static_cast<GeneratorRun *>(context);
+  const Generator &generator = generators[run.generators[index]];
+  flatbuffers::GeneratorOptions opts = *run.opts;
+  opts.lang = generator.lang;
+  run.ok[index] = generator.generate(*run.parser, *run.output_path,
+                                     *run.filebase, opts);
+}
+
+// Returns a field with the offset64 attribute that code is generated for,
+// or NULL if there are none.
+static const flatbuffers::FieldDef *FindOffset64Field(
+    const flatbuffers::Parser &parser) {
+  for (std::vector<flatbuffers::StructDef *>::const_iterator it =
+         parser.structs_.vec.begin(); it != parser.structs_.vec.end(); ++it) {
+    if ((*it)->generated) continue;
+    const std::vector<flatbuffers::FieldDef *> &fields = (*it)->fields.vec;
+    for (std::vector<flatbuffers::FieldDef *>::const_iterator field_it =
+           fields.begin(); field_it != fields.end(); ++field_it) {
+      if ((*field_it)->offset64) return *field_it;
+    }
+  }
+  return NULL;
+}
+
+// --stats are printed as "stats: <what>: name=value ...", one line each.
+static void PrintBuilderStats(const std::string &filename,
+                              const flatbuffers::FlatBufferBuilder &builder) {
+  flatbuffers::BuilderStats stats = builder.GetStats();
+  printf("stats: %s: size=%u reallocations=%lu chunks=%lu padding_bytes=%lu "
+         "vtables_created=%lu vtables_reused=%lu forced_default_bytes=%lu\n",
+         filename.c_str(), builder.GetSize(),
+         static_cast<unsigned long>(stats.reallocations),
+         static_cast<unsigned long>(stats.chunks),
+         static_cast<unsigned long>(stats.padding_bytes),
+         static_cast<unsigned long>(stats.vtables_created),
+         static_cast<unsigned long>(stats.vtables_reused),
+         static_cast<unsigned long>(stats.forced_default_bytes));
+}
+
+static void PrintParserStats(const flatbuffers::ParserStats &stats) {
+  printf("stats: parser: bytes=%lu tokens=%lu json_objects=%lu "
+         "schema_seconds=%.6f json_seconds=%.6f\n",
+         static_cast<unsigned long>(stats.bytes),
+         static_cast<unsigned long>(stats.tokens),
+         static_cast<unsigned long>(stats.json_objects),
+         stats.schema_seconds, stats.json_seconds);
+}
+
+// The schema parsed so far, serialized as for --schema, and compiled into a
+// BufferCompactor for --compact. Only redone when the schema has changed:
+// schemas parsed later can only add types, or set the root type or file
+// identifier.
+class CompactSchema {
+ public:
+  CompactSchema()
+    : compactor_(NULL), num_structs_(0), num_enums_(0), root_(NULL) {}
+  ~CompactSchema() { delete compactor_; }
+
+  // Uses (and clears) parser.builder_ if the schema has to be serialized.
+  const flatbuffers::BufferCompactor &Get(flatbuffers::Parser &parser) {
+    if (!compactor_ || num_structs_ != parser.structs_.vec.size() ||
+        num_enums_ != parser.enums_.vec.size() ||
+        root_ != parser.root_struct_def_ ||
+        file_identifier_ != parser.file_identifier_) {
+      delete compactor_;
+      parser.Serialize();
+      schema_.assign(
+        reinterpret_cast<const char *>(parser.builder_.GetBufferPointer()),
+        parser.builder_.GetSize());
+      parser.builder_.Clear();
+      compactor_ = new flatbuffers::BufferCompactor(
+        *reflection::GetSchema(schema_.c_str()));
+      num_structs_ = parser.structs_.vec.size();
+      num_enums_ = parser.enums_.vec.size();
+      root_ = parser.root_struct_def_;
+      file_identifier_ = parser.file_identifier_;
+    }
+    return *compactor_;
+  }
+
+ private:
+  std::string schema_;
+  flatbuffers::BufferCompactor *compactor_;
+  size_t num_structs_;
+  size_t num_enums_;
+  const flatbuffers::StructDef *root_;
+  std::string file_identifier_;
+};
+
+// Replaces the buffer in builder with a copy in which identical objects are
+// only stored once (--compact). Returns false if the buffer doesn't verify.
+static bool CompactData(const flatbuffers::BufferCompactor &compactor,
+                        flatbuffers::FlatBufferBuilder &builder) {
+  flatbuffers::FlatBufferBuilder compacted;
+  if (!compactor.Compact(builder.GetBufferPointer(), builder.GetSize(),
+                         &compacted))
+    return false;
+  builder.Clear();
+  builder.PushBytes(compacted.GetBufferPointer(), compacted.GetSize());
+  return true;
+}
+
+// Files that hold only data (JSON or binary) can't change the schema, so a
+// run of them can be processed in parallel, each thread having its own
+// JsonConverter. To end up with the same outputs and errors as processing
+// them one by one, this happens in two passes: first every file in the batch
+// is loaded and converted, then the files before the first one that failed
+// are written out. A failed file may simply be a schema rather than JSON, and
+// is left to regular processing, which also reports any errors.
+struct DataBatch {
+  const std::vector<std::string> *filenames;
+  size_t binary_files_from;
+  bool raw_binary;
+  const std::string *file_identifier;
+  // For --compact (else NULL).
+  const flatbuffers::BufferCompactor *compactor;
+  const std::string *output_path;
+  const flatbuffers::GeneratorOptions *opts;
+  const bool *generator_enabled;
+  std::vector<flatbuffers::JsonConverter *> converters;  // One per thread.
+  size_t begin;
+  std::vector<std::string> buffers;  // Per file, from begin.
+  std::vector<char> converted;
+  std::vector<size_t> failed_generator;  // num_generators if none failed.
+};
+
+static flatbuffers::FlatBufferBuilder &LoadBuffer(
+    flatbuffers::JsonConverter &converter, const std::string &buffer) {
+  flatbuffers::FlatBufferBuilder &builder = converter.builder();
+  builder.Clear();
+  builder.PushBytes(reinterpret_cast<const uint8_t *>(buffer.c_str()),
+                    buffer.length());
+  return builder;
+}
+
+static void ConvertDataFile(void *context, size_t thread, size_t index) {
+  DataBatch &batch = *static_cast<DataBatch *>(context);
+  size_t file = batch.begin + index;
+  std::string contents;
+  if (!flatbuffers::LoadFile((*batch.filenames)[file].c_str(), true,
+                             &contents))
+    return;
+  flatbuffers::JsonConverter &converter = *batch.converters[thread];
+  if (file >= batch.binary_files_from) {
+    // The same checks as for serial processing below.
+    if (!batch.raw_binary &&
+        (!batch.file_identifier->length() ||
+         !flatbuffers::BufferHasIdentifier(contents.c_str(),
+                                           batch.file_identifier->c_str())))
+      return;
+    if (!batch.compactor) {
+      batch.buffers[index].swap(contents);
+      batch.converted[index] = true;
+      return;
+    }
+    LoadBuffer(converter, contents);
+  } else if (!converter.Convert(contents.c_str())) {
+    return;
+  }
+  flatbuffers::FlatBufferBuilder &builder = converter.builder();
+  if (batch.compactor && !CompactData(*batch.compactor, builder)) return;
+  batch.buffers[index].assign(
+    reinterpret_cast<const char *>(builder.GetBufferPointer()),
+    builder.GetSize());
+  batch.converted[index] = true;
+}
+
+static void GenerateDataFile(void *context, size_t thread, size_t index) {
+  DataBatch &batch = *static_cast<DataBatch *>(context);
+  flatbuffers::JsonConverter &converter = *batch.converters[thread];
+  LoadBuffer(converter, batch.buffers[index]);
+  std::string filebase = flatbuffers::StripPath(
+    flatbuffers::StripExtension((*batch.filenames)[batch.begin + index]));
+  flatbuffers::GeneratorOptions opts = *batch.opts;
+  for (size_t i = 0; i < num_generators; ++i) {
+    // All definitions have been marked as generated by the time data files
+    // are processed, so only the generators writing out data have work to do.
+    if (!batch.generator_enabled[i] ||
+        (generators[i].generate != flatbuffers::GenerateBinary &&
+         generators[i].generate != flatbuffers::GenerateTextFile))
+      continue;
+    opts.lang = generators[i].lang;
+    if (!generators[i].generate(converter.parser(), *batch.output_path,
+                                filebase, opts)) {
+      batch.failed_generator[index] = i;
+      break;
+    }
+  }
+  batch.buffers[index].clear();
+}
 
 static void Error(const std::string &err, bool usage, bool show_exe_name) {
   if (show_exe_name) printf("%s: ", program_name);
@@ -96,11 +387,27 @@ static void Error(const std::string &err, bool usage, bool show_exe_name) {
       "  --no-includes   Don\'t generate include statements for included\n"
       "                  schemas the generated file depends on (C++).\n"
       "  --gen-mutable   Generate accessors that can mutate buffers in-place.\n"
+      "  --gen-lazy-verify Generate accessors that verify tables as they are\n"
+      "                  accessed, instead of the whole buffer up front (C++).\n"
+      "  --gen-fixed-create Generate Create functions that write tables with\n"
+      "                  a precomputed vtable when all fields are set (C++).\n"
       "  --gen-onefile   Generate single output file for C#\n"
       "  --raw-binary    Allow binaries without file_indentifier to be read.\n"
       "                  This may crash flatc given a mismatched schema.\n"
       "  --proto         Input is a .proto, translate to .fbs.\n"
       "  --schema        Serialize schemas instead of JSON (use with -b)\n"
+      "  --share-strings Store identical strings only once when serializing\n"
+      "                  JSON (use with -b)\n"
+      "  --stats         Print how the parser and the builder of each data\n"
+      "                  binary spent their work and bytes.\n"
+      "  --compact       Store identical strings, vectors and tables only\n"
+      "                  once in data binaries, and drop unused bytes\n"
+      "                  (use with -b)\n"
+      "  --jobs N        Use N threads to generate code and to convert\n"
+      "                  consecutive data files. Outputs are the same as\n"
+      "                  with a single thread, unless generation fails.\n"
+      "  --schema-cache DIR Keep parsed include files in DIR, and reuse them\n"
+      "                  in later runs while they are unchanged.\n"
       "FILEs may depend on declarations in earlier files.\n"
       "FILEs after the -- must be binary flatbuffer format files.\n"
       "Output files are named using the base file name of the input,\n"
@@ -115,13 +422,17 @@ int main(int argc, const char *argv[]) {
   program_name = argv[0];
   flatbuffers::GeneratorOptions opts;
   std::string output_path;
-  const size_t num_generators = sizeof(generators) / sizeof(generators[0]);
   bool generator_enabled[num_generators] = { false };
   bool any_generator = false;
   bool print_make_rules = false;
   bool proto_mode = false;
   bool raw_binary = false;
   bool schema_binary = false;
+  bool share_strings = false;
+  bool compact = false;
+  bool print_stats = false;
+  size_t jobs = 1;
+  std::string schema_cache_dir;
   std::vector<std::string> filenames;
   std::vector<const char *> include_directories;
   size_t binary_files_from = std::numeric_limits<size_t>::max();
@@ -144,6 +455,10 @@ int main(int argc, const char *argv[]) {
         opts.prefixed_enums = false;
       } else if(arg == "--gen-mutable") {
         opts.mutable_buffer = true;
+      } else if(arg == "--gen-lazy-verify") {
+        opts.lazy_verify = true;
+      } else if(arg == "--gen-fixed-create") {
+        opts.fixed_create = true;
       } else if(arg == "--gen-includes") {
         // Deprecated, remove this option some time in the future.
         printf("warning: --gen-includes is deprecated (it is now default)\n");
@@ -160,6 +475,21 @@ int main(int argc, const char *argv[]) {
         any_generator = true;
       } else if(arg == "--schema") {
         schema_binary = true;
+      } else if(arg == "--share-strings") {
+        share_strings = true;
+      } else if(arg == "--stats") {
+        print_stats = true;
+      } else if(arg == "--compact") {
+        compact = true;
+      } else if(arg == "--jobs") {
+        if (++argi >= argc) Error("missing number following: " + arg, true);
+        int num_jobs = atoi(argv[argi]);
+        if (num_jobs < 1)
+          Error("invalid number of jobs: " + std::string(argv[argi]), true);
+        jobs = static_cast<size_t>(num_jobs);
+      } else if(arg == "--schema-cache") {
+        if (++argi >= argc) Error("missing path following: " + arg, true);
+        schema_cache_dir = flatbuffers::ConCatPathFileName(argv[argi], "");
       } else if(arg == "-M") {
         print_make_rules = true;
       } else {
@@ -184,21 +514,83 @@ int main(int argc, const char *argv[]) {
     Error("no options: specify one of -c -g -j -t -b etc.", true);
 
   // Now process the files:
-  flatbuffers::Parser parser(opts.strict_json, proto_mode);
-    for (std::vector<std::string>::const_iterator file_it = filenames.begin();
-            file_it != filenames.end();
-          ++file_it) {
+  flatbuffers::Parser parser(opts.strict_json, proto_mode, share_strings);
+  flatbuffers::SchemaCache schema_cache(schema_cache_dir);
+  if (!schema_cache_dir.empty()) parser.SetSchemaCache(&schema_cache);
+  // Make rules, .proto conversion and schema binaries all rely on the
+  // parser having seen every file, so they're never done in parallel. Nor
+  // are --stats, which are kept by the parser.
+  bool parallel_data = jobs > 1 && !print_make_rules && !proto_mode &&
+                       !schema_binary && !print_stats;
+  #ifndef FLATBUFFERS_STATS
+    if (print_stats)
+      fprintf(stderr, "%s: warning: built without FLATBUFFERS_STATS, all "
+                      "stats will be 0\n", program_name);
+  #endif
+  CompactSchema compact_schema;
+  for (size_t file_idx = 0; file_idx < filenames.size(); file_idx++) {
+      if (parallel_data && parser.root_struct_def_) {
+        DataBatch batch;
+        batch.filenames = &filenames;
+        batch.binary_files_from = binary_files_from;
+        batch.raw_binary = raw_binary;
+        batch.file_identifier = &parser.file_identifier_;
+        batch.compactor = compact ? &compact_schema.Get(parser) : NULL;
+        batch.output_path = &output_path;
+        batch.opts = &opts;
+        batch.generator_enabled = generator_enabled;
+        // Converters copy the root type etc., so are made anew each batch.
+        for (size_t t = 0; t < jobs; t++) {
+          batch.converters.push_back(new flatbuffers::JsonConverter(
+            parser, NULL, opts.strict_json, share_strings));
+        }
+        batch.begin = file_idx;
+        size_t batch_size = std::min(jobs * 4, filenames.size() - file_idx);
+        batch.buffers.resize(batch_size);
+        batch.converted.resize(batch_size, false);
+        batch.failed_generator.resize(batch_size, num_generators);
+        RunTasks(batch_size, jobs, ConvertDataFile, &batch);
+        size_t num_converted = 0;
+        while (num_converted < batch_size && batch.converted[num_converted])
+          num_converted++;
+        RunTasks(num_converted, jobs, GenerateDataFile, &batch);
+        for (size_t t = 0; t < jobs; t++) delete batch.converters[t];
+        for (size_t i = 0; i < num_converted; i++) {
+          const std::string &filename = filenames[file_idx + i];
+          if (batch.failed_generator[i] != num_generators) {
+            Error(std::string("Unable to generate ") +
+                  generators[batch.failed_generator[i]].lang_name +
+                  " for " +
+                  flatbuffers::StripPath(flatbuffers::StripExtension(
+                    filename)));
+          }
+          // Keep the same record of files seen as Parse() does.
+          if (file_idx + i < binary_files_from &&
+              parser.included_files_.find(filename) ==
+              parser.included_files_.end()) {
+            parser.included_files_[filename] = true;
+            parser.files_included_per_file_[filename] =
+              std::set<std::string>();
+          }
+        }
+        file_idx += num_converted;
+        if (file_idx == filenames.size()) break;
+      }
+
+      const std::string *file_it = &filenames[file_idx];
+      bool is_binary = file_idx >= binary_files_from;
+      // Binaries are only copied once, from the mapping into the builder.
       std::string contents;
-      if (!flatbuffers::LoadFile(file_it->c_str(), true, &contents))
+      flatbuffers::MappedFile mapped;
+      if (is_binary
+            ? !mapped.Map(file_it->c_str(),
+                          flatbuffers::MappedFile::kAccessSequential)
+            : !flatbuffers::LoadFile(file_it->c_str(), true, &contents))
         Error("unable to load file" + *file_it);
 
-      bool is_binary = static_cast<size_t>(file_it - filenames.begin()) >=
-                       binary_files_from;
       if (is_binary) {
         parser.builder_.Clear();
-        parser.builder_.PushBytes(
-          reinterpret_cast<const uint8_t *>(contents.c_str()),
-          contents.length());
+        parser.builder_.PushBytes(mapped.data(), mapped.size());
         if (!raw_binary) {
           // Generally reading binaries that do not correspond to the schema
           // will crash, and sadly there's no way around that when the binary
@@ -210,7 +602,9 @@ int main(int argc, const char *argv[]) {
                  *file_it +
                  "\" matches the schema, use --raw-binary to read this file"
                  " anyway.");
-          } else if (!flatbuffers::BufferHasIdentifier(contents.c_str(),
+          } else if (mapped.size() < sizeof(flatbuffers::uoffset_t) +
+                       flatbuffers::FlatBufferBuilder::kFileIdentifierLength ||
+                     !flatbuffers::BufferHasIdentifier(mapped.data(),
                                              parser.file_identifier_.c_str())) {
             Error("binary \"" +
                  *file_it +
@@ -234,21 +628,66 @@ int main(int argc, const char *argv[]) {
         include_directories.pop_back();
       }
 
+      if (print_stats && !is_binary && parser.builder_.GetSize())
+        PrintBuilderStats(*file_it, parser.builder_);
+
+      if (compact && !schema_binary && parser.root_struct_def_ &&
+          parser.builder_.GetSize()) {
+        std::string data(
+          reinterpret_cast<const char *>(parser.builder_.GetBufferPointer()),
+          parser.builder_.GetSize());
+        const flatbuffers::BufferCompactor &compactor =
+          compact_schema.Get(parser);
+        parser.builder_.PushBytes(reinterpret_cast<const uint8_t *>(
+                                    data.c_str()), data.length());
+        if (!CompactData(compactor, parser.builder_))
+          Error("unable to compact \"" + *file_it +
+                "\": it is not a valid buffer for the schema");
+      }
+
       std::string filebase = flatbuffers::StripPath(
                                flatbuffers::StripExtension(*file_it));
 
-      for (size_t i = 0; i < num_generators; ++i) {
-        opts.lang = generators[i].lang;
-        if (generator_enabled[i]) {
-          if (!print_make_rules) {
-            flatbuffers::EnsureDirExists(output_path);
-            if (!generators[i].generate(parser, output_path, filebase, opts)) {
-              Error(std::string("Unable to generate ") +
-                    generators[i].lang_name +
-                    " for " +
-                    filebase);
-            }
-          } else {
+      if (!print_make_rules) {
+        GeneratorRun run;
+        run.parser = &parser;
+        run.output_path = &output_path;
+        run.filebase = &filebase;
+        run.opts = &opts;
+        const flatbuffers::FieldDef *offset64_field =
+          FindOffset64Field(parser);
+        for (size_t i = 0; i < num_generators; ++i) {
+          if (!generator_enabled[i]) continue;
+          if (offset64_field && !generators[i].offset64) {
+            Error(std::string("offset64 fields are not supported in ") +
+                  generators[i].lang_name + ": " + offset64_field->name);
+          }
+          run.generators.push_back(i);
+        }
+        run.ok.resize(run.generators.size(), false);
+        if (run.generators.size()) flatbuffers::EnsureDirExists(output_path);
+        if (jobs > 1) {
+          RunTasks(run.generators.size(), jobs, RunGenerator, &run);
+        } else {
+          // Stop at the first generator that fails, so the languages after
+          // it aren't generated.
+          for (size_t i = 0; i < run.generators.size(); ++i) {
+            RunGenerator(&run, 0, i);
+            if (!run.ok[i]) break;
+          }
+        }
+        for (size_t i = 0; i < run.generators.size(); ++i) {
+          if (!run.ok[i]) {
+            Error(std::string("Unable to generate ") +
+                  generators[run.generators[i]].lang_name +
+                  " for " +
+                  filebase);
+          }
+        }
+      } else {
+        for (size_t i = 0; i < num_generators; ++i) {
+          opts.lang = generators[i].lang;
+          if (generator_enabled[i]) {
             std::string make_rule = generators[i].make_rule(
                 parser, output_path, *file_it, opts);
             if (!make_rule.empty())
@@ -265,5 +704,6 @@ int main(int argc, const char *argv[]) {
       parser.MarkGenerated();
   }
 
+  if (print_stats) PrintParserStats(parser.GetStats());
   return 0;
 }
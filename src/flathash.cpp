@@ -14,11 +14,10 @@
  * limitations under the License.
  */
 
-#include <iostream>
-#include <sstream>
 #include <string>
 #include "flatbuffers/hash.h"
 #include <stdio.h>
+#include <string.h>
 
 enum OutputFormat {
   kDecimal,
@@ -26,10 +25,75 @@ enum OutputFormat {
   kHexadecimal0x
 };
 
+struct HashOptions {
+  flatbuffers::NamedHashFunction<uint32_t>::HashFunction hash_function32;
+  flatbuffers::NamedHashFunction<uint64_t>::HashFunction hash_function64;
+  OutputFormat output_format;
+  bool annotate;
+};
+
+// Appends the hash of str to out, as one line formatted as requested.
+static void AppendHash(const HashOptions &opts, const char *str,
+                       std::string *out) {
+  uint64_t hash = opts.hash_function32
+    ? opts.hash_function32(str)
+    : opts.hash_function64(str);
+  char buf[32];
+  if (opts.output_format == kDecimal) {
+    snprintf(buf, sizeof(buf), "%llu", static_cast<unsigned long long>(hash));
+  } else {
+    snprintf(buf, sizeof(buf),
+             opts.output_format == kHexadecimal0x ? "0x%llx" : "%llx",
+             static_cast<unsigned long long>(hash));
+  }
+  *out += buf;
+  if (opts.annotate) {
+    *out += " /* \"";
+    *out += str;
+    *out += "\" */";
+  }
+  *out += "\n";
+}
+
+// Hashes every line of a file (or stdin for "-"), buffering the output.
+static bool HashFile(const HashOptions &opts, const char *filename) {
+  FILE *file = strcmp(filename, "-") ? fopen(filename, "rb") : stdin;
+  if (!file) return false;
+  std::string out;
+  std::string line;
+  char buf[1 << 16];
+  size_t len;
+  while ((len = fread(buf, 1, sizeof(buf), file)) > 0) {
+    for (const char *p = buf, *end = buf + len; p < end; ) {
+      const char *newline =
+        static_cast<const char *>(memchr(p, '\n', end - p));
+      if (!newline) {
+        line.append(p, end);
+        break;
+      }
+      line.append(p, newline);
+      if (!line.empty() && line[line.size() - 1] == '\r')
+        line.erase(line.size() - 1);
+      AppendHash(opts, line.c_str(), &out);
+      line.clear();
+      p = newline + 1;
+    }
+    if (out.size() >= sizeof(buf)) {
+      fwrite(out.c_str(), 1, out.size(), stdout);
+      out.clear();
+    }
+  }
+  if (!line.empty()) AppendHash(opts, line.c_str(), &out);
+  fwrite(out.c_str(), 1, out.size(), stdout);
+  if (file != stdin) fclose(file);
+  return true;
+}
+
 int main(int argc, char* argv[]) {
   const char* name = argv[0];
   if (argc <= 1) {
     printf("%s HASH [OPTION]... STRING... [-- STRING...]\n", name);
+    printf("%s HASH [OPTION]... -f FILE\n", name);
     printf("Available hashing algorithms:\n  32 bit:\n");
     size_t size = sizeof(flatbuffers::kHashFunctions32) /
                   sizeof(flatbuffers::kHashFunctions32[0]);
@@ -46,7 +110,8 @@ int main(int argc, char* argv[]) {
         "  -d         Output hash in decimal.\n"
         "  -x         Output hash in hexadecimal.\n"
         "  -0x        Output hash in hexadecimal and prefix with 0x.\n"
-        "  -c         Append the string to the output in a c-style comment.\n");
+        "  -c         Append the string to the output in a c-style comment.\n"
+        "  -f FILE    Hash each line of FILE (- for stdin).\n");
     return 0;
   }
 
@@ -62,40 +127,30 @@ int main(int argc, char* argv[]) {
     return 0;
   }
 
-  OutputFormat output_format = kHexadecimal;
-  bool annotate = false;
+  HashOptions opts;
+  opts.hash_function32 = hash_function32;
+  opts.hash_function64 = hash_function64;
+  opts.output_format = kHexadecimal;
+  opts.annotate = false;
   bool escape_dash = false;
   for (int i = 2; i < argc; i++) {
     const char* arg = argv[i];
     if (!escape_dash && arg[0] == '-') {
       std::string opt = arg;
-      if (opt == "-d")       output_format = kDecimal;
-      else if (opt == "-x")  output_format = kHexadecimal;
-      else if (opt == "-0x") output_format = kHexadecimal0x;
-      else if (opt == "-c")  annotate = true;
+      if (opt == "-d")       opts.output_format = kDecimal;
+      else if (opt == "-x")  opts.output_format = kHexadecimal;
+      else if (opt == "-0x") opts.output_format = kHexadecimal0x;
+      else if (opt == "-c")  opts.annotate = true;
       else if (opt == "--")  escape_dash = true;
+      else if (opt == "-f" && i + 1 < argc) {
+        if (!HashFile(opts, argv[++i]))
+          printf("Unable to read file: \"%s\"\n", argv[i]);
+      }
       else printf("Unrecognized argument: \"%s\"\n", arg);
     } else {
-      std::stringstream ss;
-      if (output_format == kDecimal) {
-        ss << std::dec;
-      } else if (output_format == kHexadecimal) {
-        ss << std::hex;
-      } else if (output_format == kHexadecimal0x) {
-        ss << std::hex;
-        ss << "0x";
-      }
-      if (hash_function32)
-        ss << hash_function32(arg);
-      else if (hash_function64)
-        ss << hash_function64(arg);
-
-      if (annotate)
-        ss << " /* \"" << arg << "\" */";
-
-      ss << "\n";
-
-      std::cout << ss.str();
+      std::string out;
+      AppendHash(opts, arg, &out);
+      fwrite(out.c_str(), 1, out.size(), stdout);
     }
   }
   return 0;
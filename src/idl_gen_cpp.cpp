@@ -17,6 +17,7 @@
 // independent from idl_parser, since this code is not needed for most clients
 
 #include "flatbuffers/flatbuffers.h"
+#include "flatbuffers/hash.h"
 #include "flatbuffers/idl.h"
 #include "flatbuffers/util.h"
 
@@ -124,6 +125,32 @@ static std::string GenTypeGet(const Parser &parser, const Type &type,
     : beforeptr + GenTypePointer(parser, type) + afterptr;
 }
 
+// Return the C++ type of a vector field with the offset64 attribute, which
+// for structs holds the struct itself rather than a pointer to it.
+static std::string GenTypeVector64(const Parser &parser, const Type &type) {
+  Type element = type.VectorType();
+  return "flatbuffers::Vector64<" +
+         (IsScalar(element.base_type) ? GenTypeBasic(parser, element, false)
+                                      : GenTypePointer(parser, element)) +
+         " >";
+}
+
+// Like GenTypeWire, for the arguments building any field.
+static std::string GenTypeWireField(const Parser &parser,
+                                    const FieldDef &field,
+                                    const char *postfix) {
+  return field.offset64
+    ? "flatbuffers::Offset64<" + GenTypeVector64(parser, field.value.type) +
+      " >" + postfix
+    : GenTypeWire(parser, field.value.type, postfix, true);
+}
+
+// The size a field takes up in its table.
+static size_t GenFieldSize(const FieldDef &field) {
+  return field.offset64 ? sizeof(uoffset64_t)
+                        : SizeOf(field.value.type.base_type);
+}
+
 static std::string GenEnumVal(const EnumDef &enum_def, const EnumVal &enum_val,
                               const GeneratorOptions &opts) {
   return opts.prefixed_enums ? enum_def.name + "_" + enum_val.name
@@ -202,6 +229,31 @@ static void GenEnum(const Parser &parser, EnumDef &enum_def,
       }
     }
     code_post += "    default: return false;\n  }\n}\n\n";
+
+    if (opts.lazy_verify) {
+      // And its lazy counterpart, which only checks the table itself.
+      signature = "inline bool Verify" + enum_def.name + "Lazily" +
+                  "(flatbuffers::Verifier &verifier, " +
+                  "const void *union_obj, " + enum_def.name + " type)";
+      code += signature + ";\n\n";
+      code_post += signature + " {\n  switch (type) {\n";
+      for (std::vector<EnumVal *>::const_iterator it =
+             enum_def.vals.vec.begin();
+           it != enum_def.vals.vec.end();
+           ++it) {
+        EnumVal &ev = **it;
+        code_post += "    case " + GenEnumVal(enum_def, ev, opts);
+        if (!ev.value) {
+          code_post += ": return true;\n";  // "NONE" enum value.
+        } else {
+          code_post += ": return verifier.VerifyTableLazily(";
+          code_post += "reinterpret_cast<const ";
+          code_post += WrapInNameSpace(parser, *ev.struct_def);
+          code_post += " *>(union_obj)) != NULL;\n";
+        }
+      }
+      code_post += "    default: return false;\n  }\n}\n\n";
+    }
   }
 }
 
@@ -217,6 +269,195 @@ std::string GenUnderlyingCast(const Parser &parser, const FieldDef &field,
       : val;
 }
 
+// Generate the start of a CreateX function body that, when all fields are
+// passed non-default values, writes the table with a vtable computed here
+// (see FlatBufferBuilder::StartFixedTable()). This is only done when fields
+// are sorted by size, so they are written without any padding in between,
+// and there are no struct fields, whose alignment would need padding too
+// (nor offset64 fields, whose offsets depend on where they are written).
+static void GenFixedCreate(const Parser &parser, const StructDef &struct_def,
+                           std::string *code_ptr) {
+  std::string &code = *code_ptr;
+  if (!struct_def.sortbysize) return;
+  std::vector<const FieldDef *> order;  // In the order they are written.
+  for (size_t size = sizeof(largest_scalar_t); size; size /= 2) {
+    for (std::vector<FieldDef *>::const_reverse_iterator it = struct_def.fields.vec.rbegin();
+         it != struct_def.fields.vec.rend();
+         ++it) {
+      const FieldDef &field = **it;
+      if (IsStruct(field.value.type) || field.offset64) return;
+      if (!field.deprecated && size == SizeOf(field.value.type.base_type))
+        order.push_back(&field);
+    }
+  }
+  if (order.empty()) return;
+  // Fields are pushed downwards from the (aligned) start of the table,
+  // followed by padding and the vtable offset.
+  size_t alignment = SizeOf(order[0]->value.type.base_type);
+  if (alignment < sizeof(soffset_t)) alignment = sizeof(soffset_t);
+  size_t fields_size = 0;
+  std::vector<size_t> ends;
+  for (std::vector<const FieldDef *>::const_iterator it = order.begin();
+       it != order.end(); ++it) {
+    fields_size += SizeOf((*it)->value.type.base_type);
+    ends.push_back(fields_size);
+  }
+  size_t object_size = fields_size +
+                       PaddingBytes(fields_size, sizeof(soffset_t)) +
+                       sizeof(soffset_t);
+  std::vector<size_t> vtable(2 + struct_def.fields.vec.size(), 0);
+  vtable[0] = vtable.size() * sizeof(voffset_t);
+  vtable[1] = object_size;
+  std::string cond, pushes;
+  for (size_t i = 0; i < order.size(); i++) {
+    const FieldDef &field = *order[i];
+    vtable[field.value.offset / sizeof(voffset_t)] = object_size - ends[i];
+    if (!cond.empty()) cond += " && ";
+    if (IsScalar(field.value.type.base_type)) {
+      std::string type = GenTypeWire(parser, field.value.type, "", false);
+      std::string val = GenUnderlyingCast(parser, field, false, field.name);
+      cond += val + " != ";
+      cond += field.value.type.base_type == BASE_TYPE_FLOAT
+        ? "static_cast<float>(" + field.value.constant + ")"
+        : field.value.constant;
+      pushes += "    _fbb.PushElement<" + type + ">(" + val + ");\n";
+    } else {
+      cond += field.name + ".o";
+      pushes += "    _fbb.PushElement(" + field.name + ");\n";
+    }
+  }
+  code += "  if (" + cond + ") {\n";
+  code += "    static const flatbuffers::voffset_t vtable_[] = {";
+  for (size_t i = 0; i < vtable.size(); i++) {
+    code += (i ? ", " : " ") + NumToString(vtable[i]);
+  }
+  code += " };\n";
+  code += "    flatbuffers::uoffset_t start_ = _fbb.StartFixedTable(";
+  code += NumToString(alignment) + ");\n";
+  code += pushes;
+  code += "    return flatbuffers::Offset<" + struct_def.name;
+  code += ">(_fbb.EndFixedTable(start_, vtable_));\n  }\n";
+}
+
+// Generate a verifier method for a table. If deep is false, this generates
+// VerifyShallow instead, which checks the table itself along with its
+// strings and vectors, but leaves tables it refers to (directly, through
+// unions or in vectors) for lazy verification when they're accessed.
+static void GenVerifier(const Parser &parser, const StructDef &struct_def,
+                        bool deep, std::string *code_ptr) {
+  std::string &code = *code_ptr;
+  code += std::string("  bool ") + (deep ? "Verify" : "VerifyShallow");
+  code += "(flatbuffers::Verifier &verifier) const {\n";
+  code += "    return VerifyTableStart(verifier)";
+  std::string prefix = " &&\n           ";
+  for (std::vector<FieldDef *>::const_iterator it = struct_def.fields.vec.begin();
+       it != struct_def.fields.vec.end();
+       ++it) {
+    FieldDef &field = **it;
+    if (field.offset64) {
+      code += prefix + "VerifyOffset64(verifier, ";
+      code += NumToString(field.value.offset) + " /* " + field.name + " */";
+      code += field.required ? ", true)" : ")";
+    } else if (!field.deprecated) {
+      code += prefix + "VerifyField";
+      if (field.required) code += "Required";
+      code += "<" + GenTypeSize(parser, field.value.type);
+      code += ">(verifier, " + NumToString(field.value.offset);
+      code += " /* " + field.name + " */)";
+    }
+    if (!field.deprecated) {
+      switch (field.value.type.base_type) {
+        case BASE_TYPE_UNION:
+          if (!deep) break;
+          code += prefix + "Verify" + field.value.type.enum_def->name;
+          code += "(verifier, " + field.name + "(), " + field.name + "_type())";
+          break;
+        case BASE_TYPE_STRUCT:
+          if (deep && !field.value.type.struct_def->fixed) {
+            code += prefix + "verifier.VerifyTable(" + field.name;
+            code += "())";
+          }
+          break;
+        case BASE_TYPE_STRING:
+          code += prefix + "verifier.Verify(" + field.name + "())";
+          break;
+        case BASE_TYPE_VECTOR:
+          code += prefix + "verifier.Verify(" + field.name + "())";
+          switch (field.value.type.element) {
+            case BASE_TYPE_STRING: {
+              code += prefix + "verifier.VerifyVectorOfStrings(" + field.name;
+              code += "())";
+              break;
+            }
+            case BASE_TYPE_STRUCT: {
+              if (deep && !field.value.type.struct_def->fixed) {
+                code += prefix + "verifier.VerifyVectorOfTables(" + field.name;
+                code += "())";
+              }
+              break;
+            }
+            default:
+              break;
+          }
+          break;
+        default:
+          break;
+      }
+    }
+  }
+  code += prefix + "verifier.EndTable()";
+  code += ";\n  }\n";
+}
+
+// Returns the compile time version of a hash function (see hash.h).
+template<typename T> static const char *ConstHashFunction(
+    const NamedHashFunction<T> *functions, size_t num_functions,
+    const std::string &name) {
+  for (size_t i = 0; i < num_functions; i++) {
+    if (name == functions[i].name) return functions[i].const_function;
+  }
+  return NULL;
+}
+
+// Generate a function hashing a string the same way as the parser does for
+// a field with the hash attribute, so literals become constants.
+static void GenHashFunction(const Parser &parser, const FieldDef &field,
+                            std::string *code_ptr) {
+  Value *hash_name = field.attributes.Lookup("hash");
+  if (!hash_name) return;
+  std::string &code = *code_ptr;
+  const char *function = InlineSize(field.value.type) == sizeof(uint32_t)
+    ? ConstHashFunction(kHashFunctions32,
+                        sizeof(kHashFunctions32) / sizeof(kHashFunctions32[0]),
+                        hash_name->constant)
+    : ConstHashFunction(kHashFunctions64,
+                        sizeof(kHashFunctions64) / sizeof(kHashFunctions64[0]),
+                        hash_name->constant);
+  assert(function);  // Guaranteed to exist by parser.
+  std::string type = GenTypeBasic(parser, field.value.type, false);
+  code += "  static FLATBUFFERS_CONSTEXPR " + type + " " + field.name;
+  code += "_hash(const char *val) { return static_cast<" + type + ">(";
+  code += std::string(function) + "(val)); }\n";
+}
+
+// Generate an accessor for the root of a field with the nested_flatbuffer
+// attribute.
+static void GenNestedRoot(const Parser &parser, const FieldDef &field,
+                          std::string *code_ptr) {
+  Value* nested = field.attributes.Lookup("nested_flatbuffer");
+  if (!nested) return;
+  std::string &code = *code_ptr;
+  std::string qualified_name = parser.GetFullyQualifiedName(nested->constant);
+  StructDef* nested_root = parser.structs_.Lookup(qualified_name);
+  assert(nested_root);  // Guaranteed to exist by parser.
+  (void)nested_root;
+  std::string cpp_qualified_name = TranslateNameSpace(qualified_name);
+
+  code += "  const " + cpp_qualified_name + " *" + field.name;
+  code += "_nested_root() const { return flatbuffers::GetRoot<";
+  code += cpp_qualified_name + ">(" + field.name + "()->Data()); }\n";
+}
+
 // Generate an accessor struct, builder structs & function for a table.
 static void GenTable(const Parser &parser, StructDef &struct_def,
                      const GeneratorOptions &opts, std::string *code_ptr) {
@@ -233,7 +474,19 @@ static void GenTable(const Parser &parser, StructDef &struct_def,
        it != struct_def.fields.vec.end();
        ++it) {
     FieldDef &field = **it;
-    if (!field.deprecated) {  // Deprecated fields won't be accessible.
+    if (!field.deprecated && field.offset64) {
+      // Vectors after the end of a large buffer, see large_buffer.h.
+      GenComment(field.doc_comment, code_ptr, NULL, "  ");
+      std::string type = GenTypeVector64(parser, field.value.type);
+      std::string offsetstr = NumToString(field.value.offset);
+      code += "  const " + type + " *" + field.name + "() const { return ";
+      code += "GetPointer64<const " + type + " *>(" + offsetstr + "); }\n";
+      if (opts.mutable_buffer) {
+        code += "  " + type + " *mutable_" + field.name + "() { return ";
+        code += "GetPointer64<" + type + " *>(" + offsetstr + "); }\n";
+      }
+      GenNestedRoot(parser, field, code_ptr);
+    } else if (!field.deprecated) {  // Deprecated fields won't be accessible.
       bool is_scalar = IsScalar(field.value.type.base_type);
       GenComment(field.doc_comment, code_ptr, NULL, "  ");
       code += "  " + GenTypeGet(parser, field.value.type, " ", "const ", " *",
@@ -269,18 +522,62 @@ static void GenTable(const Parser &parser, StructDef &struct_def,
           code += "; }\n";
         }
       }
-      Value* nested = field.attributes.Lookup("nested_flatbuffer");
-      if (nested) {
-        std::string qualified_name = parser.GetFullyQualifiedName(
-            nested->constant);
-        StructDef* nested_root = parser.structs_.Lookup(qualified_name);
-        assert(nested_root);  // Guaranteed to exist by parser.
-        (void)nested_root;
-        std::string cpp_qualified_name = TranslateNameSpace(qualified_name);
-
-        code += "  const " + cpp_qualified_name + " *" + field.name;
-        code += "_nested_root() const { return flatbuffers::GetRoot<";
-        code += cpp_qualified_name + ">(" + field.name + "()->Data()); }\n";
+      GenHashFunction(parser, field, code_ptr);
+      if (opts.lazy_verify) {
+        // Accessors that verify the table they return on first access.
+        if (field.value.type.base_type == BASE_TYPE_UNION) {
+          code += "  const void *" + field.name;
+          code += "(flatbuffers::Verifier &verifier) const { return Verify";
+          code += field.value.type.enum_def->name + "Lazily(verifier, ";
+          code += field.name + "(), " + field.name + "_type()) ? ";
+          code += field.name + "() : NULL; }\n";
+        } else if (field.value.type.base_type == BASE_TYPE_STRUCT &&
+                   !field.value.type.struct_def->fixed) {
+          code += "  " + GenTypeGet(parser, field.value.type, " ", "const ",
+                                    " *", true);
+          code += field.name + "(flatbuffers::Verifier &verifier) const { ";
+          code += "return verifier.VerifyTableLazily(" + field.name;
+          code += "()); }\n";
+        }
+      }
+      if (field.value.type.base_type == BASE_TYPE_VECTOR) {
+        // A contiguous, aligned view of vectors of scalars and structs.
+        Type vectortype = field.value.type.VectorType();
+        if (IsScalar(vectortype.base_type) ||
+            (vectortype.base_type == BASE_TYPE_STRUCT &&
+             vectortype.struct_def->fixed)) {
+          std::string view = "flatbuffers::VectorView<" +
+            (IsScalar(vectortype.base_type)
+              ? GenTypeBasic(parser, vectortype, false)
+              : GenTypePointer(parser, vectortype)) + ">";
+          code += "  " + view + " " + field.name + "_view() const { return ";
+          code += view + "(" + field.name + "()); }\n";
+        }
+      }
+      GenNestedRoot(parser, field, code_ptr);
+      Value *key_index = field.attributes.Lookup("key_index");
+      if (key_index) {
+        const FieldDef *indexed = struct_def.fields.Lookup(
+            key_index->constant);
+        assert(indexed);  // Guaranteed to exist by parser.
+        const StructDef &elem = *indexed->value.type.struct_def;
+        const FieldDef *key = NULL;
+        for (std::vector<FieldDef *>::const_iterator kit =
+               elem.fields.vec.begin();
+             kit != elem.fields.vec.end();
+             ++kit) {
+          if ((*kit)->key) key = *kit;
+        }
+        assert(key);  // Guaranteed to exist by parser.
+        code += "  " + GenTypeGet(parser, indexed->value.type.VectorType(),
+                                  " ", "const ", " *", true);
+        code += indexed->name + "_by_key(";
+        if (key->value.type.base_type == BASE_TYPE_STRING)
+          code += "const char *";
+        else
+          code += GenTypeBasic(parser, key->value.type, false) + " ";
+        code += "key) const { return flatbuffers::LookupByKeyIndex(";
+        code += indexed->name + "(), " + field.name + "(), key); }\n";
       }
       // Generate a comparison function for this field if it is a key.
       if (field.key) {
@@ -299,64 +596,32 @@ static void GenTable(const Parser &parser, StructDef &struct_def,
           code += " val) const { return " + field.name + "() < val ? -1 : ";
           code += field.name + "() > val; }\n";
         }
+        code += "  uint64_t KeyIndexValue() const { return ";
+        code += "flatbuffers::KeyIndexValue(" + field.name + "()); }\n";
+        code += "  static uint64_t KeyIndexValueAt(";
+        code += "const flatbuffers::FlatBufferBuilder &fbb, ";
+        code += "flatbuffers::uoffset_t o) { return ";
+        code += "flatbuffers::KeyIndexValue(";
+        if (field.value.type.base_type == BASE_TYPE_STRING) {
+          code += "fbb.GetStringAt(o, " + NumToString(field.value.offset);
+          code += ")); }\n";
+        } else {
+          code += "fbb.GetFieldAt<";
+          code += GenTypeGet(parser, field.value.type, "", "", "", false);
+          code += ">(o, " + NumToString(field.value.offset) + ", ";
+          code += field.value.constant + ")); }\n";
+        }
+        code += "  static bool KeyIndexIsExact() { return ";
+        code += field.value.type.base_type == BASE_TYPE_STRING
+                ? "false" : "true";
+        code += "; }\n";
       }
     }
   }
   // Generate a verifier function that can check a buffer from an untrusted
   // source will never cause reads outside the buffer.
-  code += "  bool Verify(flatbuffers::Verifier &verifier) const {\n";
-  code += "    return VerifyTableStart(verifier)";
-  std::string prefix = " &&\n           ";
-  for (std::vector<FieldDef *>::const_iterator it = struct_def.fields.vec.begin();
-       it != struct_def.fields.vec.end();
-       ++it) {
-    FieldDef &field = **it;
-    if (!field.deprecated) {
-      code += prefix + "VerifyField";
-      if (field.required) code += "Required";
-      code += "<" + GenTypeSize(parser, field.value.type);
-      code += ">(verifier, " + NumToString(field.value.offset);
-      code += " /* " + field.name + " */)";
-      switch (field.value.type.base_type) {
-        case BASE_TYPE_UNION:
-          code += prefix + "Verify" + field.value.type.enum_def->name;
-          code += "(verifier, " + field.name + "(), " + field.name + "_type())";
-          break;
-        case BASE_TYPE_STRUCT:
-          if (!field.value.type.struct_def->fixed) {
-            code += prefix + "verifier.VerifyTable(" + field.name;
-            code += "())";
-          }
-          break;
-        case BASE_TYPE_STRING:
-          code += prefix + "verifier.Verify(" + field.name + "())";
-          break;
-        case BASE_TYPE_VECTOR:
-          code += prefix + "verifier.Verify(" + field.name + "())";
-          switch (field.value.type.element) {
-            case BASE_TYPE_STRING: {
-              code += prefix + "verifier.VerifyVectorOfStrings(" + field.name;
-              code += "())";
-              break;
-            }
-            case BASE_TYPE_STRUCT: {
-              if (!field.value.type.struct_def->fixed) {
-                code += prefix + "verifier.VerifyVectorOfTables(" + field.name;
-                code += "())";
-              }
-              break;
-            }
-            default:
-              break;
-          }
-          break;
-        default:
-          break;
-      }
-    }
-  }
-  code += prefix + "verifier.EndTable()";
-  code += ";\n  }\n";
+  GenVerifier(parser, struct_def, true, code_ptr);
+  if (opts.lazy_verify) GenVerifier(parser, struct_def, false, code_ptr);
   code += "};\n\n";
 
   // Generate a builder struct, with methods of the form:
@@ -370,9 +635,11 @@ static void GenTable(const Parser &parser, StructDef &struct_def,
     FieldDef &field = **it;
     if (!field.deprecated) {
       code += "  void add_" + field.name + "(";
-      code += GenTypeWire(parser, field.value.type, " ", true) + field.name;
+      code += GenTypeWireField(parser, field, " ") + field.name;
       code += ") { fbb_.Add";
-      if (IsScalar(field.value.type.base_type)) {
+      if (field.offset64) {
+        code += "Offset64";
+      } else if (IsScalar(field.value.type.base_type)) {
         code += "Element<" + GenTypeWire(parser, field.value.type, "", false);
         code += " >";
       } else if (IsStruct(field.value.type)) {
@@ -418,7 +685,7 @@ static void GenTable(const Parser &parser, StructDef &struct_def,
        ++it) {
     FieldDef &field = **it;
     if (!field.deprecated) {
-      code += ",\n   " + GenTypeWire(parser, field.value.type, " ", true);
+      code += ",\n   " + GenTypeWireField(parser, field, " ");
       code += field.name + " = ";
       if (field.value.type.enum_def && IsScalar(field.value.type.base_type)) {
         EnumVal* ev = field.value.type.enum_def->ReverseLookup(
@@ -436,7 +703,9 @@ static void GenTable(const Parser &parser, StructDef &struct_def,
       }
     }
   }
-  code += ") {\n  " + struct_def.name + "Builder builder_(_fbb);\n";
+  code += ") {\n";
+  if (opts.fixed_create) GenFixedCreate(parser, struct_def, code_ptr);
+  code += "  " + struct_def.name + "Builder builder_(_fbb);\n";
   for (size_t size = struct_def.sortbysize ? sizeof(largest_scalar_t) : 1;
        size;
        size /= 2) {
@@ -445,8 +714,7 @@ static void GenTable(const Parser &parser, StructDef &struct_def,
          ++it) {
       FieldDef &field = **it;
       if (!field.deprecated &&
-          (!struct_def.sortbysize ||
-           size == SizeOf(field.value.type.base_type))) {
+          (!struct_def.sortbysize || size == GenFieldSize(field))) {
         code += "  builder_.add_" + field.name + "(" + field.name + ");\n";
       }
     }
@@ -782,6 +1050,14 @@ std::string GenerateCPP(const Parser &parser,
               "return verifier.VerifyBuffer<";
       code += cpp_qualified_name + ">(); }\n\n";
 
+      if (opts.lazy_verify) {
+        // The root accessor for lazy verification:
+        code += "inline const " + cpp_qualified_name + " *Get" + name;
+        code += "Lazily(flatbuffers::Verifier &verifier) { ";
+        code += "return verifier.VerifyRootLazily<";
+        code += cpp_qualified_name + ">(); }\n\n";
+      }
+
       if (parser.file_identifier_.length()) {
         // Return the identifier
         code += "inline const char *" + name;
@@ -132,6 +132,27 @@ static void GetVectorLen(const StructDef &struct_def,
   code += Indent + Indent + "return 0\n\n";
 }
 
+// Get all elements of a vector of scalars or structs in one call.
+static void GetVectorAsArray(const StructDef &struct_def,
+                             const FieldDef &field,
+                             std::string *code_ptr) {
+  std::string &code = *code_ptr;
+  Type vectortype = field.value.type.VectorType();
+
+  GenReceiver(struct_def, code_ptr);
+  code += MakeCamel(field.name) + "AsArray(self";
+  code += "):" + OffsetPrefix(field);
+  code += Indent + Indent + Indent + "return self._tab.VectorAsArray(";
+  if (vectortype.base_type == BASE_TYPE_STRUCT) {
+    code += "flatbuffers.number_types.Uint8Flags, o, ";
+    code += NumToString(InlineSize(vectortype)) + ")\n";
+  } else {
+    code += "flatbuffers.number_types.";
+    code += MakeCamel(GenTypeGet(vectortype)) + "Flags, o)\n";
+  }
+  code += Indent + Indent + "return 0\n\n";
+}
+
 // Get the value of a struct's scalar.
 static void GetScalarFieldOfStruct(const StructDef &struct_def,
                                    const FieldDef &field,
@@ -463,6 +484,12 @@ static void GenStructAccessor(const StructDef &struct_def,
   }
   if (field.value.type.base_type == BASE_TYPE_VECTOR) {
     GetVectorLen(struct_def, field, code_ptr);
+    Type vectortype = field.value.type.VectorType();
+    if (IsScalar(vectortype.base_type) ||
+        (vectortype.base_type == BASE_TYPE_STRUCT &&
+         vectortype.struct_def->fixed)) {
+      GetVectorAsArray(struct_def, field, code_ptr);
+    }
   }
 }
 
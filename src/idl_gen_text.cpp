@@ -20,11 +20,18 @@
 #include "flatbuffers/idl.h"
 #include "flatbuffers/util.h"
 
+#include <errno.h>
+#ifdef _WIN32
+  #include <io.h>
+#else
+  #include <unistd.h>
+#endif
+
 namespace flatbuffers {
 
 static void GenStruct(const StructDef &struct_def, const Table *table,
                       int indent, const GeneratorOptions &opts,
-                      std::string *_text);
+                      TextSink *_text);
 
 // If indentation is less than 0, that indicates we don't want any newlines
 // either.
@@ -38,8 +45,8 @@ int Indent(const GeneratorOptions &opts) {
 
 // Output an identifier with or without quotes depending on strictness.
 void OutputIdentifier(const std::string &name, const GeneratorOptions &opts,
-                      std::string *_text) {
-  std::string &text = *_text;
+                      TextSink *_text) {
+  TextSink &text = *_text;
   if (opts.strict_json) text += "\"";
   text += name;
   if (opts.strict_json) text += "\"";
@@ -51,8 +58,8 @@ void OutputIdentifier(const std::string &name, const GeneratorOptions &opts,
 template<typename T> void Print(T val, Type type, int /*indent*/,
                                 StructDef * /*union_sd*/,
                                 const GeneratorOptions &opts,
-                                std::string *_text) {
-  std::string &text = *_text;
+                                TextSink *_text) {
+  TextSink &text = *_text;
   if (type.enum_def && opts.output_enum_identifiers) {
     EnumVal* enum_val = type.enum_def->ReverseLookup(static_cast<int>(val));
     if (enum_val) {
@@ -60,14 +67,15 @@ template<typename T> void Print(T val, Type type, int /*indent*/,
       return;
     }
   }
-  text += NumToString(val);
+  char buf[kMaxFormattedNumberSize];
+  text.append(buf, FormatNumber(val, buf));
 }
 
 // Print a vector a sequence of JSON values, comma separated, wrapped in "[]".
 template<typename T> void PrintVector(const Vector<T> &v, Type type,
                                       int indent, const GeneratorOptions &opts,
-                                      std::string *_text) {
-  std::string &text = *_text;
+                                      TextSink *_text) {
+  TextSink &text = *_text;
   text += "[";
   text += NewLine(opts);
   for (uoffset_t i = 0; i < v.size(); i++) {
@@ -88,8 +96,34 @@ template<typename T> void PrintVector(const Vector<T> &v, Type type,
   text += "]";
 }
 
-static void EscapeString(const String &s, std::string *_text) {
-  std::string &text = *_text;
+// Similarly for fields with the offset64 attribute, of scalars or structs.
+template<typename T> void PrintVector64(const Vector64<T> &v, Type type,
+                                        int indent,
+                                        const GeneratorOptions &opts,
+                                        TextSink *_text) {
+  TextSink &text = *_text;
+  text += "[";
+  text += NewLine(opts);
+  for (uoffset64_t i = 0; i < v.size(); i++) {
+    if (i) {
+      text += ",";
+      text += NewLine(opts);
+    }
+    text.append(indent + Indent(opts), ' ');
+    if (IsStruct(type))
+      Print(static_cast<const void *>(v.Data() +
+                                      i * type.struct_def->bytesize),
+            type, indent + Indent(opts), NULL, opts, _text);
+    else
+      Print(v[i], type, indent + Indent(opts), NULL, opts, _text);
+  }
+  text += NewLine(opts);
+  text.append(indent, ' ');
+  text += "]";
+}
+
+static void EscapeString(const String &s, TextSink *_text) {
+  TextSink &text = *_text;
   text += "\"";
   for (uoffset_t i = 0; i < s.size(); i++) {
     char c = s[i];
@@ -132,7 +166,7 @@ template<> void Print<const void *>(const void *val,
                                     Type type, int indent,
                                     StructDef *union_sd,
                                     const GeneratorOptions &opts,
-                                    std::string *_text) {
+                                    TextSink *_text) {
   switch (type.base_type) {
     case BASE_TYPE_UNION:
       // If this assert hits, you have an corrupt buffer, a union type field
@@ -178,7 +212,7 @@ template<typename T> static void GenField(const FieldDef &fd,
                                           const Table *table, bool fixed,
                                           const GeneratorOptions &opts,
                                           int indent,
-                                          std::string *_text) {
+                                          TextSink *_text) {
   Print(fixed ?
     reinterpret_cast<const Struct *>(table)->GetField<T>(fd.value.offset) :
     table->GetField<T>(fd.value.offset, 0), fd.value.type, indent, NULL,
@@ -188,7 +222,26 @@ template<typename T> static void GenField(const FieldDef &fd,
 // Generate text for non-scalar field.
 static void GenFieldOffset(const FieldDef &fd, const Table *table, bool fixed,
                            int indent, StructDef *union_sd,
-                           const GeneratorOptions &opts, std::string *_text) {
+                           const GeneratorOptions &opts, TextSink *_text) {
+  if (fd.offset64) {
+    const void *vec = table->GetPointer64<const void *>(fd.value.offset);
+    Type type = fd.value.type.VectorType();
+    switch (type.base_type) {
+      #define FLATBUFFERS_TD(ENUM, IDLTYPE, CTYPE, JTYPE, GTYPE, NTYPE, \
+        PTYPE) \
+        case BASE_TYPE_ ## ENUM: \
+          PrintVector64<CTYPE>( \
+            *reinterpret_cast<const Vector64<CTYPE> *>(vec), \
+            type, indent, opts, _text); break;
+        FLATBUFFERS_GEN_TYPES_SCALAR(FLATBUFFERS_TD)
+      #undef FLATBUFFERS_TD
+      default:  // Structs, whose size doesn't depend on the element type.
+        PrintVector64<uint8_t>(*reinterpret_cast<const Vector64<uint8_t> *>(
+                                 vec), type, indent, opts, _text);
+        break;
+    }
+    return;
+  }
   const void *val = NULL;
   if (fixed) {
     // The only non-scalar fields in structs are structs.
@@ -207,8 +260,8 @@ static void GenFieldOffset(const FieldDef &fd, const Table *table, bool fixed,
 // and bracketed by "{}"
 static void GenStruct(const StructDef &struct_def, const Table *table,
                       int indent, const GeneratorOptions &opts,
-                      std::string *_text) {
-  std::string &text = *_text;
+                      TextSink *_text) {
+  TextSink &text = *_text;
   text += "{";
   int fieldout = 0;
   StructDef *union_sd = NULL;
@@ -267,17 +320,43 @@ static void GenStruct(const StructDef &struct_def, const Table *table,
 }
 
 // Generate a text representation of a flatbuffer in JSON format.
-void GenerateText(const Parser &parser, const void *flatbuffer,
-                  const GeneratorOptions &opts, std::string *_text) {
-  std::string &text = *_text;
+bool GenerateText(const Parser &parser, const void *flatbuffer,
+                  const GeneratorOptions &opts, TextSink *_text) {
+  TextSink &text = *_text;
   assert(parser.root_struct_def_);  // call SetRootType()
-  text.reserve(1024);   // Reduce amount of inevitable reallocs.
   GenStruct(*parser.root_struct_def_,
             GetRoot<Table>(flatbuffer),
             0,
             opts,
             _text);
   text += NewLine(opts);
+  return text.Flush();
+}
+
+void GenerateText(const Parser &parser, const void *flatbuffer,
+                  const GeneratorOptions &opts, std::string *_text) {
+  _text->reserve(1024);   // Reduce amount of inevitable reallocs.
+  StringTextSink sink(_text);
+  GenerateText(parser, flatbuffer, opts, &sink);
+}
+
+bool FileTextSink::Write(const char *data, size_t len) {
+  return fwrite(data, 1, len, file_) == len;
+}
+
+bool FdTextSink::Write(const char *data, size_t len) {
+  while (len) {
+    #ifdef _WIN32
+      int written = _write(fd_, data, static_cast<unsigned int>(len));
+    #else
+      ssize_t written = write(fd_, data, len);
+      if (written < 0 && errno == EINTR) continue;
+    #endif
+    if (written <= 0) return false;
+    data += written;
+    len -= written;
+  }
+  return true;
 }
 
 std::string TextFileName(const std::string &path,
@@ -290,12 +369,14 @@ bool GenerateTextFile(const Parser &parser,
                       const std::string &file_name,
                       const GeneratorOptions &opts) {
   if (!parser.builder_.GetSize() || !parser.root_struct_def_) return true;
-  std::string text;
-  GenerateText(parser, parser.builder_.GetBufferPointer(), opts,
-               &text);
-  return flatbuffers::SaveFile(TextFileName(path, file_name).c_str(),
-                               text,
-                               false);
+  FILE *file = fopen(TextFileName(path, file_name).c_str(), "w");
+  if (!file) return false;
+  bool ok;
+  {
+    FileTextSink sink(file);
+    ok = GenerateText(parser, parser.builder_.GetBufferPointer(), opts, &sink);
+  }
+  return fclose(file) == 0 && ok;
 }
 
 std::string TextMakeRule(const Parser &parser,
@@ -15,10 +15,20 @@
  */
 
 #include <algorithm>
+#include <cstdio>
+#include <ctime>
 #include <list>
 
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
 #include "flatbuffers/idl.h"
 #include "flatbuffers/util.h"
+#include "flatbuffers/hash.h"
 
 namespace flatbuffers {
 
@@ -47,6 +57,30 @@ static void Error(const std::string &msg) {
   throw msg;
 }
 
+// Returns the first char at or after p that needs special handling inside a
+// string constant: a quote, a backslash or a control character (which includes
+// the terminating 0). While at least 8 chars are left before end, these are
+// tested a word at a time, and only the word containing the special char is
+// looked at byte by byte.
+static const char *SkipPlainStringChars(const char *p, const char *end) {
+  static const uint64_t kOnes = 0x0101010101010101ULL;
+  static const uint64_t kHighBits = 0x8080808080808080ULL;
+  while (end - p >= 8) {
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+    uint64_t quote = word ^ (kOnes * '\"');
+    uint64_t backslash = word ^ (kOnes * '\\');
+    // Each term has a high bit set iff some byte is 0 (resp. less than ' ').
+    uint64_t special = ((quote - kOnes) & ~quote) |
+                       ((backslash - kOnes) & ~backslash) |
+                       ((word - kOnes * ' ') & ~word);
+    if (special & kHighBits) break;
+    p += 8;
+  }
+  while ((*p >= ' ' || *p < 0) && *p != '\"' && *p != '\\') p++;
+  return p;
+}
+
 // Ensure that integer values we parse fit inside the declared integer type.
 static void CheckBitsFit(int64_t val, size_t bits) {
   // Bits we allow to be used.
@@ -140,7 +174,14 @@ int64_t Parser::ParseHexNum(int nibbles) {
   return val;
 }
 
+#ifdef FLATBUFFERS_STATS
+static void AddSecondsSince(clock_t start, double *seconds) {
+  *seconds += static_cast<double>(clock() - start) / CLOCKS_PER_SEC;
+}
+#endif
+
 void Parser::Next() {
+  FLATBUFFERS_STAT(stats_.tokens++);
   doc_comment_.clear();
   bool seen_newline = false;
   for (;;) {
@@ -148,7 +189,11 @@ void Parser::Next() {
     token_ = c;
     switch (c) {
       case '\0': cursor_--; token_ = kTokenEof; return;
-      case ' ': case '\r': case '\t': break;
+      case ' ': case '\r': case '\t':
+        // Indentation comes in runs, skip them without going round the loop.
+        while (*cursor_ == ' ' || *cursor_ == '\t' || *cursor_ == '\r')
+          cursor_++;
+        break;
       case '\n': line_++; seen_newline = true; break;
       case '{': case '}': case '(': case ')': case '[': case ']': return;
       case ',': case ':': case ';': case '=': return;
@@ -157,8 +202,13 @@ void Parser::Next() {
         Error("floating point constant can\'t start with \".\"");
         break;
       case '\"':
-        attribute_ = "";
-        while (*cursor_ != '\"') {
+        attribute_.clear();
+        for (;;) {
+          // Copy runs of printable chars + UTF-8 bytes in one go.
+          const char *start = cursor_;
+          cursor_ = SkipPlainStringChars(cursor_, source_end_);
+          attribute_.append(start, cursor_);
+          if (*cursor_ == '\"') break;
           if (*cursor_ < ' ' && *cursor_ >= 0)
             Error("illegal character in string constant");
           if (*cursor_ == '\\') {
@@ -184,8 +234,6 @@ void Parser::Next() {
               }
               default: Error("unknown escape code in string constant"); break;
             }
-          } else { // printable chars + UTF-8 bytes
-            attribute_ += *cursor_++;
           }
         }
         cursor_++;
@@ -304,9 +352,9 @@ void Parser::ParseNamespacing(std::string *id, std::string *last) {
 }
 
 EnumDef *Parser::LookupEnum(const std::string &id) {
-  EnumDef* ed = enums_.Lookup(GetFullyQualifiedName(id));
+  EnumDef* ed = schema_->enums_.Lookup(GetFullyQualifiedName(id));
   // id may simply not have a namespace at all, so check that too.
-  if (!ed) ed = enums_.Lookup(id);
+  if (!ed) ed = schema_->enums_.Lookup(id);
   return ed;
 }
 
@@ -469,6 +517,23 @@ void Parser::ParseField(StructDef &struct_def) {
     // wasn't defined elsewhere.
     LookupCreateStruct(nested->constant);
   }
+  field.offset64 = field.attributes.Lookup("offset64") != NULL;
+  if (field.offset64) {
+    Type element = field.value.type.VectorType();
+    if (struct_def.fixed || field.value.type.base_type != BASE_TYPE_VECTOR ||
+        !(IsScalar(element.base_type) || IsStruct(element)))
+      Error("offset64 attribute may only apply to a vector of scalars or "
+            "structs in a table");
+  }
+  Value *key_index = field.attributes.Lookup("key_index");
+  if (key_index) {
+    if (key_index->type.base_type != BASE_TYPE_STRING)
+      Error("key_index attribute must be a string (the indexed field)");
+    if (field.value.type.base_type != BASE_TYPE_VECTOR ||
+        field.value.type.element != BASE_TYPE_ULONG)
+      Error("key_index attribute may only apply to a vector of ulong");
+    // The indexed field may come later, so it is checked in Parse().
+  }
 
   if (typefield) {
     // If this field is a union, and it has a manually assigned id,
@@ -504,9 +569,11 @@ void Parser::ParseAnyValue(Value &val, FieldDef *field) {
       val.constant = NumToString(ParseTable(*val.type.struct_def));
       break;
     case BASE_TYPE_STRING: {
-        std::string s = attribute_;
+      std::string s = attribute_;
       Expect(kTokenStringConstant);
-      val.constant = NumToString(builder_.CreateString(s).o);
+      val.constant = NumToString(share_strings_
+                                   ? json_builder_->CreateSharedString(s).o
+                                   : json_builder_->CreateString(s).o);
       break;
     }
     case BASE_TYPE_VECTOR: {
@@ -535,10 +602,10 @@ void Parser::ParseAnyValue(Value &val, FieldDef *field) {
 void Parser::SerializeStruct(const StructDef &struct_def, const Value &val) {
   uoffset_t off = atot<uoffset_t>(val.constant.c_str());
   assert(struct_stack_.size() - off == struct_def.bytesize);
-  builder_.Align(struct_def.minalign);
-  builder_.PushBytes(&struct_stack_[off], struct_def.bytesize);
+  json_builder_->Align(struct_def.minalign);
+  json_builder_->PushBytes(&struct_stack_[off], struct_def.bytesize);
   struct_stack_.resize(struct_stack_.size() - struct_def.bytesize);
-  builder_.AddStructOffset(val.offset, builder_.GetSize());
+  json_builder_->AddStructOffset(val.offset, json_builder_->GetSize());
 }
 
 uoffset_t Parser::ParseTable(const StructDef &struct_def) {
@@ -551,6 +618,8 @@ uoffset_t Parser::ParseTable(const StructDef &struct_def) {
       Expect(strict_json_ ? kTokenStringConstant : kTokenIdentifier);
     FieldDef* field = struct_def.fields.Lookup(name);
     if (!field) Error("unknown field: " + name);
+    if (field->offset64)
+      Error("offset64 fields can't be parsed from JSON: " + name);
     if (struct_def.fixed && (fieldn >= struct_def.fields.vec.size()
                             || struct_def.fields.vec[fieldn] != field)) {
        Error("struct field appearing out of order: " + name);
@@ -563,21 +632,23 @@ uoffset_t Parser::ParseTable(const StructDef &struct_def) {
     if (IsNext('}')) break;
     Expect(',');
   }
+  if (!struct_def.fixed) {  // Struct fields are already checked for order.
+    // Mark fields by their vtable slot, which leaves the schema untouched.
+    field_seen_.assign(struct_def.fields.vec.size(), false);
     for (std::vector<std::pair<Value, FieldDef *> >::const_reverse_iterator it = field_stack_.rbegin();
-           it != field_stack_.rbegin() + fieldn; ++it) {
-    if (it->second->used)
-      Error("field set more than once: " + it->second->name);
-    it->second->used = true;
-  }
-  for (std::vector<std::pair<Value, FieldDef *> >::const_reverse_iterator it = field_stack_.rbegin();
-           it != field_stack_.rbegin() + fieldn; ++it) {
-    it->second->used = false;
+             it != field_stack_.rbegin() + fieldn; ++it) {
+      size_t slot = (it->second->value.offset - FieldIndexToOffset(0)) /
+                    sizeof(voffset_t);
+      if (field_seen_[slot])
+        Error("field set more than once: " + it->second->name);
+      field_seen_[slot] = true;
+    }
   }
   if (struct_def.fixed && fieldn != struct_def.fields.vec.size())
     Error("incomplete struct initialization: " + struct_def.name);
   uoffset_t start = struct_def.fixed
-                 ? builder_.StartStruct(struct_def.minalign)
-                 : builder_.StartTable();
+                 ? json_builder_->StartStruct(struct_def.minalign)
+                 : json_builder_->StartTable();
 
   for (size_t size = struct_def.sortbysize ? sizeof(largest_scalar_t) : 1;
        size;
@@ -592,11 +663,11 @@ uoffset_t Parser::ParseTable(const StructDef &struct_def) {
           #define FLATBUFFERS_TD(ENUM, IDLTYPE, CTYPE, JTYPE, GTYPE, NTYPE, \
             PTYPE) \
             case BASE_TYPE_ ## ENUM: \
-              builder_.Pad(field->padding); \
+              json_builder_->Pad(field->padding); \
               if (struct_def.fixed) { \
-                builder_.PushElement(atot<CTYPE>(value.constant.c_str())); \
+                json_builder_->PushElement(atot<CTYPE>(value.constant.c_str())); \
               } else { \
-                builder_.AddElement(value.offset, \
+                json_builder_->AddElement(value.offset, \
                              atot<CTYPE>(       value.constant.c_str()), \
                              atot<CTYPE>(field->value.constant.c_str())); \
               } \
@@ -606,11 +677,11 @@ uoffset_t Parser::ParseTable(const StructDef &struct_def) {
           #define FLATBUFFERS_TD(ENUM, IDLTYPE, CTYPE, JTYPE, GTYPE, NTYPE, \
             PTYPE) \
             case BASE_TYPE_ ## ENUM: \
-              builder_.Pad(field->padding); \
+              json_builder_->Pad(field->padding); \
               if (IsStruct(field->value.type)) { \
                 SerializeStruct(*field->value.type.struct_def, value); \
               } else { \
-                builder_.AddOffset(value.offset, \
+                json_builder_->AddOffset(value.offset, \
                   atot<CTYPE>(value.constant.c_str())); \
               } \
               break;
@@ -623,18 +694,18 @@ uoffset_t Parser::ParseTable(const StructDef &struct_def) {
   for (size_t i = 0; i < fieldn; i++) field_stack_.pop_back();
 
   if (struct_def.fixed) {
-    builder_.ClearOffsets();
-    builder_.EndStruct();
+    json_builder_->ClearOffsets();
+    json_builder_->EndStruct();
     // Temporarily store this struct in a side buffer, since this data has to
     // be stored in-line later in the parent object.
     size_t off = struct_stack_.size();
     struct_stack_.insert(struct_stack_.end(),
-                         builder_.GetBufferPointer(),
-                         builder_.GetBufferPointer() + struct_def.bytesize);
-    builder_.PopBytes(struct_def.bytesize);
+                         json_builder_->GetBufferPointer(),
+                         json_builder_->GetBufferPointer() + struct_def.bytesize);
+    json_builder_->PopBytes(struct_def.bytesize);
     return static_cast<uoffset_t>(off);
   } else {
-    return builder_.EndTable(
+    return json_builder_->EndTable(
       start,
       static_cast<voffset_t>(struct_def.fields.vec.size()));
   }
@@ -653,7 +724,7 @@ uoffset_t Parser::ParseVector(const Type &type) {
     Expect(',');
   }
 
-  builder_.StartVector(count * InlineSize(type) / InlineAlignment(type),
+  json_builder_->StartVector(count * InlineSize(type) / InlineAlignment(type),
                        InlineAlignment(type));
   for (int i = 0; i < count; i++) {
     // start at the back, since we're building the data backwards.
@@ -662,7 +733,7 @@ uoffset_t Parser::ParseVector(const Type &type) {
       #define FLATBUFFERS_TD(ENUM, IDLTYPE, CTYPE, JTYPE, GTYPE, NTYPE, PTYPE) \
         case BASE_TYPE_ ## ENUM: \
           if (IsStruct(val.type)) SerializeStruct(*val.type.struct_def, val); \
-          else builder_.PushElement(atot<CTYPE>(val.constant.c_str())); \
+          else json_builder_->PushElement(atot<CTYPE>(val.constant.c_str())); \
           break;
         FLATBUFFERS_GEN_TYPES(FLATBUFFERS_TD)
       #undef FLATBUFFERS_TD
@@ -670,8 +741,8 @@ uoffset_t Parser::ParseVector(const Type &type) {
     field_stack_.pop_back();
   }
 
-  builder_.ClearOffsets();
-  return builder_.EndVector(count);
+  json_builder_->ClearOffsets();
+  return json_builder_->EndVector(count);
 }
 
 void Parser::ParseMetaData(Definition &def) {
@@ -999,6 +1070,7 @@ void Parser::ParseDecl() {
 }
 
 bool Parser::SetRootType(const char *name) {
+  schema_state_.clear();
   root_struct_def_ = structs_.Lookup(GetFullyQualifiedName(name));
   return root_struct_def_ != NULL;
 }
@@ -1161,12 +1233,18 @@ bool Parser::Parse(const char *source, const char **include_paths,
     included_files_[source_filename] = true;
     files_included_per_file_[source_filename] = std::set<std::string>();
     files_being_parsed_.push(source_filename);
+    for (std::vector<SchemaCache::Entry *>::const_iterator it =
+           cache_recordings_.begin(); it != cache_recordings_.end(); ++it) {
+      (*it)->new_files[source_filename];
+    }
   }
   if (!include_paths) {
     static const char *current_directory[] = { "", NULL };
     include_paths = current_directory;
   }
   source_ = cursor_ = source;
+  source_end_ = source + strlen(source);
+  FLATBUFFERS_STAT(stats_.bytes += source_end_ - source_);
   line_ = 1;
   error_.clear();
   builder_.Clear();
@@ -1186,18 +1264,20 @@ bool Parser::Parse(const char *source, const char **include_paths,
         Error("unable to locate include file: " + name);
       if (source_filename)
         files_included_per_file_[source_filename].insert(filepath);
+      for (std::vector<SchemaCache::Entry *>::const_iterator it =
+             cache_recordings_.begin(); it != cache_recordings_.end(); ++it) {
+        (*it)->includes.push_back(std::make_pair(filepath, false));
+      }
       if (included_files_.find(filepath) == included_files_.end()) {
         // We found an include file that we have not parsed yet.
-        // Load it and parse it.
+        // Load it and parse it (or get it from the cache).
         std::string contents;
         if (!LoadFile(filepath.c_str(), true, &contents))
           Error("unable to load include file: " + name);
-        if (!Parse(contents.c_str(), include_paths, filepath.c_str())) {
+        if (!ParseInclude(contents, filepath, include_paths)) {
           // Any errors, we're done.
           return false;
         }
-        // We do not want to output code for any included files:
-        MarkGenerated();
         // This is the easiest way to continue this file after an include:
         // instead of saving and restoring all the state, we simply start the
         // file anew. This will cause it to encounter the same include statement
@@ -1209,10 +1289,18 @@ bool Parser::Parse(const char *source, const char **include_paths,
       }
       Expect(';');
     }
+    // From here on the schema depends on more than include files.
+    schema_state_.clear();
     // Start with a blank namespace just in case this file doesn't have one.
     namespaces_.push_back(new Namespace());
     // Now parse all other kinds of declarations:
     while (token_ != kTokenEof) {
+      #ifdef FLATBUFFERS_STATS
+        clock_t start = clock();
+        double *phase_seconds = token_ == '{' && !proto_mode_
+                                ? &stats_.json_seconds
+                                : &stats_.schema_seconds;
+      #endif
       if (proto_mode_) {
         ParseProtoDecl();
       } else if (token_ == kTokenNameSpace) {
@@ -1224,6 +1312,7 @@ bool Parser::Parse(const char *source, const char **include_paths,
         }
         builder_.Finish(Offset<Table>(ParseTable(*root_struct_def_)),
           file_identifier_.length() ? file_identifier_.c_str() : NULL);
+        FLATBUFFERS_STAT(stats_.json_objects++);
       } else if (token_ == kTokenEnum) {
         ParseEnum(false);
       } else if (token_ == kTokenUnion) {
@@ -1263,10 +1352,26 @@ bool Parser::Parse(const char *source, const char **include_paths,
       } else {
         ParseDecl();
       }
+      FLATBUFFERS_STAT(AddSecondsSince(start, phase_seconds));
     }
       for (std::vector<StructDef*>::const_iterator it = structs_.vec.begin(); it != structs_.vec.end(); ++it) {
       if ((*it)->predecl)
         Error("type referenced but not defined: " + (*it)->name);
+      for (std::vector<FieldDef*>::const_iterator field_it =
+             (*it)->fields.vec.begin();
+           field_it != (*it)->fields.vec.end();
+           ++field_it) {
+        Value *key_index = (*field_it)->attributes.Lookup("key_index");
+        if (!key_index) continue;
+        FieldDef *indexed = (*it)->fields.Lookup(key_index->constant);
+        if (!indexed ||
+            indexed->value.type.base_type != BASE_TYPE_VECTOR ||
+            indexed->value.type.element != BASE_TYPE_STRUCT ||
+            indexed->value.type.struct_def->fixed ||
+            !indexed->value.type.struct_def->has_key)
+          Error("key_index attribute must name a vector of tables with a key"
+                " in the same table: " + key_index->constant);
+      }
     }
     for (std::vector<EnumDef*>::const_iterator it = enums_.vec.begin(); it != enums_.vec.end(); ++it) {
       EnumDef &enum_def = **it;
@@ -1297,6 +1402,644 @@ bool Parser::Parse(const char *source, const char **include_paths,
   return true;
 }
 
+JsonConverter::JsonConverter(const Parser &schema, FlatBufferBuilder *builder,
+                             bool strict_json, bool share_strings)
+  : parser_(strict_json, false, share_strings), count_(0) {
+  parser_.schema_ = &schema;
+  parser_.root_struct_def_ = schema.root_struct_def_;
+  parser_.file_identifier_ = schema.file_identifier_;
+  parser_.file_extension_ = schema.file_extension_;
+  if (builder) parser_.json_builder_ = builder;
+}
+
+bool JsonConverter::Convert(const char *json) {
+  return ConvertObjects(json, true, NULL, NULL);
+}
+
+bool JsonConverter::ConvertAll(const char *json, Callback callback,
+                               void *context) {
+  return ConvertObjects(json, false, callback, context);
+}
+
+bool JsonConverter::ConvertObjects(const char *json, bool single,
+                                   Callback callback, void *context) {
+  Parser &p = parser_;
+  p.source_ = p.cursor_ = json;
+  p.source_end_ = json + strlen(json);
+  FLATBUFFERS_STAT(p.stats_.bytes += p.source_end_ - p.source_);
+  p.line_ = 1;
+  p.error_.clear();
+  // Left over if the previous conversion failed halfway.
+  p.field_stack_.clear();
+  p.struct_stack_.clear();
+  count_ = 0;
+  try {
+    if (!p.root_struct_def_) Error("no root type set to parse json with");
+    p.Next();
+    while (p.token_ != kTokenEof) {
+      if (single && count_)
+        Error("cannot have more than one json object in a file");
+      FlatBufferBuilder &builder = *p.json_builder_;
+      builder.Clear();
+      FLATBUFFERS_STAT(clock_t start = clock());
+      builder.Finish(Offset<Table>(p.ParseTable(*p.root_struct_def_)),
+        p.file_identifier_.length() ? p.file_identifier_.c_str() : NULL);
+      FLATBUFFERS_STAT(AddSecondsSince(start, &p.stats_.json_seconds));
+      FLATBUFFERS_STAT(p.stats_.json_objects++);
+      count_++;
+      if (callback &&
+          !callback(context, builder.GetBufferPointer(), builder.GetSize()))
+        break;
+    }
+    if (single && !count_) p.Expect('{');
+  } catch (const std::string &msg) {
+    #ifdef _WIN32
+      p.error_ = "(" + NumToString(p.line_) + ")";  // MSVC alike
+    #else
+      p.error_ = NumToString(p.line_) + ":0";  // gcc alike
+    #endif
+    p.error_ += ": error: " + msg;
+    return false;
+  }
+  assert(!p.struct_stack_.size());
+  return true;
+}
+
+// Parse an include file, or restore the state the parser would be in after
+// parsing it from schema_cache_.
+bool Parser::ParseInclude(const std::string &contents,
+                          const std::string &filepath,
+                          const char **include_paths) {
+  std::string paths;
+  for (const char **p = include_paths; p && *p; p++) {
+    paths += *p;
+    paths += '\0';
+  }
+  std::string key;
+  if (schema_cache_ && !schema_state_.empty()) {
+    key = SchemaCache::Key(schema_state_, paths, filepath, contents);
+    const SchemaCache::Entry *entry = schema_cache_->Lookup(key);
+    bool applies = entry &&
+                   entry->state_before == schema_state_ &&
+                   entry->include_paths == paths &&
+                   entry->files[0].first == filepath &&
+                   entry->files[0].second == contents;
+    for (size_t i = 1; applies && i < entry->files.size(); i++) {
+      std::string file_contents;
+      applies = LoadFile(entry->files[i].first.c_str(), true, &file_contents) &&
+                file_contents == entry->files[i].second;
+    }
+    for (size_t i = 0; applies && i < entry->includes.size(); i++) {
+      applies = (included_files_.find(entry->includes[i].first) !=
+                 included_files_.end()) == entry->includes[i].second;
+    }
+    if (applies && ReadSchemaState(entry->parser_state)) {
+      schema_cache_->hits_++;
+      for (std::map<std::string, std::set<std::string> >::const_iterator it =
+             entry->new_files.begin(); it != entry->new_files.end(); ++it) {
+        included_files_[it->first] = true;
+        files_included_per_file_[it->first] = it->second;
+      }
+      // Any include files being parsed around this one depend on it too.
+      for (std::vector<SchemaCache::Entry *>::const_iterator it =
+             cache_recordings_.begin(); it != cache_recordings_.end(); ++it) {
+        SchemaCache::Entry &outer = **it;
+        outer.files.insert(outer.files.end(), entry->files.begin(),
+                           entry->files.end());
+        outer.includes.insert(outer.includes.end(), entry->includes.begin(),
+                              entry->includes.end());
+        for (std::map<std::string, std::set<std::string> >::const_iterator
+               file_it = entry->new_files.begin();
+             file_it != entry->new_files.end(); ++file_it) {
+          outer.new_files[file_it->first];
+        }
+      }
+      schema_state_ = entry->state_after;
+      return true;
+    }
+    schema_cache_->misses_++;
+  }
+  for (std::vector<SchemaCache::Entry *>::const_iterator it =
+         cache_recordings_.begin(); it != cache_recordings_.end(); ++it) {
+    (*it)->files.push_back(std::make_pair(filepath, contents));
+  }
+  SchemaCache::Entry entry;
+  entry.state_before = schema_state_;
+  entry.include_paths = paths;
+  entry.files.push_back(std::make_pair(filepath, contents));
+  if (!key.empty()) cache_recordings_.push_back(&entry);
+  bool ok = Parse(contents.c_str(), include_paths, filepath.c_str());
+  if (!key.empty()) cache_recordings_.pop_back();
+  if (!ok) return false;
+  // We do not want to output code for any included files:
+  MarkGenerated();
+  if (key.empty()) {
+    schema_state_.clear();
+    return true;
+  }
+  // Whether an include was seen before is decided by the state before this
+  // file, and each include only needs to be checked once.
+  std::set<std::string> seen;
+  std::vector<std::pair<std::string, bool> > includes;
+  for (std::vector<std::pair<std::string, bool> >::const_iterator it =
+         entry.includes.begin(); it != entry.includes.end(); ++it) {
+    if (!seen.insert(it->first).second) continue;
+    bool before = entry.new_files.find(it->first) == entry.new_files.end() &&
+                  included_files_.find(it->first) != included_files_.end();
+    includes.push_back(std::make_pair(it->first, before));
+  }
+  entry.includes.swap(includes);
+  for (std::map<std::string, std::set<std::string> >::iterator it =
+         entry.new_files.begin(); it != entry.new_files.end(); ++it) {
+    it->second = files_included_per_file_[it->first];
+  }
+  WriteSchemaState(&entry.parser_state);
+  std::string after = key;
+  for (std::vector<std::pair<std::string, std::string> >::const_iterator it =
+         entry.files.begin() + 1; it != entry.files.end(); ++it) {
+    after = SchemaCache::Key(after, "", it->first, it->second);
+  }
+  entry.state_after = after;
+  schema_cache_->Store(key, entry);
+  schema_state_ = after;
+  return true;
+}
+
+// Everything the parser knows about the schema is written into a simple byte
+// stream: numbers as varints, strings prefixed by their length, and
+// references to other definitions as indices (plus one, 0 being NULL).
+
+static void WriteNumber(std::string *out, uint64_t val) {
+  while (val >= 0x80) {
+    out->push_back(static_cast<char>((val & 0x7F) | 0x80));
+    val >>= 7;
+  }
+  out->push_back(static_cast<char>(val));
+}
+
+static void WriteString(std::string *out, const std::string &str) {
+  WriteNumber(out, str.length());
+  out->append(str);
+}
+
+static void WriteStrings(std::string *out,
+                         const std::vector<std::string> &strs) {
+  WriteNumber(out, strs.size());
+  for (std::vector<std::string>::const_iterator it = strs.begin();
+       it != strs.end(); ++it) {
+    WriteString(out, *it);
+  }
+}
+
+// Reads the above, any truncated or corrupt data making ok() false.
+class StateReader {
+ public:
+  explicit StateReader(const std::string &in)
+    : cur_(in.c_str()), end_(in.c_str() + in.length()), ok_(true) {}
+
+  uint64_t Number() {
+    uint64_t val = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (cur_ == end_) break;
+      uint8_t byte = static_cast<uint8_t>(*cur_++);
+      val |= static_cast<uint64_t>(byte & 0x7F) << shift;
+      if (!(byte & 0x80)) return val;
+    }
+    ok_ = false;
+    return 0;
+  }
+
+  // A number of elements, each of which takes at least one byte.
+  size_t Count() {
+    uint64_t count = Number();
+    if (count > static_cast<uint64_t>(end_ - cur_)) {
+      ok_ = false;
+      return 0;
+    }
+    return static_cast<size_t>(count);
+  }
+
+  // An index plus one into something with size elements, or 0.
+  size_t Index(size_t size) {
+    uint64_t index = Number();
+    if (index > size) {
+      ok_ = false;
+      return 0;
+    }
+    return static_cast<size_t>(index);
+  }
+
+  std::string String() {
+    size_t len = Count();
+    std::string str(cur_, len);
+    cur_ += len;
+    return str;
+  }
+
+  void Strings(std::vector<std::string> *strs) {
+    size_t count = Count();
+    for (size_t i = 0; i < count && ok_; i++) strs->push_back(String());
+  }
+
+  bool ok() const { return ok_; }
+  bool AtEnd() const { return cur_ == end_; }
+
+ private:
+  const char *cur_, *end_;
+  bool ok_;
+};
+
+template<typename T> size_t IndexOf(const std::map<const T *, size_t> &indices,
+                                    const T *ptr) {
+  typename std::map<const T *, size_t>::const_iterator it = indices.find(ptr);
+  return it == indices.end() ? 0 : it->second + 1;
+}
+
+template<typename T> std::map<const T *, size_t> Indices(
+    const std::vector<T *> &vec) {
+  std::map<const T *, size_t> indices;
+  for (size_t i = 0; i < vec.size(); i++) indices[vec[i]] = i;
+  return indices;
+}
+
+// For each element in order, the name it can be looked up by, if any.
+template<typename T> void WriteKeys(std::string *out,
+                                    const SymbolTable<T> &table) {
+  std::map<const T *, std::string> keys;
+  for (typename std::map<std::string, T *>::const_iterator it =
+         table.dictionary().begin(); it != table.dictionary().end(); ++it) {
+    keys[it->second] = it->first;
+  }
+  WriteNumber(out, table.vec.size());
+  for (typename std::vector<T *>::const_iterator it = table.vec.begin();
+       it != table.vec.end(); ++it) {
+    typename std::map<const T *, std::string>::const_iterator key =
+      keys.find(*it);
+    WriteNumber(out, key != keys.end());
+    if (key != keys.end()) WriteString(out, key->second);
+  }
+}
+
+// Fill table with count new elements, as written by WriteKeys().
+template<typename T> void ReadKeys(StateReader &in, SymbolTable<T> *table,
+                                   T *(*create)()) {
+  size_t count = in.Count();
+  for (size_t i = 0; i < count && in.ok(); i++) {
+    T *e = create();
+    if (in.Number()) table->Add(in.String(), e);
+    else table->vec.push_back(e);
+  }
+}
+
+template<typename T> T *CreateDefault() { return new T(); }
+static EnumVal *CreateEnumVal() { return new EnumVal("", 0); }
+
+struct StateIndices {
+  std::map<const StructDef *, size_t> structs;
+  std::map<const EnumDef *, size_t> enums;
+  std::map<const Namespace *, size_t> namespaces;
+};
+
+struct StateTables {
+  std::vector<StructDef *> *structs;
+  std::vector<EnumDef *> *enums;
+  std::vector<Namespace *> *namespaces;
+};
+
+static void WriteType(std::string *out, const StateIndices &indices,
+                      const Type &type) {
+  WriteNumber(out, type.base_type);
+  WriteNumber(out, type.element);
+  WriteNumber(out, IndexOf(indices.structs,
+                           static_cast<const StructDef *>(type.struct_def)));
+  WriteNumber(out, IndexOf(indices.enums,
+                           static_cast<const EnumDef *>(type.enum_def)));
+}
+
+static void ReadType(StateReader &in, const StateTables &tables, Type *type) {
+  uint64_t base_type = in.Number();
+  uint64_t element = in.Number();
+  if (base_type > BASE_TYPE_UNION || element > BASE_TYPE_UNION) {
+    base_type = element = 0;
+    in.Index(0);  // Fails.
+  }
+  type->base_type = static_cast<BaseType>(base_type);
+  type->element = static_cast<BaseType>(element);
+  size_t struct_index = in.Index(tables.structs->size());
+  type->struct_def = struct_index ? (*tables.structs)[struct_index - 1] : NULL;
+  size_t enum_index = in.Index(tables.enums->size());
+  type->enum_def = enum_index ? (*tables.enums)[enum_index - 1] : NULL;
+}
+
+static void WriteValue(std::string *out, const StateIndices &indices,
+                       const Value &value) {
+  WriteType(out, indices, value.type);
+  WriteString(out, value.constant);
+  WriteNumber(out, value.offset);
+}
+
+static void ReadValue(StateReader &in, const StateTables &tables,
+                      Value *value) {
+  ReadType(in, tables, &value->type);
+  value->constant = in.String();
+  value->offset = static_cast<voffset_t>(in.Number());
+}
+
+static void WriteDefinition(std::string *out, const StateIndices &indices,
+                            const Definition &def) {
+  WriteString(out, def.name);
+  WriteString(out, def.file);
+  WriteStrings(out, def.doc_comment);
+  WriteKeys(out, def.attributes);
+  for (std::vector<Value *>::const_iterator it = def.attributes.vec.begin();
+       it != def.attributes.vec.end(); ++it) {
+    WriteValue(out, indices, **it);
+  }
+  WriteNumber(out, def.generated);
+  WriteNumber(out, IndexOf(indices.namespaces,
+              static_cast<const Namespace *>(def.defined_namespace)));
+}
+
+static void ReadDefinition(StateReader &in, const StateTables &tables,
+                           Definition *def) {
+  def->name = in.String();
+  def->file = in.String();
+  in.Strings(&def->doc_comment);
+  ReadKeys(in, &def->attributes, CreateDefault<Value>);
+  for (std::vector<Value *>::const_iterator it = def->attributes.vec.begin();
+       it != def->attributes.vec.end() && in.ok(); ++it) {
+    ReadValue(in, tables, *it);
+  }
+  def->generated = in.Number() != 0;
+  size_t ns_index = in.Index(tables.namespaces->size());
+  def->defined_namespace = ns_index ? (*tables.namespaces)[ns_index - 1]
+                                    : NULL;
+}
+
+static const char kSchemaStateVersion[] = "flatbuffers schema state 2";
+
+void Parser::WriteSchemaState(std::string *out) const {
+  StateIndices indices;
+  indices.structs = Indices(structs_.vec);
+  indices.enums = Indices(enums_.vec);
+  indices.namespaces = Indices(namespaces_);
+  WriteString(out, kSchemaStateVersion);
+  WriteNumber(out, namespaces_.size());
+  for (std::vector<Namespace *>::const_iterator it = namespaces_.begin();
+       it != namespaces_.end(); ++it) {
+    WriteStrings(out, (*it)->components);
+  }
+  WriteKeys(out, structs_);
+  WriteKeys(out, enums_);
+  for (std::vector<StructDef *>::const_iterator it = structs_.vec.begin();
+       it != structs_.vec.end(); ++it) {
+    const StructDef &struct_def = **it;
+    WriteDefinition(out, indices, struct_def);
+    WriteNumber(out, struct_def.fixed);
+    WriteNumber(out, struct_def.predecl);
+    WriteNumber(out, struct_def.sortbysize);
+    WriteNumber(out, struct_def.has_key);
+    WriteNumber(out, struct_def.minalign);
+    WriteNumber(out, struct_def.bytesize);
+    WriteKeys(out, struct_def.fields);
+    for (std::vector<FieldDef *>::const_iterator field_it =
+           struct_def.fields.vec.begin();
+         field_it != struct_def.fields.vec.end(); ++field_it) {
+      const FieldDef &field = **field_it;
+      WriteDefinition(out, indices, field);
+      WriteValue(out, indices, field.value);
+      WriteNumber(out, field.deprecated);
+      WriteNumber(out, field.required);
+      WriteNumber(out, field.key);
+      WriteNumber(out, field.offset64);
+      WriteNumber(out, field.padding);
+    }
+  }
+  for (std::vector<EnumDef *>::const_iterator it = enums_.vec.begin();
+       it != enums_.vec.end(); ++it) {
+    const EnumDef &enum_def = **it;
+    WriteDefinition(out, indices, enum_def);
+    WriteNumber(out, enum_def.is_union);
+    WriteType(out, indices, enum_def.underlying_type);
+    WriteKeys(out, enum_def.vals);
+    for (std::vector<EnumVal *>::const_iterator val_it =
+           enum_def.vals.vec.begin();
+         val_it != enum_def.vals.vec.end(); ++val_it) {
+      const EnumVal &val = **val_it;
+      WriteString(out, val.name);
+      WriteStrings(out, val.doc_comment);
+      WriteNumber(out, static_cast<uint64_t>(val.value));
+      WriteNumber(out, IndexOf(indices.structs,
+                              static_cast<const StructDef *>(val.struct_def)));
+    }
+  }
+  WriteNumber(out, IndexOf(indices.structs,
+                          static_cast<const StructDef *>(root_struct_def_)));
+  WriteString(out, file_identifier_);
+  WriteString(out, file_extension_);
+  WriteNumber(out, known_attributes_.size());
+  for (std::set<std::string>::const_iterator it = known_attributes_.begin();
+       it != known_attributes_.end(); ++it) {
+    WriteString(out, *it);
+  }
+}
+
+// Replaces the schema with the one in "in", or leaves it untouched if that
+// can't be read.
+bool Parser::ReadSchemaState(const std::string &in_str) {
+  StateReader in(in_str);
+  if (in.String() != kSchemaStateVersion) return false;
+  std::vector<Namespace *> namespaces;
+  size_t num_namespaces = in.Count();
+  for (size_t i = 0; i < num_namespaces && in.ok(); i++) {
+    namespaces.push_back(new Namespace());
+    in.Strings(&namespaces.back()->components);
+  }
+  SymbolTable<StructDef> structs;
+  SymbolTable<EnumDef> enums;
+  ReadKeys(in, &structs, CreateDefault<StructDef>);
+  ReadKeys(in, &enums, CreateDefault<EnumDef>);
+  StateTables tables = { &structs.vec, &enums.vec, &namespaces };
+  for (std::vector<StructDef *>::const_iterator it = structs.vec.begin();
+       it != structs.vec.end() && in.ok(); ++it) {
+    StructDef &struct_def = **it;
+    ReadDefinition(in, tables, &struct_def);
+    struct_def.fixed = in.Number() != 0;
+    struct_def.predecl = in.Number() != 0;
+    struct_def.sortbysize = in.Number() != 0;
+    struct_def.has_key = in.Number() != 0;
+    struct_def.minalign = static_cast<size_t>(in.Number());
+    struct_def.bytesize = static_cast<size_t>(in.Number());
+    ReadKeys(in, &struct_def.fields, CreateDefault<FieldDef>);
+    for (std::vector<FieldDef *>::const_iterator field_it =
+           struct_def.fields.vec.begin();
+         field_it != struct_def.fields.vec.end() && in.ok(); ++field_it) {
+      FieldDef &field = **field_it;
+      ReadDefinition(in, tables, &field);
+      ReadValue(in, tables, &field.value);
+      field.deprecated = in.Number() != 0;
+      field.required = in.Number() != 0;
+      field.key = in.Number() != 0;
+      field.offset64 = in.Number() != 0;
+      field.padding = static_cast<size_t>(in.Number());
+    }
+  }
+  for (std::vector<EnumDef *>::const_iterator it = enums.vec.begin();
+       it != enums.vec.end() && in.ok(); ++it) {
+    EnumDef &enum_def = **it;
+    ReadDefinition(in, tables, &enum_def);
+    enum_def.is_union = in.Number() != 0;
+    ReadType(in, tables, &enum_def.underlying_type);
+    ReadKeys(in, &enum_def.vals, CreateEnumVal);
+    for (std::vector<EnumVal *>::const_iterator val_it =
+           enum_def.vals.vec.begin();
+         val_it != enum_def.vals.vec.end() && in.ok(); ++val_it) {
+      EnumVal &val = **val_it;
+      val.name = in.String();
+      in.Strings(&val.doc_comment);
+      val.value = static_cast<int64_t>(in.Number());
+      size_t struct_index = in.Index(structs.vec.size());
+      val.struct_def = struct_index ? structs.vec[struct_index - 1] : NULL;
+    }
+  }
+  size_t root_index = in.Index(structs.vec.size());
+  std::string file_identifier = in.String();
+  std::string file_extension = in.String();
+  std::set<std::string> known_attributes;
+  size_t num_attributes = in.Count();
+  for (size_t i = 0; i < num_attributes && in.ok(); i++) {
+    known_attributes.insert(in.String());
+  }
+  bool ok = in.ok() && in.AtEnd() && namespaces.size();
+  if (ok) {
+    structs_.swap(structs);
+    enums_.swap(enums);
+    namespaces_.swap(namespaces);
+    root_struct_def_ = root_index ? structs_.vec[root_index - 1] : NULL;
+    file_identifier_ = file_identifier;
+    file_extension_ = file_extension;
+    known_attributes_.swap(known_attributes);
+  }
+  // The old namespaces if ok, otherwise the ones read.
+  for (std::vector<Namespace *>::const_iterator it = namespaces.begin();
+       it != namespaces.end(); ++it) {
+    delete *it;
+  }
+  return ok;
+}
+
+std::string SchemaCache::Key(const std::string &state,
+                             const std::string &include_paths,
+                             const std::string &filepath,
+                             const std::string &contents) {
+  uint64_t hash = FnvTraits<uint64_t>::kOffsetBasis;
+  const std::string *parts[] = { &state, &include_paths, &filepath,
+                                 &contents };
+  for (size_t i = 0; i < sizeof(parts) / sizeof(parts[0]); i++) {
+    // Separate the parts by their length, so they can't run into each other.
+    std::string len = NumToString(parts[i]->length()) + ":";
+    for (size_t j = 0; j < len.length(); j++) {
+      hash ^= static_cast<unsigned char>(len[j]);
+      hash *= FnvTraits<uint64_t>::kFnvPrime;
+    }
+    for (std::string::const_iterator it = parts[i]->begin();
+         it != parts[i]->end(); ++it) {
+      hash ^= static_cast<unsigned char>(*it);
+      hash *= FnvTraits<uint64_t>::kFnvPrime;
+    }
+  }
+  return IntToStringHex(static_cast<int>(hash >> 32), 8) +
+         IntToStringHex(static_cast<int>(hash), 8);
+}
+
+static const char kSchemaCacheVersion[] = "flatbuffers schema cache 1";
+
+void SchemaCache::WriteEntry(const Entry &entry, std::string *out) {
+  WriteString(out, kSchemaCacheVersion);
+  WriteString(out, entry.state_before);
+  WriteString(out, entry.include_paths);
+  WriteNumber(out, entry.files.size());
+  for (std::vector<std::pair<std::string, std::string> >::const_iterator it =
+         entry.files.begin(); it != entry.files.end(); ++it) {
+    WriteString(out, it->first);
+    WriteString(out, it->second);
+  }
+  WriteNumber(out, entry.includes.size());
+  for (std::vector<std::pair<std::string, bool> >::const_iterator it =
+         entry.includes.begin(); it != entry.includes.end(); ++it) {
+    WriteString(out, it->first);
+    WriteNumber(out, it->second);
+  }
+  WriteNumber(out, entry.new_files.size());
+  for (std::map<std::string, std::set<std::string> >::const_iterator it =
+         entry.new_files.begin(); it != entry.new_files.end(); ++it) {
+    WriteString(out, it->first);
+    WriteStrings(out, std::vector<std::string>(it->second.begin(),
+                                               it->second.end()));
+  }
+  WriteString(out, entry.parser_state);
+  WriteString(out, entry.state_after);
+}
+
+bool SchemaCache::ReadEntry(const std::string &in_str, Entry *entry) {
+  StateReader in(in_str);
+  if (in.String() != kSchemaCacheVersion) return false;
+  entry->state_before = in.String();
+  entry->include_paths = in.String();
+  size_t num_files = in.Count();
+  for (size_t i = 0; i < num_files && in.ok(); i++) {
+    std::string path = in.String();
+    entry->files.push_back(std::make_pair(path, in.String()));
+  }
+  size_t num_includes = in.Count();
+  for (size_t i = 0; i < num_includes && in.ok(); i++) {
+    std::string path = in.String();
+    entry->includes.push_back(std::make_pair(path, in.Number() != 0));
+  }
+  size_t num_new_files = in.Count();
+  for (size_t i = 0; i < num_new_files && in.ok(); i++) {
+    std::string path = in.String();
+    std::vector<std::string> included;
+    in.Strings(&included);
+    entry->new_files[path].insert(included.begin(), included.end());
+  }
+  entry->parser_state = in.String();
+  entry->state_after = in.String();
+  return in.ok() && in.AtEnd() && entry->files.size();
+}
+
+std::string SchemaCache::FileName(const std::string &key) const {
+  return ConCatPathFileName(directory_, key + ".fbscache");
+}
+
+const SchemaCache::Entry *SchemaCache::Lookup(const std::string &key) {
+  std::map<std::string, Entry>::const_iterator it = entries_.find(key);
+  if (it != entries_.end()) return &it->second;
+  if (directory_.empty()) return NULL;
+  std::string data;
+  Entry entry;
+  if (!LoadFile(FileName(key).c_str(), true, &data) ||
+      !ReadEntry(data, &entry))
+    return NULL;
+  return &(entries_[key] = entry);
+}
+
+void SchemaCache::Store(const std::string &key, const Entry &entry) {
+  entries_[key] = entry;
+  if (directory_.empty()) return;
+  std::string data;
+  WriteEntry(entry, &data);
+  // Write to a file of our own first, so other processes using the same
+  // directory never see a partially written entry.
+  std::string file_name = FileName(key);
+  std::string tmp_name = file_name + "." + NumToString(getpid()) + ".tmp";
+  EnsureDirExists(directory_);
+  if (!SaveFile(tmp_name.c_str(), data, true) ||
+      std::rename(tmp_name.c_str(), file_name.c_str()) != 0) {
+    std::remove(tmp_name.c_str());
+  }
+}
+
 std::set<std::string> Parser::GetIncludedFilesRecursive(
     const std::string &file_name) const {
   std::set<std::string> included_files;
@@ -1398,7 +2141,8 @@ Offset<reflection::Field> FieldDef::Serialize(FlatBufferBuilder *builder,
                                    : 0.0,
                                  deprecated,
                                  required,
-                                 key);
+                                 key,
+                                 offset64);
   // TODO: value.constant is almost always "0", we could save quite a bit of
   // space by sharing it. Same for common values of value.type.
 }
@@ -14,8 +14,12 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <set>
+
 #include "flatbuffers/reflection.h"
 #include "flatbuffers/util.h"
+#include "flatbuffers/hash.h"
 
 // Helper functionality for reflection.
 
@@ -149,71 +153,125 @@ void SetAnyValueS(reflection::BaseType type, uint8_t *data, const char *val) {
   }
 }
 
-// Resize a FlatBuffer in-place by iterating through all offsets in the buffer
-// and adjusting them by "delta" if they straddle the start offset.
-// Once that is done, bytes can now be inserted/deleted safely.
-// "delta" may be negative (shrinking).
-// Unless "delta" is a multiple of the largest alignment, you'll create a small
-// amount of garbage space in the buffer (usually 0..7 bytes).
+// Resize a FlatBuffer by iterating through all offsets in the buffer and
+// adjusting them by the bytes inserted/deleted at any of "edits" in between
+// the offset and what it points to. Once that is done, the buffer is rebuilt
+// with the bytes inserted/deleted, in a single copy.
+// Deltas are multiples of the largest alignment, and edits with a zero delta
+// or at the same position as another are not allowed. Positive deltas insert
+// zero bytes before "pos", negative ones remove the bytes starting at "pos".
 // If your FlatBuffer's root table is not the schema's root table, you should
 // pass in your root_table type as well.
 class ResizeContext {
  public:
-  ResizeContext(const reflection::Schema &schema, uoffset_t start, int delta,
+  typedef std::vector<std::pair<uoffset_t, int> > Edits;  // pos, delta.
+
+  ResizeContext(const reflection::Schema &schema, const Edits &edits,
                 std::vector<uint8_t> *flatbuf,
                 const reflection::Object *root_table = NULL)
-     : schema_(schema), startptr_(flatbuf->data() + start),
-       delta_(delta), buf_(*flatbuf),
+     : schema_(schema), buf_(*flatbuf),
        dag_check_(flatbuf->size() / sizeof(uoffset_t), false) {
-    int32_t mask = static_cast<int>(sizeof(largest_scalar_t) - 1);
-    delta_ = (delta_ + mask) & ~mask;
-    if (!delta_) return;  // We can't shrink by less than largest_scalar_t.
-    // Now change all the offsets by delta_.
+    assert(edits.size());
+    edits_ = edits;
+    std::sort(edits_.begin(), edits_.end());
+    shifts_.push_back(0);
+    for (Edits::const_iterator it = edits_.begin(); it != edits_.end(); ++it) {
+      assert(it->second && !(it->second % sizeof(largest_scalar_t)));
+      assert(it == edits_.begin() || (it - 1)->first < it->first);
+      positions_.push_back(it->first);
+      shifts_.push_back(shifts_.back() + it->second);
+    }
+    // Now change all the offsets, in one pass over everything reachable from
+    // the root.
     Table* root = GetAnyRoot(buf_.data());
-    Straddle<uoffset_t, 1>(buf_.data(), root, buf_.data());
+    Adjust<uoffset_t, 1>(buf_.data(), root, buf_.data());
     ResizeTable(root_table ? *root_table : *schema.root_table(), root);
-    // We can now add or remove bytes at start.
-    if (delta_ > 0) buf_.insert(buf_.begin() + start, delta_, 0);
-    else buf_.erase(buf_.begin() + start, buf_.begin() + start - delta_);
-  }
-
-  // Check if the range between first (lower address) and second straddles
-  // the insertion point. If it does, change the offset at offsetloc (of
-  // type T, with direction D).
-  template<typename T, int D> void Straddle(void *first, void *second,
-                                            void *offsetloc) {
-    if (first <= startptr_ && second >= startptr_) {
-      WriteScalar<T>(offsetloc, ReadScalar<T>(offsetloc) + delta_ * D);
-      DagCheck(offsetloc) = true;
+    // We can now add or remove bytes at all positions at once.
+    std::vector<uint8_t> newbuf;
+    newbuf.reserve(buf_.size() + shifts_.back());
+    uoffset_t copied = 0;
+    for (Edits::const_iterator it = edits_.begin(); it != edits_.end(); ++it) {
+      newbuf.insert(newbuf.end(), buf_.begin() + copied,
+                    buf_.begin() + it->first);
+      if (it->second > 0) {
+        newbuf.insert(newbuf.end(), it->second, 0);
+        copied = it->first;
+      } else {
+        copied = it->first - it->second;
+      }
     }
+    newbuf.insert(newbuf.end(), buf_.begin() + copied, buf_.end());
+    buf_.swap(newbuf);
+  }
+
+  // How much the byte at offset "pos" in the original buffer moves by.
+  int Shift(uoffset_t pos) const {
+    return shifts_[std::upper_bound(positions_.begin(), positions_.end(),
+                                    pos) - positions_.begin()];
+  }
+
+  // Same for a pointer into the original buffer, while it is adjusted.
+  int Shift(const void *ptr) const {
+    return Shift(static_cast<uoffset_t>(static_cast<const uint8_t *>(ptr) -
+                                        buf_.data()));
+  }
+
+  // Where the byte at offset "pos" in the original buffer ends up.
+  uoffset_t NewPosition(uoffset_t pos) const { return pos + Shift(pos); }
+
+  // Change the offset at offsetloc (of type T, with direction D) pointing
+  // between first (lower address) and second, if they move apart.
+  template<typename T, int D> void Adjust(const void *first,
+                                          const void *second,
+                                          void *offsetloc) {
+    int delta = Shift(second) - Shift(first);
+    if (delta) WriteScalar<T>(offsetloc, ReadScalar<T>(offsetloc) + delta * D);
   }
 
   // This returns a boolean that records if the corresponding offset location
-  // has been modified already. If so, we can't even read the corresponding
-  // offset, since it is pointing to a location that is illegal until the
-  // resize actually happens.
-  // This must be checked for every offset, since we can't know which offsets
-  // will straddle and which won't.
-  uint8_t &DagCheck(void *offsetloc) {
-    int64_t dag_idx = reinterpret_cast<uoffset_t *>(offsetloc) -
-                   reinterpret_cast<uoffset_t *>(buf_.data());
+  // has been visited already. If so, we've already adjusted it, and anything
+  // it points to.
+  std::vector<bool>::reference DagCheck(const void *offsetloc) {
+    size_t dag_idx = reinterpret_cast<const uoffset_t *>(offsetloc) -
+                     reinterpret_cast<const uoffset_t *>(buf_.data());
     return dag_check_[dag_idx];
   }
 
   void ResizeTable(const reflection::Object &objectdef, Table *table) {
     if (DagCheck(table))
       return;  // Table already visited.
+    DagCheck(table) = true;
     uint8_t* vtable = table->GetVTable();
-    // Check if the vtable offset points beyond the insertion point.
-    Straddle<soffset_t, -1>(table, vtable, table);
-    // This direction shouldn't happen because vtables that sit before tables
-    // are always directly adjacent, but check just in case we ever change the
-    // way flatbuffers are built.
-    Straddle<soffset_t, -1>(vtable, table, table);
+    uint8_t* tableloc = reinterpret_cast<uint8_t *>(table);
     // Early out: since all fields inside the table must point forwards in
-    // memory, if the insertion point is before the table we can stop here.
+    // memory, if there are no edits after the table we only need to check
+    // its vtable offset.
+    if (tableloc < buf_.data() + positions_.back())
+      ResizeFields(objectdef, table);
+    // Vtables normally sit before their tables, but may be either side.
+    // Adjusted last, since the fields above are found through it.
+    if (vtable < tableloc) Adjust<soffset_t, 1>(vtable, table, table);
+    else Adjust<soffset_t, -1>(table, vtable, table);
+  }
+
+  // Adjust a 64bit offset to a vector of scalars or structs, which may lie
+  // past the end of buf_ (e.g. when only the front of a large buffer was
+  // loaded), in which case it moves along with the end.
+  void ResizeOffset64(uint8_t *offsetloc) {
+    if (DagCheck(offsetloc))
+      return;  // This offset already visited.
+    DagCheck(offsetloc) = true;
+    uoffset64_t offset = ReadScalar<uoffset64_t>(offsetloc);
+    uoffset64_t ref = static_cast<uoffset64_t>(offsetloc - buf_.data()) +
+                      offset;
+    int delta = (ref >= positions_.back()
+                   ? shifts_.back() : Shift(static_cast<uoffset_t>(ref))) -
+                Shift(offsetloc);
+    if (delta) WriteScalar<uoffset64_t>(offsetloc, offset + delta);
+  }
+
+  void ResizeFields(const reflection::Object &objectdef, Table *table) {
     uint8_t* tableloc = reinterpret_cast<uint8_t *>(table);
-    if (startptr_ <= tableloc) return;
     // Check each field.
       const flatbuffers::Vector<flatbuffers::Offset<reflection::Field> > * fielddefs = objectdef.fields();
       for (Vector<Offset<reflection::Field> >::const_iterator it = fielddefs->begin(); it != fielddefs->end(); ++it) {
@@ -224,6 +282,10 @@ class ResizeContext {
       // Ignore fields that are not stored.
       voffset_t offset = table->GetOptionalFieldOffset(fielddef.offset());
       if (!offset) continue;
+      if (fielddef.offset64()) {
+        ResizeOffset64(tableloc + offset);
+        continue;
+      }
       // Ignore structs.
       const reflection::Object* subobjectdef = base_type == reflection::Obj ?
         schema_.objects()->Get(fielddef.type()->index()) : NULL;
@@ -232,8 +294,9 @@ class ResizeContext {
       uint8_t* offsetloc = tableloc + offset;
       if (DagCheck(offsetloc))
         continue;  // This offset already visited.
+      DagCheck(offsetloc) = true;
       uint8_t* ref = offsetloc + ReadScalar<uoffset_t>(offsetloc);
-      Straddle<uoffset_t, 1>(offsetloc, ref, offsetloc);
+      Adjust<uoffset_t, 1>(offsetloc, ref, offsetloc);
       // Recurse.
       switch (base_type) {
         case reflection::Obj: {
@@ -253,8 +316,9 @@ class ResizeContext {
             uint8_t* loc = vec->Data() + i * sizeof(uoffset_t);
             if (DagCheck(loc))
               continue;  // This offset already visited.
+            DagCheck(loc) = true;
             uint8_t* dest = loc + vec->Get(i);
-            Straddle<uoffset_t, 1>(loc, dest ,loc);
+            Adjust<uoffset_t, 1>(loc, dest ,loc);
             if (elemobjectdef)
               ResizeTable(*elemobjectdef, reinterpret_cast<Table *>(dest));
           }
@@ -277,52 +341,139 @@ class ResizeContext {
 
  private:
   const reflection::Schema &schema_;
-  uint8_t *startptr_;
-  int delta_;
   std::vector<uint8_t> &buf_;
-  std::vector<uint8_t> dag_check_;
+  Edits edits_;
+  // The position of each edit in the original buffer, in order, and the
+  // total delta of the edits before each of them (and of all of them).
+  std::vector<uoffset_t> positions_;
+  std::vector<int> shifts_;
+  std::vector<bool> dag_check_;
 };
 
+// Round delta down to a multiple of the largest alignment (for shrinking,
+// towards 0), so the alignment of everything after it is kept. Other than
+// that, we can't shrink by less than largest_scalar_t.
+static int AlignDelta(int delta) {
+  int32_t mask = static_cast<int>(sizeof(largest_scalar_t) - 1);
+  return (delta + mask) & ~mask;
+}
+
+ResizeBatch::ResizeBatch(const reflection::Schema &schema,
+                         std::vector<uint8_t> *flatbuf,
+                         const reflection::Object *root_table)
+    : schema_(schema), flatbuf_(flatbuf), root_table_(root_table) {}
+
+void ResizeBatch::SetString(const String *str, const std::string &val) {
+  Change change;
+  change.object = static_cast<uoffset_t>(
+    reinterpret_cast<const uint8_t *>(str) - flatbuf_->data());
+  change.old_length = str->Length();
+  change.new_length = static_cast<uoffset_t>(val.size());
+  change.elem_size = 1;
+  change.is_string = true;
+  change.data = val;
+  changes_.push_back(change);
+}
+
+void ResizeBatch::ResizeAnyVector(const VectorOfAny *vec, uoffset_t num_elems,
+                                  uoffset_t newsize, uoffset_t elem_size,
+                                  const uint8_t *val) {
+  Change change;
+  change.object = static_cast<uoffset_t>(
+    reinterpret_cast<const uint8_t *>(vec) - flatbuf_->data());
+  change.old_length = num_elems;
+  change.new_length = newsize;
+  change.elem_size = elem_size;
+  change.is_string = false;
+  if (val) change.data.assign(reinterpret_cast<const char *>(val), elem_size);
+  changes_.push_back(change);
+}
+
+void ResizeBatch::Apply() {
+  ResizeContext::Edits edits;
+  for (std::vector<Change>::const_iterator it = changes_.begin();
+       it != changes_.end(); ++it) {
+    const Change &change = *it;
+    uint8_t *data = flatbuf_->data() + change.object + sizeof(uoffset_t);
+    int delta_bytes = (static_cast<int>(change.new_length) -
+                       static_cast<int>(change.old_length)) *
+                      static_cast<int>(change.elem_size);
+    int delta = AlignDelta(delta_bytes);
+    if (change.is_string) {
+      // Clear the old string, since we don't want parts of it remaining.
+      // Any bytes removed come from its start, and the new string is
+      // written over it afterwards.
+      memset(data, 0, change.old_length);
+      if (delta) edits.push_back(std::make_pair(change.object +
+                                   static_cast<uoffset_t>(sizeof(uoffset_t)),
+                                   delta));
+    } else if (delta_bytes < 0) {
+      // Clear elements we're throwing away, since some might remain in the
+      // buffer, and shrink the vector before offsets are adjusted, so they
+      // are not visited. Any bytes removed come from its end.
+      uoffset_t size_clear = static_cast<uoffset_t>(-delta_bytes);
+      uoffset_t end = change.old_length * change.elem_size;
+      memset(data + end - size_clear, 0, size_clear);
+      WriteScalar(data - sizeof(uoffset_t), change.new_length);
+      if (delta) edits.push_back(std::make_pair(change.object +
+                                   static_cast<uoffset_t>(sizeof(uoffset_t)) +
+                                   end + delta, delta));
+    } else if (delta) {
+      edits.push_back(std::make_pair(change.object +
+                        static_cast<uoffset_t>(sizeof(uoffset_t)) +
+                        change.old_length * change.elem_size, delta));
+    }
+  }
+  if (edits.size()) {
+    ResizeContext rc(schema_, edits, flatbuf_, root_table_);
+    for (std::vector<Change>::iterator it = changes_.begin();
+         it != changes_.end(); ++it) {
+      it->object = rc.NewPosition(it->object);
+    }
+  }
+  for (std::vector<Change>::const_iterator it = changes_.begin();
+       it != changes_.end(); ++it) {
+    const Change &change = *it;
+    uint8_t *length = flatbuf_->data() + change.object;
+    uint8_t *data = length + sizeof(uoffset_t);
+    if (change.is_string) {
+      // Copy new data. Safe because we created the right amount of space.
+      WriteScalar(length, change.new_length);
+      memcpy(data, change.data.c_str(), change.data.size() + 1);
+    } else if (change.new_length > change.old_length) {
+      WriteScalar(length, change.new_length);
+      // New elements are 0 unless a value was given.
+      if (change.data.size()) {
+        for (uoffset_t i = change.old_length; i < change.new_length; i++) {
+          memcpy(data + i * change.elem_size, change.data.c_str(),
+                 change.elem_size);
+        }
+      }
+    }
+  }
+  changes_.clear();
+}
+
 void SetString(const reflection::Schema &schema, const std::string &val,
                       const String *str, std::vector<uint8_t> *flatbuf,
                       const reflection::Object *root_table) {
-  int32_t delta = static_cast<int>(val.size()) - static_cast<int>(str->Length());
-  uoffset_t start = static_cast<uoffset_t>(reinterpret_cast<const uint8_t *>(str) -
-                                      flatbuf->data() +
-                                      sizeof(uoffset_t));
-  if (delta) {
-    // Clear the old string, since we don't want parts of it remaining.
-    memset(flatbuf->data() + start, 0, str->Length());
-    // Different size, we must expand (or contract).
-    ResizeContext(schema, start, delta, flatbuf, root_table);
-  }
-  // Copy new data. Safe because we created the right amount of space.
-  memcpy(flatbuf->data() + start, val.c_str(), val.size() + 1);
+  ResizeBatch batch(schema, flatbuf, root_table);
+  batch.SetString(str, val);
+  batch.Apply();
 }
 
 uint8_t *ResizeAnyVector(const reflection::Schema &schema, uoffset_t newsize,
                          const VectorOfAny *vec, uoffset_t num_elems,
                          uoffset_t elem_size, std::vector<uint8_t> *flatbuf,
                          const reflection::Object *root_table) {
-  int32_t delta_elem = static_cast<int>(newsize) - static_cast<int>(num_elems);
-  int32_t delta_bytes = delta_elem * static_cast<int>(elem_size);
-  int64_t vec_start = reinterpret_cast<const uint8_t *>(vec) - flatbuf->data();
-  uoffset_t start = static_cast<uoffset_t>(vec_start + sizeof(uoffset_t) +
-                                      elem_size * num_elems);
-  if (delta_bytes) {
-    if (delta_elem < 0) {
-      // Clear elements we're throwing away, since some might remain in the
-      // buffer.
-      size_t size_clear = -delta_elem * elem_size;
-      memset(flatbuf->data() + start - size_clear, 0, size_clear);
-    }
-    ResizeContext(schema, start, delta_bytes, flatbuf, root_table);
-    WriteScalar(flatbuf->data() + vec_start, newsize);  // Length field.
-    // Set new elements to 0.. this can be overwritten by the caller.
-    if (delta_elem > 0) {
-      memset(flatbuf->data() + start, 0, delta_elem * elem_size);
-    }
-  }
+  // The vector itself doesn't move, and neither does anything up to its
+  // original end, where elements are added.
+  uoffset_t start = static_cast<uoffset_t>(
+    reinterpret_cast<const uint8_t *>(vec) - flatbuf->data() +
+    sizeof(uoffset_t) + elem_size * num_elems);
+  ResizeBatch batch(schema, flatbuf, root_table);
+  batch.ResizeAnyVector(vec, num_elems, newsize, elem_size);
+  batch.Apply();
   return flatbuf->data() + start;
 }
 
@@ -351,7 +502,8 @@ void CopyInline(FlatBufferBuilder &fbb, const reflection::Field &fielddef,
 Offset<const Table *> CopyTable(FlatBufferBuilder &fbb,
                                 const reflection::Schema &schema,
                                 const reflection::Object &objectdef,
-                                const Table &table) {
+                                const Table &table,
+                                bool use_string_pooling) {
   // Before we can construct the table, we have to first generate any
   // subobjects, and collect their offsets.
   std::vector<uoffset_t> offsets;
@@ -360,24 +512,30 @@ Offset<const Table *> CopyTable(FlatBufferBuilder &fbb,
     const reflection::Field &fielddef = **it;
     // Skip if field is not present in the source.
     if (!table.CheckField(fielddef.offset())) continue;
+    // Vectors after the end of a large buffer can't be copied along.
+    if (fielddef.offset64()) continue;
     uoffset_t offset = 0;
     switch (fielddef.type()->base_type()) {
       case reflection::String: {
-        offset = fbb.CreateString(GetFieldS(table, fielddef)).o;
+        offset = use_string_pooling
+          ? fbb.CreateSharedString(GetFieldS(table, fielddef)).o
+          : fbb.CreateString(GetFieldS(table, fielddef)).o;
         break;
       }
       case reflection::Obj: {
         const reflection::Object &subobjectdef = *schema.objects()->Get(fielddef.type()->index());
         if (!subobjectdef.is_struct()) {
           offset = CopyTable(fbb, schema, subobjectdef,
-                             *GetFieldT(table, fielddef)).o;
+                             *GetFieldT(table, fielddef),
+                             use_string_pooling).o;
         }
         break;
       }
       case reflection::Union: {
         const reflection::Object &subobjectdef = GetUnionType(schema, objectdef, fielddef, table);
         offset = CopyTable(fbb, schema, subobjectdef,
-                           *GetFieldT(table, fielddef)).o;
+                           *GetFieldT(table, fielddef),
+                           use_string_pooling).o;
         break;
       }
       case reflection::Vector: {
@@ -392,7 +550,9 @@ Offset<const Table *> CopyTable(FlatBufferBuilder &fbb,
             std::vector<Offset<const String *> > elements(vec->size());
             const Vector<Offset<String> > * vec_s = reinterpret_cast<const Vector<Offset<String> > *>(vec);
             for (uoffset_t i = 0; i < vec_s->size(); i++) {
-              elements[i] = fbb.CreateString(vec_s->Get(i)).o;
+              elements[i] = use_string_pooling
+                ? fbb.CreateSharedString(vec_s->Get(i)).o
+                : fbb.CreateString(vec_s->Get(i)).o;
             }
             offset = fbb.CreateVector(elements).o;
             break;
@@ -402,7 +562,8 @@ Offset<const Table *> CopyTable(FlatBufferBuilder &fbb,
               std::vector<Offset<const Table *> > elements(vec->size());
               for (uoffset_t i = 0; i < vec->size(); i++) {
                 elements[i] =
-                  CopyTable(fbb, schema, *elemobjectdef, *vec->Get(i));
+                  CopyTable(fbb, schema, *elemobjectdef, *vec->Get(i),
+                            use_string_pooling);
               }
               offset = fbb.CreateVector(elements).o;
               break;
@@ -411,9 +572,13 @@ Offset<const Table *> CopyTable(FlatBufferBuilder &fbb,
           }
           default: {  // Scalars and structs.
             size_t element_size = GetTypeSize(element_base_type);
-            if (elemobjectdef && elemobjectdef->is_struct())
+            size_t element_align = element_size;
+            if (elemobjectdef && elemobjectdef->is_struct()) {
               element_size = elemobjectdef->bytesize();
-            fbb.StartVector(element_size, vec->size());
+              element_align = elemobjectdef->minalign();
+            }
+            fbb.StartVector(vec->size() * element_size / element_align,
+                            element_align);
             fbb.PushBytes(vec->Data(), element_size * vec->size());
             offset = fbb.EndVector(vec->size());
             break;
@@ -435,7 +600,7 @@ Offset<const Table *> CopyTable(FlatBufferBuilder &fbb,
   size_t offset_idx = 0;
     for (Vector<Offset<reflection::Field> >::const_iterator it = fielddefs->begin(); it != fielddefs->end(); ++it) {
     const reflection::Field &fielddef = **it;
-    if (!table.CheckField(fielddef.offset())) continue;
+    if (!table.CheckField(fielddef.offset()) || fielddef.offset64()) continue;
     reflection::BaseType base_type = fielddef.type()->base_type();
     switch (base_type) {
       case reflection::Obj: {
@@ -468,4 +633,763 @@ Offset<const Table *> CopyTable(FlatBufferBuilder &fbb,
   }
 }
 
+CopyPlan::CopyPlan(const reflection::Schema &schema,
+                   const reflection::Object *root_table)
+    : schema_(schema), root_table_(root_table ? root_table
+                                              : schema.root_table()),
+      ok_(true), root_index_(-1) {
+  Selections selections(1);
+  selections[0].all = true;
+  Compile(selections);
+}
+
+CopyPlan::CopyPlan(const reflection::Schema &schema,
+                   const std::vector<std::string> &paths,
+                   const reflection::Object *root_table)
+    : schema_(schema), root_table_(root_table ? root_table
+                                              : schema.root_table()),
+      ok_(true), root_index_(-1) {
+  Selections selections(1);
+  for (std::vector<std::string>::const_iterator it = paths.begin();
+       it != paths.end(); ++it) {
+    if (!Select(&selections, *it)) ok_ = false;
+  }
+  Compile(selections);
+}
+
+bool CopyPlan::Select(Selections *selections, const std::string &path) const {
+  if (!root_table_) return false;
+  if (path.empty()) {
+    (*selections)[0].all = true;
+    return true;
+  }
+  // Only add to the selections once we know the whole path is valid.
+  Selections selected = *selections;
+  const reflection::Object *objectdef = root_table_;
+  size_t current = 0;
+  for (size_t start = 0; ; ) {
+    if (!objectdef) return false;  // Nothing to select within this.
+    size_t end = path.find('.', start);
+    std::string name = path.substr(start, end - start);
+    const reflection::Field *fielddef =
+      objectdef->fields()->LookupByKey(name.c_str());
+    if (!fielddef) return false;
+    std::map<std::string, size_t>::iterator it =
+      selected[current].fields.find(name);
+    if (it == selected[current].fields.end()) {
+      selected[current].fields[name] = selected.size();
+      current = selected.size();
+      selected.push_back(Selection());
+    } else {
+      current = it->second;
+    }
+    // Paths can go into tables and vectors of tables.
+    const reflection::Type &type = *fielddef->type();
+    objectdef = NULL;
+    if (type.base_type() == reflection::Obj ||
+        (type.base_type() == reflection::Vector &&
+         type.element() == reflection::Obj)) {
+      const reflection::Object *subobjectdef =
+        schema_.objects()->Get(type.index());
+      if (!subobjectdef->is_struct()) objectdef = subobjectdef;
+    }
+    if (end == std::string::npos) break;
+    start = end + 1;
+  }
+  selected[current].all = true;
+  selections->swap(selected);
+  return true;
+}
+
+void CopyPlan::Compile(const Selections &selections) {
+  const Vector<Offset<reflection::Object> > &objects = *schema_.objects();
+  for (uoffset_t i = 0; i < objects.size(); i++) {
+    object_indices_[objects.Get(i)] = static_cast<int>(i);
+  }
+  all_plans_.resize(objects.size(), -1);
+  if (!root_table_) return;
+  std::map<const reflection::Object *, int>::const_iterator it =
+    object_indices_.find(root_table_);
+  assert(it != object_indices_.end());
+  root_index_ = CompileObject(it->second, selections,
+                              selections[0].all ? NULL : &selections[0]);
+}
+
+int CopyPlan::CompileObject(int object_index, const Selections &selections,
+                            const Selection *selection) {
+  if (!selection && all_plans_[object_index] >= 0)
+    return all_plans_[object_index];
+  // Reserve our index first, since tables may (indirectly) contain
+  // themselves.
+  int index = static_cast<int>(objects_.size());
+  objects_.push_back(ObjectPlan());
+  if (!selection) all_plans_[object_index] = index;
+  const reflection::Object &objectdef = *schema_.objects()->Get(object_index);
+  const Vector<Offset<reflection::Field> > &fielddefs = *objectdef.fields();
+  // Unions need their type field copied along with them.
+  std::set<std::string> type_fields;
+  if (selection) {
+    for (std::map<std::string, size_t>::const_iterator it =
+           selection->fields.begin(); it != selection->fields.end(); ++it) {
+      const reflection::Field *fielddef = fielddefs.LookupByKey(
+        it->first.c_str());
+      if (fielddef->type()->base_type() == reflection::Union)
+        type_fields.insert(it->first + "_type");
+    }
+  }
+  // Compile the fields in the same order as CopyTable() copies them, so
+  // copying everything gives the same result.
+  std::vector<FieldPlan> fields;
+  voffset_t num_fields = selection ? 0
+                                   : static_cast<voffset_t>(fielddefs.size());
+  for (uoffset_t i = 0; i < fielddefs.size(); i++) {
+    const reflection::Field &fielddef = *fielddefs.Get(i);
+    const Selection *subselection = NULL;
+    if (selection) {
+      std::map<std::string, size_t>::const_iterator it =
+        selection->fields.find(fielddef.name()->str());
+      if (it != selection->fields.end()) {
+        if (!selections[it->second].all)
+          subselection = &selections[it->second];
+      } else if (!type_fields.count(fielddef.name()->str())) {
+        continue;
+      }
+      voffset_t id = static_cast<voffset_t>(
+        (fielddef.offset() - FieldIndexToOffset(0)) / sizeof(voffset_t));
+      num_fields = std::max(num_fields, static_cast<voffset_t>(id + 1));
+    }
+    if (fielddef.offset64()) {
+      // Vectors after the end of a large buffer can't be copied along.
+      ok_ = false;
+      continue;
+    }
+    const reflection::Type &type = *fielddef.type();
+    FieldPlan field;
+    field.offset = fielddef.offset();
+    field.type_offset = 0;
+    field.kind = kInline;
+    field.size = GetTypeSize(type.base_type());
+    field.align = field.size;
+    field.index = 0;
+    switch (type.base_type()) {
+      case reflection::String:
+        field.kind = kString;
+        break;
+      case reflection::Obj: {
+        const reflection::Object &subobjectdef = *schema_.objects()->Get(
+          type.index());
+        if (subobjectdef.is_struct()) {
+          field.size = subobjectdef.bytesize();
+          field.align = subobjectdef.minalign();
+        } else {
+          field.kind = kTable;
+          field.index = CompileObject(type.index(), selections, subselection);
+        }
+        break;
+      }
+      case reflection::Union: {
+        field.kind = kUnion;
+        field.index = CompileUnion(fielddef, selections);
+        const reflection::Field *type_field = fielddefs.LookupByKey(
+          (fielddef.name()->str() + "_type").c_str());
+        assert(type_field);
+        field.type_offset = type_field->offset();
+        break;
+      }
+      case reflection::Vector: {
+        field.kind = kVector;
+        field.size = GetTypeSize(type.element());
+        field.align = field.size;
+        if (type.element() == reflection::String) {
+          field.kind = kVectorOfStrings;
+        } else if (type.element() == reflection::Obj) {
+          const reflection::Object &subobjectdef = *schema_.objects()->Get(
+            type.index());
+          if (subobjectdef.is_struct()) {
+            field.size = subobjectdef.bytesize();
+            field.align = subobjectdef.minalign();
+          } else {
+            field.kind = kVectorOfTables;
+            field.index = CompileObject(type.index(), selections,
+                                        subselection);
+          }
+        }
+        break;
+      }
+      default:  // Scalars.
+        break;
+    }
+    fields.push_back(field);
+  }
+  ObjectPlan &plan = objects_[index];
+  plan.fields_start = fields_.size();
+  fields_.insert(fields_.end(), fields.begin(), fields.end());
+  plan.fields_end = fields_.size();
+  plan.num_fields = num_fields;
+  return index;
+}
+
+size_t CopyPlan::CompileUnion(const reflection::Field &fielddef,
+                              const Selections &selections) {
+  size_t index = union_plans_.size();
+  union_plans_.push_back(std::vector<int>());
+  std::vector<int> types;
+  const reflection::Enum &enumdef = *schema_.enums()->Get(
+    fielddef.type()->index());
+  const Vector<Offset<reflection::EnumVal> > &values = *enumdef.values();
+  for (uoffset_t i = 0; i < values.size(); i++) {
+    const reflection::EnumVal &enumval = *values.Get(i);
+    // Union types are stored as a ubyte.
+    if (!enumval.object() || enumval.value() <= 0 || enumval.value() > 255)
+      continue;
+    size_t value = static_cast<size_t>(enumval.value());
+    if (value >= types.size()) types.resize(value + 1, -1);
+    types[value] = CompileObject(object_indices_[enumval.object()],
+                                 selections, NULL);
+  }
+  union_plans_[index].swap(types);
+  return index;
+}
+
+struct CopyPlan::CopyState {
+  CopyState(FlatBufferBuilder &_fbb, bool _use_sharing, bool _compact)
+    : fbb(_fbb), use_sharing(_use_sharing || _compact), compact(_compact) {}
+
+  FlatBufferBuilder &fbb;
+  bool use_sharing;
+  bool compact;
+  // Offsets of the subobjects of all tables being copied.
+  std::vector<uoffset_t> offsets;
+  // With use_sharing, the copy of each source table per plan.
+  std::map<std::pair<const Table *, size_t>, uoffset_t> tables;
+  // With compact, the copy of each vector and table by its contents.
+  std::map<std::string, uoffset_t> objects;
+};
+
+// Appends the bytes of a value to the contents of an object.
+template<typename T> static void AppendContents(std::string *contents,
+                                                const T &val) {
+  contents->append(reinterpret_cast<const char *>(&val), sizeof(T));
+}
+
+Offset<const Table *> CopyPlan::Copy(FlatBufferBuilder &fbb,
+                                     const Table &table,
+                                     bool use_sharing) const {
+  assert(root_index_ >= 0);
+  CopyState state(fbb, use_sharing, false);
+  return CopyObject(state, static_cast<size_t>(root_index_), table);
+}
+
+Offset<const Table *> CopyPlan::Compact(FlatBufferBuilder &fbb,
+                                        const Table &table) const {
+  assert(root_index_ >= 0);
+  CopyState state(fbb, true, true);
+  return CopyObject(state, static_cast<size_t>(root_index_), table);
+}
+
+uoffset_t CopyPlan::FindShared(CopyState &state,
+                               const std::string &contents) const {
+  std::map<std::string, uoffset_t>::const_iterator it =
+    state.objects.find(contents);
+  return it != state.objects.end() ? it->second : 0;
+}
+
+void CopyPlan::AddShared(CopyState &state, const std::string &contents,
+                         uoffset_t offset) const {
+  state.objects[contents] = offset;
+}
+
+uoffset_t CopyPlan::CopyString(CopyState &state, const String *str) const {
+  return state.use_sharing ? state.fbb.CreateSharedString(str).o
+                           : state.fbb.CreateString(str).o;
+}
+
+// Creates a vector of the offsets from start onwards, and removes them.
+uoffset_t CopyPlan::EndVectorOfOffsets(CopyState &state, size_t start) const {
+  size_t len = state.offsets.size() - start;
+  std::string contents;
+  if (state.compact) {
+    // Offsets into the copy identify the elements, as they're shared too.
+    contents.reserve(1 + len * sizeof(uoffset_t));
+    contents += 'O';
+    for (size_t i = start; i < state.offsets.size(); i++) {
+      AppendContents(&contents, state.offsets[i]);
+    }
+    uoffset_t shared = FindShared(state, contents);
+    if (shared) {
+      state.offsets.resize(start);
+      return shared;
+    }
+  }
+  state.fbb.StartVector(len, sizeof(uoffset_t));
+  for (size_t i = state.offsets.size(); i > start; ) {
+    state.fbb.PushElement(Offset<void>(state.offsets[--i]));
+  }
+  state.offsets.resize(start);
+  uoffset_t vec = state.fbb.EndVector(len);
+  if (state.compact) AddShared(state, contents, vec);
+  return vec;
+}
+
+uoffset_t CopyPlan::CopyObject(CopyState &state, size_t index,
+                               const Table &table) const {
+  std::pair<const Table *, size_t> key(&table, index);
+  if (state.use_sharing) {
+    std::map<std::pair<const Table *, size_t>, uoffset_t>::const_iterator it =
+      state.tables.find(key);
+    if (it != state.tables.end()) return it->second;
+  }
+  const ObjectPlan &plan = objects_[index];
+  FlatBufferBuilder &fbb = state.fbb;
+  // Before we can construct the table, we have to first generate any
+  // subobjects, and collect their offsets (0 for those we can't copy).
+  size_t offsets_start = state.offsets.size();
+  for (size_t i = plan.fields_start; i < plan.fields_end; i++) {
+    const FieldPlan &field = fields_[i];
+    if (field.kind == kInline) continue;
+    const uint8_t *value = table.GetPointer<const uint8_t *>(field.offset);
+    if (!value) continue;
+    uoffset_t offset = 0;
+    switch (field.kind) {
+      case kString:
+        offset = CopyString(state, reinterpret_cast<const String *>(value));
+        break;
+      case kTable:
+        offset = CopyObject(state, field.index,
+                            *reinterpret_cast<const Table *>(value));
+        break;
+      case kUnion: {
+        uint8_t type = table.GetField<uint8_t>(field.type_offset, 0);
+        const std::vector<int> &types = union_plans_[field.index];
+        int type_index = type < types.size() ? types[type] : -1;
+        if (type_index >= 0) {
+          offset = CopyObject(state, static_cast<size_t>(type_index),
+                              *reinterpret_cast<const Table *>(value));
+        }
+        break;
+      }
+      case kVector: {
+        const VectorOfAny *vec = reinterpret_cast<const VectorOfAny *>(value);
+        std::string contents;
+        if (state.compact) {
+          contents += 'V';
+          AppendContents(&contents, field.align);
+          AppendContents(&contents, vec->size());
+          contents.append(reinterpret_cast<const char *>(vec->Data()),
+                          vec->size() * field.size);
+          offset = FindShared(state, contents);
+          if (offset) break;
+        }
+        fbb.StartVector(vec->size() * field.size / field.align, field.align);
+        fbb.PushBytes(vec->Data(), vec->size() * field.size);
+        offset = fbb.EndVector(vec->size());
+        if (state.compact) AddShared(state, contents, offset);
+        break;
+      }
+      case kVectorOfStrings: {
+        const Vector<Offset<String> > *vec =
+          reinterpret_cast<const Vector<Offset<String> > *>(value);
+        size_t start = state.offsets.size();
+        for (uoffset_t j = 0; j < vec->size(); j++) {
+          state.offsets.push_back(CopyString(state, vec->Get(j)));
+        }
+        offset = EndVectorOfOffsets(state, start);
+        break;
+      }
+      case kVectorOfTables: {
+        const Vector<Offset<Table> > *vec =
+          reinterpret_cast<const Vector<Offset<Table> > *>(value);
+        size_t start = state.offsets.size();
+        for (uoffset_t j = 0; j < vec->size(); j++) {
+          uoffset_t element = CopyObject(state, field.index, *vec->Get(j));
+          state.offsets.push_back(element);
+        }
+        offset = EndVectorOfOffsets(state, start);
+        break;
+      }
+    }
+    state.offsets.push_back(offset);
+  }
+  std::string contents;
+  if (state.compact) {
+    // The table is identified by the fields it will have in the copy.
+    contents += 'T';
+    AppendContents(&contents, plan.num_fields);
+    size_t offset_idx = offsets_start;
+    for (size_t i = plan.fields_start; i < plan.fields_end; i++) {
+      const FieldPlan &field = fields_[i];
+      if (field.kind == kInline) {
+        if (!table.CheckField(field.offset)) continue;
+        AppendContents(&contents, field.offset);
+        contents.append(table.GetStruct<const char *>(field.offset),
+                        field.size);
+      } else {
+        if (!table.GetPointer<const uint8_t *>(field.offset)) continue;
+        uoffset_t offset = state.offsets[offset_idx++];
+        if (!offset) continue;
+        AppendContents(&contents, field.offset);
+        AppendContents(&contents, offset);
+      }
+    }
+    uoffset_t shared = FindShared(state, contents);
+    if (shared) {
+      state.offsets.resize(offsets_start);
+      state.tables[key] = shared;
+      return shared;
+    }
+  }
+  // Now we can build the actual table from either offsets or inline data.
+  uoffset_t start = fbb.StartTable();
+  size_t offset_idx = offsets_start;
+  for (size_t i = plan.fields_start; i < plan.fields_end; i++) {
+    const FieldPlan &field = fields_[i];
+    if (field.kind == kInline) {
+      if (!table.CheckField(field.offset)) continue;
+      fbb.Align(field.align);
+      fbb.PushBytes(table.GetStruct<const uint8_t *>(field.offset),
+                    field.size);
+      fbb.TrackField(field.offset, fbb.GetSize());
+    } else {
+      if (!table.GetPointer<const uint8_t *>(field.offset)) continue;
+      uoffset_t offset = state.offsets[offset_idx++];
+      if (offset) fbb.AddOffset(field.offset, Offset<void>(offset));
+    }
+  }
+  assert(offset_idx == state.offsets.size());
+  state.offsets.resize(offsets_start);
+  uoffset_t copy = fbb.EndTable(start, plan.num_fields);
+  if (state.use_sharing) state.tables[key] = copy;
+  if (state.compact) AddShared(state, contents, copy);
+  return copy;
+}
+
+bool CompactBuffer(const reflection::Schema &schema, const uint8_t *buf,
+                   size_t len, FlatBufferBuilder *fbb,
+                   const reflection::Object *root_table) {
+  return BufferCompactor(schema, root_table).Compact(buf, len, fbb);
+}
+
+BufferCompactor::BufferCompactor(const reflection::Schema &schema,
+                                 const reflection::Object *root_table)
+    : schema_(schema),
+      root_table_(root_table ? root_table : schema.root_table()),
+      plan_(schema, root_table_),
+      verifier_(schema) {}
+
+bool BufferCompactor::Compact(const uint8_t *buf, size_t len,
+                              FlatBufferBuilder *fbb) const {
+  if (!root_table_) return false;
+  if (!verifier_.VerifyBuffer(buf, len, root_table_)) return false;
+  const char *file_identifier = schema_.file_ident() &&
+                                schema_.file_ident()->size() &&
+                                len >= sizeof(uoffset_t) +
+                                  FlatBufferBuilder::kFileIdentifierLength &&
+                                BufferHasIdentifier(buf,
+                                  schema_.file_ident()->c_str())
+                                ? schema_.file_ident()->c_str()
+                                : NULL;
+  fbb->Finish(plan_.Compact(*fbb, *GetAnyRoot(buf)), file_identifier);
+  return true;
+}
+
+SchemaVerifier::SchemaVerifier(const reflection::Schema &schema)
+    : root_index_(-1) {
+  const Vector<Offset<reflection::Object> > &objects = *schema.objects();
+  for (uoffset_t i = 0; i < objects.size(); i++) {
+    object_indices_[objects.Get(i)] = static_cast<int>(i);
+  }
+  if (schema.root_table()) root_index_ = GetObjectIndex(*schema.root_table());
+  // Map the values of each union type to the objects they stand for.
+  const Vector<Offset<reflection::Enum> > &enums = *schema.enums();
+  std::vector<size_t> union_indices(enums.size(), 0);
+  for (uoffset_t i = 0; i < enums.size(); i++) {
+    const reflection::Enum &enumdef = *enums.Get(i);
+    if (!enumdef.is_union()) continue;
+    union_indices[i] = union_objects_.size();
+    union_objects_.push_back(std::vector<int>());
+    std::vector<int> &types = union_objects_.back();
+    const Vector<Offset<reflection::EnumVal> > &values = *enumdef.values();
+    for (uoffset_t j = 0; j < values.size(); j++) {
+      const reflection::EnumVal &enumval = *values.Get(j);
+      // Union types are stored as a ubyte.
+      if (!enumval.object() || enumval.value() <= 0 || enumval.value() > 255)
+        continue;
+      size_t value = static_cast<size_t>(enumval.value());
+      if (value >= types.size()) types.resize(value + 1, -1);
+      types[value] = GetObjectIndex(*enumval.object());
+    }
+  }
+  // Compile the fields of each table, in the order they appear in the
+  // vtable (and thus typically in memory).
+  objects_.resize(objects.size());
+  for (uoffset_t i = 0; i < objects.size(); i++) {
+    const reflection::Object &objectdef = *objects.Get(i);
+    ObjectPlan &plan = objects_[i];
+    plan.fields_start = fields_.size();
+    std::vector<std::pair<voffset_t, const reflection::Field *> > fielddefs;
+    if (!objectdef.is_struct()) {
+      const Vector<Offset<reflection::Field> > &allfields = *objectdef.fields();
+      for (uoffset_t j = 0; j < allfields.size(); j++) {
+        const reflection::Field *fielddef = allfields.Get(j);
+        if (!fielddef->deprecated())
+          fielddefs.push_back(std::make_pair(fielddef->offset(), fielddef));
+      }
+      std::sort(fielddefs.begin(), fielddefs.end());
+    }
+    for (size_t j = 0; j < fielddefs.size(); j++) {
+      const reflection::Field &fielddef = *fielddefs[j].second;
+      const reflection::Type &type = *fielddef.type();
+      FieldPlan field;
+      field.offset = fielddef.offset();
+      field.type_offset = 0;
+      field.kind = kInline;
+      field.required = fielddef.required();
+      field.size = sizeof(uoffset_t);
+      field.index = 0;
+      switch (type.base_type()) {
+        case reflection::String:
+          field.kind = kString;
+          break;
+        case reflection::Obj: {
+          const reflection::Object &subobjectdef = *objects.Get(type.index());
+          if (subobjectdef.is_struct()) {
+            field.size = subobjectdef.bytesize();
+          } else {
+            field.kind = kTable;
+            field.index = type.index();
+          }
+          break;
+        }
+        case reflection::Union: {
+          field.kind = kUnion;
+          field.index = union_indices[type.index()];
+          const reflection::Field *type_field = objectdef.fields()->LookupByKey(
+            (fielddef.name()->str() + "_type").c_str());
+          assert(type_field);
+          field.type_offset = type_field->offset();
+          break;
+        }
+        case reflection::Vector:
+          if (type.element() == reflection::String) {
+            field.kind = kVectorOfStrings;
+          } else if (type.element() == reflection::Obj &&
+                     !objects.Get(type.index())->is_struct()) {
+            field.kind = kVectorOfTables;
+            field.index = type.index();
+          } else {
+            field.kind = fielddef.offset64() ? kVector64 : kVector;
+            field.size = GetTypeSizeInline(type.element(), type.index(),
+                                           schema);
+          }
+          break;
+        default:  // Scalars.
+          field.size = GetTypeSize(type.base_type());
+          break;
+      }
+      fields_.push_back(field);
+    }
+    plan.fields_end = fields_.size();
+  }
+}
+
+bool SchemaVerifier::VerifyBuffer(const uint8_t *buf, size_t buf_len,
+                                  const reflection::Object *root_table,
+                                  size_t max_depth, size_t max_tables) const {
+  int index = root_table ? GetObjectIndex(*root_table) : root_index_;
+  assert(index >= 0);
+  if (index < 0) return false;
+  Verifier verifier(buf, buf_len, max_depth, max_tables);
+  return verifier.Verify<uoffset_t>(buf) &&
+         VerifyObject(verifier, index, GetAnyRoot(buf));
+}
+
+int SchemaVerifier::GetObjectIndex(const reflection::Object &objectdef) const {
+  std::map<const reflection::Object *, int>::const_iterator it =
+    object_indices_.find(&objectdef);
+  assert(it != object_indices_.end());  // Not part of this schema.
+  return it != object_indices_.end() ? it->second : -1;
+}
+
+bool SchemaVerifier::VerifyObject(Verifier &verifier, int index,
+                                  const Table *table) const {
+  if (!table) return true;
+  if (!table->VerifyTableStart(verifier)) return false;
+  const ObjectPlan &plan = objects_[index];
+  for (size_t i = plan.fields_start; i < plan.fields_end; i++) {
+    const FieldPlan &field = fields_[i];
+    const uint8_t *field_ptr = table->GetAddressOf(field.offset);
+    if (!field_ptr) {
+      if (!verifier.Check(!field.required)) return false;
+      continue;
+    }
+    if (field.kind == kInline) {
+      if (!verifier.Verify(field_ptr, field.size)) return false;
+      continue;
+    }
+    if (field.kind == kVector64) {
+      if (!verifier.Verify<uoffset64_t>(field_ptr) ||
+          !verifier.VerifyOffset64(field_ptr) ||
+          !verifier.VerifyVector64(field_ptr + static_cast<size_t>(
+                                     ReadScalar<uoffset64_t>(field_ptr)),
+                                   field.size))
+        return false;
+      continue;
+    }
+    // Everything else is an offset to the actual value.
+    if (!verifier.Verify<uoffset_t>(field_ptr)) return false;
+    const uint8_t *value = field_ptr + ReadScalar<uoffset_t>(field_ptr);
+    const uint8_t *end;
+    bool ok = true;
+    switch (field.kind) {
+      case kString:
+        ok = verifier.Verify(reinterpret_cast<const String *>(value));
+        break;
+      case kTable:
+        ok = VerifyObject(verifier, static_cast<int>(field.index),
+                          reinterpret_cast<const Table *>(value));
+        break;
+      case kUnion:
+        ok = VerifyUnion(verifier, field, *table,
+                         reinterpret_cast<const Table *>(value));
+        break;
+      case kVector:
+        ok = verifier.VerifyVector(value, field.size, &end);
+        break;
+      case kVectorOfStrings:
+        ok = verifier.VerifyVector(value, sizeof(uoffset_t), &end) &&
+             verifier.VerifyVectorOfStrings(
+               reinterpret_cast<const Vector<Offset<String> > *>(value));
+        break;
+      case kVectorOfTables: {
+        ok = verifier.VerifyVector(value, sizeof(uoffset_t), &end);
+        const Vector<Offset<Table> > *vec =
+          reinterpret_cast<const Vector<Offset<Table> > *>(value);
+        for (uoffset_t j = 0; ok && j < vec->size(); j++) {
+          ok = VerifyObject(verifier, static_cast<int>(field.index),
+                            vec->Get(j));
+        }
+        break;
+      }
+    }
+    if (!ok) return false;
+  }
+  return verifier.EndTable();
+}
+
+bool SchemaVerifier::VerifyUnion(Verifier &verifier, const FieldPlan &field,
+                                 const Table &table,
+                                 const Table *value) const {
+  const uint8_t *type_ptr = table.GetAddressOf(field.type_offset);
+  if (type_ptr && !verifier.Verify<uint8_t>(type_ptr)) return false;
+  uint8_t type = type_ptr ? ReadScalar<uint8_t>(type_ptr) : 0;
+  if (!type) return true;  // NONE.
+  const std::vector<int> &types = union_objects_[field.index];
+  int index = type < types.size() ? types[type] : -1;
+  return verifier.Check(index >= 0) && VerifyObject(verifier, index, value);
+}
+
+SchemaIndex::SchemaIndex(const reflection::Schema &schema)
+    : root_table_(NULL) {
+  const Vector<Offset<reflection::Object> > &objects = *schema.objects();
+  size_t num_fields = 0;
+  for (uoffset_t i = 0; i < objects.size(); i++) {
+    num_fields += objects.Get(i)->fields()->size();
+  }
+  // Fill in all fields first, so pointers to them remain valid.
+  objects_.resize(objects.size());
+  fields_.reserve(num_fields);
+  for (uoffset_t i = 0; i < objects.size(); i++) {
+    const reflection::Object &objectdef = *objects.Get(i);
+    ObjectDescriptor &objectdesc = objects_[i];
+    objectdesc.is_struct = objectdef.is_struct();
+    objectdesc.bytesize = objectdef.bytesize();
+    objectdesc.num_fields = objectdef.fields()->size();
+    objectdesc.object = &objectdef;
+    for (uoffset_t j = 0; j < objectdesc.num_fields; j++) {
+      const reflection::Field &fielddef = *objectdef.fields()->Get(j);
+      const reflection::Type &type = *fielddef.type();
+      FieldDescriptor fielddesc;
+      fielddesc.offset = fielddef.offset();
+      fielddesc.base_type = type.base_type();
+      fielddesc.element = type.element();
+      fielddesc.type_index = type.index();
+      fielddesc.inline_size = GetTypeSizeInline(type.base_type(), type.index(),
+                                                schema);
+      fielddesc.default_integer = fielddef.default_integer();
+      fielddesc.default_real = fielddef.default_real();
+      fielddesc.field = &fielddef;
+      fields_.push_back(fielddesc);
+    }
+  }
+  // Keep the tables at most half full.
+  size_t num_slots = 1;
+  while (num_slots < objects.size() * 2) num_slots *= 2;
+  object_slots_.resize(num_slots);
+  num_slots = 1;
+  while (num_slots < num_fields * 2) num_slots *= 2;
+  field_slots_.resize(num_slots);
+  size_t field_index = 0;
+  for (size_t i = 0; i < objects_.size(); i++) {
+    ObjectDescriptor &objectdesc = objects_[i];
+    objectdesc.fields = field_index < fields_.size() ? &fields_[field_index]
+                                                     : NULL;
+    Insert(object_slots_,
+           HashFnv1a<uint32_t>(objectdesc.object->name()->c_str()), i);
+    for (size_t j = 0; j < objectdesc.num_fields; j++, field_index++) {
+      const char *name = fields_[field_index].field->name()->c_str();
+      Insert(field_slots_, FieldHash(objectdesc, HashFnv1a<uint32_t>(name)),
+             field_index);
+    }
+  }
+  if (schema.root_table()) root_table_ = GetObjectDesc(*schema.root_table());
+}
+
+uint32_t SchemaIndex::FieldHash(const ObjectDescriptor &objectdesc,
+                                uint32_t name_hash) {
+  // Fields of different objects with the same name shouldn't collide: mix in
+  // where the object's fields are.
+  uintptr_t fields = reinterpret_cast<uintptr_t>(objectdesc.fields);
+  return name_hash ^ static_cast<uint32_t>(fields * 0x9E3779B1U) ^
+         static_cast<uint32_t>(fields >> 16);
+}
+
+void SchemaIndex::Insert(std::vector<Slot> &slots, uint32_t hash,
+                         size_t index) {
+  size_t mask = slots.size() - 1;
+  size_t i = hash & mask;
+  while (slots[i].index) i = (i + 1) & mask;
+  slots[i].hash = hash;
+  slots[i].index = static_cast<uint32_t>(index + 1);
+}
+
+const ObjectDescriptor *SchemaIndex::LookupObject(const char *name) const {
+  if (objects_.empty()) return NULL;
+  uint32_t hash = HashFnv1a<uint32_t>(name);
+  size_t mask = object_slots_.size() - 1;
+  for (size_t i = hash & mask; object_slots_[i].index; i = (i + 1) & mask) {
+    const Slot &slot = object_slots_[i];
+    if (slot.hash != hash) continue;
+    const ObjectDescriptor &objectdesc = objects_[slot.index - 1];
+    if (!strcmp(objectdesc.object->name()->c_str(), name)) return &objectdesc;
+  }
+  return NULL;
+}
+
+const FieldDescriptor *SchemaIndex::LookupField(
+    const ObjectDescriptor &objectdesc, const char *name) const {
+  if (!objectdesc.num_fields) return NULL;
+  uint32_t hash = FieldHash(objectdesc, HashFnv1a<uint32_t>(name));
+  size_t mask = field_slots_.size() - 1;
+  for (size_t i = hash & mask; field_slots_[i].index; i = (i + 1) & mask) {
+    const Slot &slot = field_slots_[i];
+    if (slot.hash != hash) continue;
+    const FieldDescriptor &fielddesc = fields_[slot.index - 1];
+    if (&fielddesc >= objectdesc.fields &&
+        &fielddesc < objectdesc.fields + objectdesc.num_fields &&
+        !strcmp(fielddesc.field->name()->c_str(), name))
+      return &fielddesc;
+  }
+  return NULL;
+}
+
 }  // namespace flatbuffers
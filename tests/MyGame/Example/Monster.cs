@@ -64,8 +64,11 @@ public sealed class Monster : Table {
   public bool GetTestarrayofbools(int j) { int o = __offset(52); return o != 0 ? 0!=bb.Get(__vector(o) + j * 1) : false; }
   public int TestarrayofboolsLength { get { int o = __offset(52); return o != 0 ? __vector_len(o) : 0; } }
   public bool MutateTestarrayofbools(int j, bool testarrayofbools) { int o = __offset(52); if (o != 0) { bb.Put(__vector(o) + j * 1, (byte)(testarrayofbools ? 1 : 0)); return true; } else { return false; } }
+  public ulong GetTestarrayoftablesKeys(int j) { int o = __offset(54); return o != 0 ? bb.GetUlong(__vector(o) + j * 8) : (ulong)0; }
+  public int TestarrayoftablesKeysLength { get { int o = __offset(54); return o != 0 ? __vector_len(o) : 0; } }
+  public bool MutateTestarrayoftablesKeys(int j, ulong testarrayoftables_keys) { int o = __offset(54); if (o != 0) { bb.PutUlong(__vector(o) + j * 8, testarrayoftables_keys); return true; } else { return false; } }
 
-  public static void StartMonster(FlatBufferBuilder builder) { builder.StartObject(25); }
+  public static void StartMonster(FlatBufferBuilder builder) { builder.StartObject(26); }
   public static void AddPos(FlatBufferBuilder builder, Offset<Vec3> posOffset) { builder.AddStruct(0, posOffset.Value, 0); }
   public static void AddMana(FlatBufferBuilder builder, short mana) { builder.AddShort(1, mana, 150); }
   public static void AddHp(FlatBufferBuilder builder, short hp) { builder.AddShort(2, hp, 100); }
@@ -101,6 +104,9 @@ public sealed class Monster : Table {
   public static void AddTestarrayofbools(FlatBufferBuilder builder, VectorOffset testarrayofboolsOffset) { builder.AddOffset(24, testarrayofboolsOffset.Value, 0); }
   public static VectorOffset CreateTestarrayofboolsVector(FlatBufferBuilder builder, bool[] data) { builder.StartVector(1, data.Length, 1); for (int i = data.Length - 1; i >= 0; i--) builder.AddBool(data[i]); return builder.EndVector(); }
   public static void StartTestarrayofboolsVector(FlatBufferBuilder builder, int numElems) { builder.StartVector(1, numElems, 1); }
+  public static void AddTestarrayoftablesKeys(FlatBufferBuilder builder, VectorOffset testarrayoftablesKeysOffset) { builder.AddOffset(25, testarrayoftablesKeysOffset.Value, 0); }
+  public static VectorOffset CreateTestarrayoftablesKeysVector(FlatBufferBuilder builder, ulong[] data) { builder.StartVector(8, data.Length, 8); for (int i = data.Length - 1; i >= 0; i--) builder.AddUlong(data[i]); return builder.EndVector(); }
+  public static void StartTestarrayoftablesKeysVector(FlatBufferBuilder builder, int numElems) { builder.StartVector(8, numElems, 8); }
   public static Offset<Monster> EndMonster(FlatBufferBuilder builder) {
     int o = builder.EndObject();
     builder.Required(o, 10);  // name
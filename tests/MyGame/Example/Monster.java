@@ -72,8 +72,12 @@ public final class Monster extends Table {
   public int testarrayofboolsLength() { int o = __offset(52); return o != 0 ? __vector_len(o) : 0; }
   public ByteBuffer testarrayofboolsAsByteBuffer() { return __vector_as_bytebuffer(52, 1); }
   public boolean mutateTestarrayofbools(int j, boolean testarrayofbools) { int o = __offset(52); if (o != 0) { bb.put(__vector(o) + j * 1, (byte)(testarrayofbools ? 1 : 0)); return true; } else { return false; } }
+  public long testarrayoftablesKeys(int j) { int o = __offset(54); return o != 0 ? bb.getLong(__vector(o) + j * 8) : 0; }
+  public int testarrayoftablesKeysLength() { int o = __offset(54); return o != 0 ? __vector_len(o) : 0; }
+  public ByteBuffer testarrayoftablesKeysAsByteBuffer() { return __vector_as_bytebuffer(54, 8); }
+  public boolean mutateTestarrayoftablesKeys(int j, long testarrayoftables_keys) { int o = __offset(54); if (o != 0) { bb.putLong(__vector(o) + j * 8, testarrayoftables_keys); return true; } else { return false; } }
 
-  public static void startMonster(FlatBufferBuilder builder) { builder.startObject(25); }
+  public static void startMonster(FlatBufferBuilder builder) { builder.startObject(26); }
   public static void addPos(FlatBufferBuilder builder, int posOffset) { builder.addStruct(0, posOffset, 0); }
   public static void addMana(FlatBufferBuilder builder, short mana) { builder.addShort(1, mana, 150); }
   public static void addHp(FlatBufferBuilder builder, short hp) { builder.addShort(2, hp, 100); }
@@ -109,6 +113,9 @@ public final class Monster extends Table {
   public static void addTestarrayofbools(FlatBufferBuilder builder, int testarrayofboolsOffset) { builder.addOffset(24, testarrayofboolsOffset, 0); }
   public static int createTestarrayofboolsVector(FlatBufferBuilder builder, boolean[] data) { builder.startVector(1, data.length, 1); for (int i = data.length - 1; i >= 0; i--) builder.addBoolean(data[i]); return builder.endVector(); }
   public static void startTestarrayofboolsVector(FlatBufferBuilder builder, int numElems) { builder.startVector(1, numElems, 1); }
+  public static void addTestarrayoftablesKeys(FlatBufferBuilder builder, int testarrayoftablesKeysOffset) { builder.addOffset(25, testarrayoftablesKeysOffset, 0); }
+  public static int createTestarrayoftablesKeysVector(FlatBufferBuilder builder, long[] data) { builder.startVector(8, data.length, 8); for (int i = data.length - 1; i >= 0; i--) builder.addLong(data[i]); return builder.endVector(); }
+  public static void startTestarrayoftablesKeysVector(FlatBufferBuilder builder, int numElems) { builder.startVector(8, numElems, 8); }
   public static int endMonster(FlatBufferBuilder builder) {
     int o = builder.endObject();
     builder.required(o, 10);  // name
@@ -1,2 +1,3 @@
-../flatc -c -j -n -g -b -p --gen-mutable --no-includes monster_test.fbs monsterdata_test.json
+../flatc -c -j -n -g -b -p --gen-mutable --gen-lazy-verify --gen-fixed-create --no-includes monster_test.fbs monsterdata_test.json
 ../flatc -b --schema monster_test.fbs
+../flatc -c --gen-mutable --gen-lazy-verify --gen-fixed-create --no-includes large_test.fbs
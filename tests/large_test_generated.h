@@ -0,0 +1,120 @@
+// automatically generated by the FlatBuffers compiler, do not modify
+
+#ifndef FLATBUFFERS_GENERATED_LARGETEST_MYGAME_LARGE_H_
+#define FLATBUFFERS_GENERATED_LARGETEST_MYGAME_LARGE_H_
+
+#include "flatbuffers/flatbuffers.h"
+
+
+namespace MyGame {
+namespace Large {
+
+struct Point;
+struct Tile;
+
+MANUALLY_ALIGNED_STRUCT(4) Point FLATBUFFERS_FINAL_CLASS {
+ private:
+  float x_;
+  float y_;
+
+ public:
+  Point(float x, float y)
+    : x_(flatbuffers::EndianScalar(x)), y_(flatbuffers::EndianScalar(y)) { }
+
+  float x() const { return flatbuffers::EndianScalar(x_); }
+  void mutate_x(float x) { flatbuffers::WriteScalar(&x_, x); }
+  float y() const { return flatbuffers::EndianScalar(y_); }
+  void mutate_y(float y) { flatbuffers::WriteScalar(&y_, y); }
+};
+STRUCT_END(Point, 8);
+
+struct Tile FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  const flatbuffers::String *name() const { return GetPointer<const flatbuffers::String *>(4); }
+  flatbuffers::String *mutable_name() { return GetPointer<flatbuffers::String *>(4); }
+  const flatbuffers::Vector64<float > *weights() const { return GetPointer64<const flatbuffers::Vector64<float > *>(6); }
+  flatbuffers::Vector64<float > *mutable_weights() { return GetPointer64<flatbuffers::Vector64<float > *>(6); }
+  const flatbuffers::Vector64<Point > *points() const { return GetPointer64<const flatbuffers::Vector64<Point > *>(8); }
+  flatbuffers::Vector64<Point > *mutable_points() { return GetPointer64<flatbuffers::Vector64<Point > *>(8); }
+  /// A Tile of lower resolution, in a buffer of its own.
+  const flatbuffers::Vector64<uint8_t > *preview() const { return GetPointer64<const flatbuffers::Vector64<uint8_t > *>(10); }
+  flatbuffers::Vector64<uint8_t > *mutable_preview() { return GetPointer64<flatbuffers::Vector64<uint8_t > *>(10); }
+  const MyGame::Large::Tile *preview_nested_root() const { return flatbuffers::GetRoot<MyGame::Large::Tile>(preview()->Data()); }
+  uint64_t id() const { return GetField<uint64_t>(12, 0); }
+  bool mutate_id(uint64_t id) { return SetField(12, id); }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, 4 /* name */) &&
+           verifier.Verify(name()) &&
+           VerifyOffset64(verifier, 6 /* weights */) &&
+           verifier.Verify(weights()) &&
+           VerifyOffset64(verifier, 8 /* points */) &&
+           verifier.Verify(points()) &&
+           VerifyOffset64(verifier, 10 /* preview */) &&
+           verifier.Verify(preview()) &&
+           VerifyField<uint64_t>(verifier, 12 /* id */) &&
+           verifier.EndTable();
+  }
+  bool VerifyShallow(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, 4 /* name */) &&
+           verifier.Verify(name()) &&
+           VerifyOffset64(verifier, 6 /* weights */) &&
+           verifier.Verify(weights()) &&
+           VerifyOffset64(verifier, 8 /* points */) &&
+           verifier.Verify(points()) &&
+           VerifyOffset64(verifier, 10 /* preview */) &&
+           verifier.Verify(preview()) &&
+           VerifyField<uint64_t>(verifier, 12 /* id */) &&
+           verifier.EndTable();
+  }
+};
+
+struct TileBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_name(flatbuffers::Offset<flatbuffers::String > name) { fbb_.AddOffset(4, name); }
+  void add_weights(flatbuffers::Offset64<flatbuffers::Vector64<float > > weights) { fbb_.AddOffset64(6, weights); }
+  void add_points(flatbuffers::Offset64<flatbuffers::Vector64<Point > > points) { fbb_.AddOffset64(8, points); }
+  void add_preview(flatbuffers::Offset64<flatbuffers::Vector64<uint8_t > > preview) { fbb_.AddOffset64(10, preview); }
+  void add_id(uint64_t id) { fbb_.AddElement<uint64_t >(12, id, 0); }
+  TileBuilder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
+  TileBuilder &operator=(const TileBuilder &);
+  flatbuffers::Offset<Tile> Finish() {
+    flatbuffers::Offset<Tile> o = flatbuffers::Offset<Tile>(fbb_.EndTable(start_, 5));
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<Tile> CreateTile(flatbuffers::FlatBufferBuilder &_fbb,
+   flatbuffers::Offset<flatbuffers::String > name = 0,
+   flatbuffers::Offset64<flatbuffers::Vector64<float > > weights = 0,
+   flatbuffers::Offset64<flatbuffers::Vector64<Point > > points = 0,
+   flatbuffers::Offset64<flatbuffers::Vector64<uint8_t > > preview = 0,
+   uint64_t id = 0) {
+  TileBuilder builder_(_fbb);
+  builder_.add_id(id);
+  builder_.add_preview(preview);
+  builder_.add_points(points);
+  builder_.add_weights(weights);
+  builder_.add_name(name);
+  return builder_.Finish();
+}
+
+inline const MyGame::Large::Tile *GetTile(const void *buf) { return flatbuffers::GetRoot<MyGame::Large::Tile>(buf); }
+
+inline Tile *GetMutableTile(void *buf) { return flatbuffers::GetMutableRoot<Tile>(buf); }
+
+inline bool VerifyTileBuffer(flatbuffers::Verifier &verifier) { return verifier.VerifyBuffer<MyGame::Large::Tile>(); }
+
+inline const MyGame::Large::Tile *GetTileLazily(flatbuffers::Verifier &verifier) { return verifier.VerifyRootLazily<MyGame::Large::Tile>(); }
+
+inline const char *TileIdentifier() { return "TILE"; }
+
+inline bool TileBufferHasIdentifier(const void *buf) { return flatbuffers::BufferHasIdentifier(buf, TileIdentifier()); }
+
+inline void FinishTileBuffer(flatbuffers::FlatBufferBuilder &fbb, flatbuffers::Offset<MyGame::Large::Tile> root) { fbb.Finish(root, TileIdentifier()); }
+
+}  // namespace Large
+}  // namespace MyGame
+
+#endif  // FLATBUFFERS_GENERATED_LARGETEST_MYGAME_LARGE_H_
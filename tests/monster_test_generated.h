@@ -48,6 +48,8 @@ inline const char *EnumNameAny(Any e) { return EnumNamesAny()[e]; }
 
 inline bool VerifyAny(flatbuffers::Verifier &verifier, const void *union_obj, Any type);
 
+inline bool VerifyAnyLazily(flatbuffers::Verifier &verifier, const void *union_obj, Any type);
+
 MANUALLY_ALIGNED_STRUCT(2) Test FLATBUFFERS_FINAL_CLASS {
  private:
   int16_t a_;
@@ -104,6 +106,11 @@ struct TestSimpleTableWithEnum FLATBUFFERS_FINAL_CLASS : private flatbuffers::Ta
            VerifyField<int8_t>(verifier, 4 /* color */) &&
            verifier.EndTable();
   }
+  bool VerifyShallow(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<int8_t>(verifier, 4 /* color */) &&
+           verifier.EndTable();
+  }
 };
 
 struct TestSimpleTableWithEnumBuilder {
@@ -120,6 +127,12 @@ struct TestSimpleTableWithEnumBuilder {
 
 inline flatbuffers::Offset<TestSimpleTableWithEnum> CreateTestSimpleTableWithEnum(flatbuffers::FlatBufferBuilder &_fbb,
    Color color = Color_Green) {
+  if (static_cast<int8_t>(color) != 2) {
+    static const flatbuffers::voffset_t vtable_[] = { 6, 8, 7 };
+    flatbuffers::uoffset_t start_ = _fbb.StartFixedTable(4);
+    _fbb.PushElement<int8_t>(static_cast<int8_t>(color));
+    return flatbuffers::Offset<TestSimpleTableWithEnum>(_fbb.EndFixedTable(start_, vtable_));
+  }
   TestSimpleTableWithEnumBuilder builder_(_fbb);
   builder_.add_color(color);
   return builder_.Finish();
@@ -140,6 +153,14 @@ struct Stat FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
            VerifyField<uint16_t>(verifier, 8 /* count */) &&
            verifier.EndTable();
   }
+  bool VerifyShallow(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, 4 /* id */) &&
+           verifier.Verify(id()) &&
+           VerifyField<int64_t>(verifier, 6 /* val */) &&
+           VerifyField<uint16_t>(verifier, 8 /* count */) &&
+           verifier.EndTable();
+  }
 };
 
 struct StatBuilder {
@@ -160,6 +181,14 @@ inline flatbuffers::Offset<Stat> CreateStat(flatbuffers::FlatBufferBuilder &_fbb
    flatbuffers::Offset<flatbuffers::String > id = 0,
    int64_t val = 0,
    uint16_t count = 0) {
+  if (val != 0 && id.o && count != 0) {
+    static const flatbuffers::voffset_t vtable_[] = { 10, 20, 8, 12, 6 };
+    flatbuffers::uoffset_t start_ = _fbb.StartFixedTable(8);
+    _fbb.PushElement<int64_t>(val);
+    _fbb.PushElement(id);
+    _fbb.PushElement<uint16_t>(count);
+    return flatbuffers::Offset<Stat>(_fbb.EndFixedTable(start_, vtable_));
+  }
   StatBuilder builder_(_fbb);
   builder_.add_val(val);
   builder_.add_id(id);
@@ -178,16 +207,22 @@ struct Monster FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
   flatbuffers::String *mutable_name() { return GetPointer<flatbuffers::String *>(10); }
   bool KeyCompareLessThan(const Monster *o) const { return *name() < *o->name(); }
   int KeyCompareWithValue(const char *val) const { return strcmp(name()->c_str(), val); }
+  uint64_t KeyIndexValue() const { return flatbuffers::KeyIndexValue(name()); }
+  static uint64_t KeyIndexValueAt(const flatbuffers::FlatBufferBuilder &fbb, flatbuffers::uoffset_t o) { return flatbuffers::KeyIndexValue(fbb.GetStringAt(o, 10)); }
+  static bool KeyIndexIsExact() { return false; }
   const flatbuffers::Vector<uint8_t > *inventory() const { return GetPointer<const flatbuffers::Vector<uint8_t > *>(14); }
   flatbuffers::Vector<uint8_t > *mutable_inventory() { return GetPointer<flatbuffers::Vector<uint8_t > *>(14); }
+  flatbuffers::VectorView<uint8_t> inventory_view() const { return flatbuffers::VectorView<uint8_t>(inventory()); }
   Color color() const { return static_cast<Color>(GetField<int8_t>(16, 8)); }
   bool mutate_color(Color color) { return SetField(16, static_cast<int8_t>(color)); }
   Any test_type() const { return static_cast<Any>(GetField<uint8_t>(18, 0)); }
   bool mutate_test_type(Any test_type) { return SetField(18, static_cast<uint8_t>(test_type)); }
   const void *test() const { return GetPointer<const void *>(20); }
   void *mutable_test() { return GetPointer<void *>(20); }
+  const void *test(flatbuffers::Verifier &verifier) const { return VerifyAnyLazily(verifier, test(), test_type()) ? test() : NULL; }
   const flatbuffers::Vector<const Test * > *test4() const { return GetPointer<const flatbuffers::Vector<const Test * > *>(22); }
   flatbuffers::Vector<const Test * > *mutable_test4() { return GetPointer<flatbuffers::Vector<const Test * > *>(22); }
+  flatbuffers::VectorView<Test> test4_view() const { return flatbuffers::VectorView<Test>(test4()); }
   const flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String > > *testarrayofstring() const { return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String > > *>(24); }
   flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String > > *mutable_testarrayofstring() { return GetPointer<flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String > > *>(24); }
   /// an example documentation comment: this will end up in the generated code
@@ -196,31 +231,47 @@ struct Monster FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
   flatbuffers::Vector<flatbuffers::Offset<Monster > > *mutable_testarrayoftables() { return GetPointer<flatbuffers::Vector<flatbuffers::Offset<Monster > > *>(26); }
   const Monster *enemy() const { return GetPointer<const Monster *>(28); }
   Monster *mutable_enemy() { return GetPointer<Monster *>(28); }
+  const Monster *enemy(flatbuffers::Verifier &verifier) const { return verifier.VerifyTableLazily(enemy()); }
   const flatbuffers::Vector<uint8_t > *testnestedflatbuffer() const { return GetPointer<const flatbuffers::Vector<uint8_t > *>(30); }
   flatbuffers::Vector<uint8_t > *mutable_testnestedflatbuffer() { return GetPointer<flatbuffers::Vector<uint8_t > *>(30); }
+  flatbuffers::VectorView<uint8_t> testnestedflatbuffer_view() const { return flatbuffers::VectorView<uint8_t>(testnestedflatbuffer()); }
   const MyGame::Example::Monster *testnestedflatbuffer_nested_root() const { return flatbuffers::GetRoot<MyGame::Example::Monster>(testnestedflatbuffer()->Data()); }
   const Stat *testempty() const { return GetPointer<const Stat *>(32); }
   Stat *mutable_testempty() { return GetPointer<Stat *>(32); }
+  const Stat *testempty(flatbuffers::Verifier &verifier) const { return verifier.VerifyTableLazily(testempty()); }
   uint8_t testbool() const { return GetField<uint8_t>(34, 0); }
   bool mutate_testbool(uint8_t testbool) { return SetField(34, testbool); }
   int32_t testhashs32_fnv1() const { return GetField<int32_t>(36, 0); }
   bool mutate_testhashs32_fnv1(int32_t testhashs32_fnv1) { return SetField(36, testhashs32_fnv1); }
+  static FLATBUFFERS_CONSTEXPR int32_t testhashs32_fnv1_hash(const char *val) { return static_cast<int32_t>(flatbuffers::ConstHashFnv1<uint32_t>(val)); }
   uint32_t testhashu32_fnv1() const { return GetField<uint32_t>(38, 0); }
   bool mutate_testhashu32_fnv1(uint32_t testhashu32_fnv1) { return SetField(38, testhashu32_fnv1); }
+  static FLATBUFFERS_CONSTEXPR uint32_t testhashu32_fnv1_hash(const char *val) { return static_cast<uint32_t>(flatbuffers::ConstHashFnv1<uint32_t>(val)); }
   int64_t testhashs64_fnv1() const { return GetField<int64_t>(40, 0); }
   bool mutate_testhashs64_fnv1(int64_t testhashs64_fnv1) { return SetField(40, testhashs64_fnv1); }
+  static FLATBUFFERS_CONSTEXPR int64_t testhashs64_fnv1_hash(const char *val) { return static_cast<int64_t>(flatbuffers::ConstHashFnv1<uint64_t>(val)); }
   uint64_t testhashu64_fnv1() const { return GetField<uint64_t>(42, 0); }
   bool mutate_testhashu64_fnv1(uint64_t testhashu64_fnv1) { return SetField(42, testhashu64_fnv1); }
+  static FLATBUFFERS_CONSTEXPR uint64_t testhashu64_fnv1_hash(const char *val) { return static_cast<uint64_t>(flatbuffers::ConstHashFnv1<uint64_t>(val)); }
   int32_t testhashs32_fnv1a() const { return GetField<int32_t>(44, 0); }
   bool mutate_testhashs32_fnv1a(int32_t testhashs32_fnv1a) { return SetField(44, testhashs32_fnv1a); }
+  static FLATBUFFERS_CONSTEXPR int32_t testhashs32_fnv1a_hash(const char *val) { return static_cast<int32_t>(flatbuffers::ConstHashFnv1a<uint32_t>(val)); }
   uint32_t testhashu32_fnv1a() const { return GetField<uint32_t>(46, 0); }
   bool mutate_testhashu32_fnv1a(uint32_t testhashu32_fnv1a) { return SetField(46, testhashu32_fnv1a); }
+  static FLATBUFFERS_CONSTEXPR uint32_t testhashu32_fnv1a_hash(const char *val) { return static_cast<uint32_t>(flatbuffers::ConstHashFnv1a<uint32_t>(val)); }
   int64_t testhashs64_fnv1a() const { return GetField<int64_t>(48, 0); }
   bool mutate_testhashs64_fnv1a(int64_t testhashs64_fnv1a) { return SetField(48, testhashs64_fnv1a); }
+  static FLATBUFFERS_CONSTEXPR int64_t testhashs64_fnv1a_hash(const char *val) { return static_cast<int64_t>(flatbuffers::ConstHashFnv1a<uint64_t>(val)); }
   uint64_t testhashu64_fnv1a() const { return GetField<uint64_t>(50, 0); }
   bool mutate_testhashu64_fnv1a(uint64_t testhashu64_fnv1a) { return SetField(50, testhashu64_fnv1a); }
+  static FLATBUFFERS_CONSTEXPR uint64_t testhashu64_fnv1a_hash(const char *val) { return static_cast<uint64_t>(flatbuffers::ConstHashFnv1a<uint64_t>(val)); }
   const flatbuffers::Vector<uint8_t > *testarrayofbools() const { return GetPointer<const flatbuffers::Vector<uint8_t > *>(52); }
   flatbuffers::Vector<uint8_t > *mutable_testarrayofbools() { return GetPointer<flatbuffers::Vector<uint8_t > *>(52); }
+  flatbuffers::VectorView<uint8_t> testarrayofbools_view() const { return flatbuffers::VectorView<uint8_t>(testarrayofbools()); }
+  const flatbuffers::Vector<uint64_t > *testarrayoftables_keys() const { return GetPointer<const flatbuffers::Vector<uint64_t > *>(54); }
+  flatbuffers::Vector<uint64_t > *mutable_testarrayoftables_keys() { return GetPointer<flatbuffers::Vector<uint64_t > *>(54); }
+  flatbuffers::VectorView<uint64_t> testarrayoftables_keys_view() const { return flatbuffers::VectorView<uint64_t>(testarrayoftables_keys()); }
+  const Monster *testarrayoftables_by_key(const char *key) const { return flatbuffers::LookupByKeyIndex(testarrayoftables(), testarrayoftables_keys(), key); }
   bool Verify(flatbuffers::Verifier &verifier) const {
     return VerifyTableStart(verifier) &&
            VerifyField<Vec3>(verifier, 4 /* pos */) &&
@@ -259,6 +310,46 @@ struct Monster FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
            VerifyField<uint64_t>(verifier, 50 /* testhashu64_fnv1a */) &&
            VerifyField<flatbuffers::uoffset_t>(verifier, 52 /* testarrayofbools */) &&
            verifier.Verify(testarrayofbools()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, 54 /* testarrayoftables_keys */) &&
+           verifier.Verify(testarrayoftables_keys()) &&
+           verifier.EndTable();
+  }
+  bool VerifyShallow(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<Vec3>(verifier, 4 /* pos */) &&
+           VerifyField<int16_t>(verifier, 6 /* mana */) &&
+           VerifyField<int16_t>(verifier, 8 /* hp */) &&
+           VerifyFieldRequired<flatbuffers::uoffset_t>(verifier, 10 /* name */) &&
+           verifier.Verify(name()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, 14 /* inventory */) &&
+           verifier.Verify(inventory()) &&
+           VerifyField<int8_t>(verifier, 16 /* color */) &&
+           VerifyField<uint8_t>(verifier, 18 /* test_type */) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, 20 /* test */) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, 22 /* test4 */) &&
+           verifier.Verify(test4()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, 24 /* testarrayofstring */) &&
+           verifier.Verify(testarrayofstring()) &&
+           verifier.VerifyVectorOfStrings(testarrayofstring()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, 26 /* testarrayoftables */) &&
+           verifier.Verify(testarrayoftables()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, 28 /* enemy */) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, 30 /* testnestedflatbuffer */) &&
+           verifier.Verify(testnestedflatbuffer()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, 32 /* testempty */) &&
+           VerifyField<uint8_t>(verifier, 34 /* testbool */) &&
+           VerifyField<int32_t>(verifier, 36 /* testhashs32_fnv1 */) &&
+           VerifyField<uint32_t>(verifier, 38 /* testhashu32_fnv1 */) &&
+           VerifyField<int64_t>(verifier, 40 /* testhashs64_fnv1 */) &&
+           VerifyField<uint64_t>(verifier, 42 /* testhashu64_fnv1 */) &&
+           VerifyField<int32_t>(verifier, 44 /* testhashs32_fnv1a */) &&
+           VerifyField<uint32_t>(verifier, 46 /* testhashu32_fnv1a */) &&
+           VerifyField<int64_t>(verifier, 48 /* testhashs64_fnv1a */) &&
+           VerifyField<uint64_t>(verifier, 50 /* testhashu64_fnv1a */) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, 52 /* testarrayofbools */) &&
+           verifier.Verify(testarrayofbools()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, 54 /* testarrayoftables_keys */) &&
+           verifier.Verify(testarrayoftables_keys()) &&
            verifier.EndTable();
   }
 };
@@ -290,10 +381,11 @@ struct MonsterBuilder {
   void add_testhashs64_fnv1a(int64_t testhashs64_fnv1a) { fbb_.AddElement<int64_t >(48, testhashs64_fnv1a, 0); }
   void add_testhashu64_fnv1a(uint64_t testhashu64_fnv1a) { fbb_.AddElement<uint64_t >(50, testhashu64_fnv1a, 0); }
   void add_testarrayofbools(flatbuffers::Offset<flatbuffers::Vector<uint8_t > > testarrayofbools) { fbb_.AddOffset(52, testarrayofbools); }
+  void add_testarrayoftables_keys(flatbuffers::Offset<flatbuffers::Vector<uint64_t > > testarrayoftables_keys) { fbb_.AddOffset(54, testarrayoftables_keys); }
   MonsterBuilder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
   MonsterBuilder &operator=(const MonsterBuilder &);
   flatbuffers::Offset<Monster> Finish() {
-    flatbuffers::Offset<Monster> o = flatbuffers::Offset<Monster>(fbb_.EndTable(start_, 25));
+    flatbuffers::Offset<Monster> o = flatbuffers::Offset<Monster>(fbb_.EndTable(start_, 26));
     fbb_.Required(o, 10);  // name
     return o;
   }
@@ -323,12 +415,14 @@ inline flatbuffers::Offset<Monster> CreateMonster(flatbuffers::FlatBufferBuilder
    uint32_t testhashu32_fnv1a = 0,
    int64_t testhashs64_fnv1a = 0,
    uint64_t testhashu64_fnv1a = 0,
-   flatbuffers::Offset<flatbuffers::Vector<uint8_t > > testarrayofbools = 0) {
+   flatbuffers::Offset<flatbuffers::Vector<uint8_t > > testarrayofbools = 0,
+   flatbuffers::Offset<flatbuffers::Vector<uint64_t > > testarrayoftables_keys = 0) {
   MonsterBuilder builder_(_fbb);
   builder_.add_testhashu64_fnv1a(testhashu64_fnv1a);
   builder_.add_testhashs64_fnv1a(testhashs64_fnv1a);
   builder_.add_testhashu64_fnv1(testhashu64_fnv1);
   builder_.add_testhashs64_fnv1(testhashs64_fnv1);
+  builder_.add_testarrayoftables_keys(testarrayoftables_keys);
   builder_.add_testarrayofbools(testarrayofbools);
   builder_.add_testhashu32_fnv1a(testhashu32_fnv1a);
   builder_.add_testhashs32_fnv1a(testhashs32_fnv1a);
@@ -361,12 +455,23 @@ inline bool VerifyAny(flatbuffers::Verifier &verifier, const void *union_obj, An
   }
 }
 
+inline bool VerifyAnyLazily(flatbuffers::Verifier &verifier, const void *union_obj, Any type) {
+  switch (type) {
+    case Any_NONE: return true;
+    case Any_Monster: return verifier.VerifyTableLazily(reinterpret_cast<const Monster *>(union_obj)) != NULL;
+    case Any_TestSimpleTableWithEnum: return verifier.VerifyTableLazily(reinterpret_cast<const TestSimpleTableWithEnum *>(union_obj)) != NULL;
+    default: return false;
+  }
+}
+
 inline const MyGame::Example::Monster *GetMonster(const void *buf) { return flatbuffers::GetRoot<MyGame::Example::Monster>(buf); }
 
 inline Monster *GetMutableMonster(void *buf) { return flatbuffers::GetMutableRoot<Monster>(buf); }
 
 inline bool VerifyMonsterBuffer(flatbuffers::Verifier &verifier) { return verifier.VerifyBuffer<MyGame::Example::Monster>(); }
 
+inline const MyGame::Example::Monster *GetMonsterLazily(flatbuffers::Verifier &verifier) { return verifier.VerifyRootLazily<MyGame::Example::Monster>(); }
+
 inline const char *MonsterIdentifier() { return "MONS"; }
 
 inline bool MonsterBufferHasIdentifier(const void *buf) { return flatbuffers::BufferHasIdentifier(buf, MonsterIdentifier()); }
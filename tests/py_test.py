@@ -129,6 +129,9 @@ def CheckReadBuffer(buf, offset):
         invsum += int(v)
     asserter(invsum == 10)
 
+    # or get it all at once:
+    asserter(sum(monster.InventoryAsArray()) == 10)
+
     asserter(monster.Test4Length() == 2)
 
     # create a 'Test' object and populate it:
@@ -800,6 +803,25 @@ def make_monster_from_generated_code():
     return b.Bytes, b.Head()
 
 
+class TestGetArray(unittest.TestCase):
+    def test_all_fallbacks(self):
+        from flatbuffers import encode
+        buf = bytearray(b'\x00') + bytearray(
+            N.Float32Flags.packer_type.pack(1.5) +
+            N.Float32Flags.packer_type.pack(-2.0))
+        saved = encode.numpy
+        try:
+            # With NumPy if installed, then the memoryview or tuple.
+            for numpy in (saved, None):
+                encode.numpy = numpy
+                arr = encode.GetArray(N.Float32Flags, buf, 1, 2)
+                self.assertEqual([1.5, -2.0], [float(x) for x in arr])
+                self.assertEqual(0, len(encode.GetArray(N.Int16Flags, buf,
+                                                        1, 0)))
+        finally:
+            encode.numpy = saved
+
+
 class TestAllCodePathsOfExampleSchema(unittest.TestCase):
     def setUp(self, *args, **kwargs):
         super(TestAllCodePathsOfExampleSchema, self).setUp(*args, **kwargs)
@@ -838,6 +860,26 @@ class TestAllCodePathsOfExampleSchema(unittest.TestCase):
     def test_default_monster_inventory_length(self):
         self.assertEqual(0, self.mon.InventoryLength())
 
+    def test_default_monster_inventory_as_array(self):
+        self.assertEqual(0, self.mon.InventoryAsArray())
+
+    def test_nondefault_monster_keys_as_array(self):
+        b = flatbuffers.Builder(0)
+        keys = [1, 2**40, 2**64 - 1]
+        MyGame.Example.Monster.MonsterStartTestarrayoftablesKeysVector(
+            b, len(keys))
+        for key in reversed(keys):
+            b.PrependUint64(key)
+        vec = b.EndVector(len(keys))
+        MyGame.Example.Monster.MonsterStart(b)
+        MyGame.Example.Monster.MonsterAddTestarrayoftablesKeys(b, vec)
+        b.Finish(MyGame.Example.Monster.MonsterEnd(b))
+
+        mon2 = MyGame.Example.Monster.Monster.GetRootAsMonster(b.Bytes,
+                                                               b.Head())
+        self.assertEqual(keys,
+                         [int(k) for k in mon2.TestarrayoftablesKeysAsArray()])
+
     def test_default_monster_color(self):
         self.assertEqual(MyGame.Example.Color.Color.Blue, self.mon.Color())
 
@@ -18,9 +18,12 @@
 
 #include "flatbuffers/flatbuffers.h"
 #include "flatbuffers/idl.h"
+#include "flatbuffers/large_buffer.h"
+#include "flatbuffers/record_log.h"
 #include "flatbuffers/util.h"
 
 #include "monster_test_generated.h"
+#include "large_test_generated.h"
 
 //#include <random>
 
@@ -259,6 +262,21 @@ void MutateFlatBuffersTest(uint8_t *flatbuf, std::size_t length) {
 
 // example of parsing text straight into a buffer, and generating
 // text back from it:
+// Collects text written through a CallbackTextSink.
+struct StreamedText {
+  StreamedText() : num_writes(0) {}
+
+  static bool Write(void *context, const char *data, size_t len) {
+    StreamedText &streamed = *reinterpret_cast<StreamedText *>(context);
+    streamed.text.append(data, len);
+    streamed.num_writes++;
+    return true;
+  }
+
+  std::string text;
+  size_t num_writes;
+};
+
 void ParseAndGenerateTextTest() {
   // load FlatBuffer schema (.fbs) and JSON from disk
   std::string schemafile;
@@ -291,6 +309,17 @@ void ParseAndGenerateTextTest() {
     printf("%s----------------\n%s", jsongen.c_str(), jsonfile.c_str());
     TEST_NOTNULL((void*)NULL);
   }
+
+  // Streaming the text through a sink with a small buffer gives the same
+  // result, in pieces no bigger than the buffer (except for long strings).
+  StreamedText streamed;
+  {
+    flatbuffers::CallbackTextSink sink(StreamedText::Write, &streamed, 16);
+    TEST_EQ(GenerateText(parser, parser.builder_.GetBufferPointer(), opts,
+                         &sink), true);
+  }
+  TEST_EQ_STR(streamed.text.c_str(), jsonfile.c_str());
+  TEST_EQ(streamed.num_writes > jsonfile.length() / 16, true);
 }
 
 void ReflectionTest(uint8_t *flatbuf, size_t length) {
@@ -417,6 +446,284 @@ void ReflectionTest(uint8_t *flatbuf, size_t length) {
   fbb.Finish(root_offset, MonsterIdentifier());
   // Test that it was copied correctly:
   AccessFlatBufferTest(fbb.GetBufferPointer(), fbb.GetSize());
+
+  // With string pooling, strings that occur more than once in the copy
+  // (the name of the monster stored both in the union and the vector of
+  // tables) are stored only once.
+  flatbuffers::FlatBufferBuilder pooledfbb;
+  Offset<const Table*> pooled_root_offset = flatbuffers::CopyTable(
+    pooledfbb, schema, *root_table, *flatbuffers::GetAnyRoot(flatbuf), true);
+  pooledfbb.Finish(pooled_root_offset, MonsterIdentifier());
+  AccessFlatBufferTest(pooledfbb.GetBufferPointer(), pooledfbb.GetSize());
+  const Monster *pooled = GetMonster(pooledfbb.GetBufferPointer());
+  const Monster *pooled_test = reinterpret_cast<const Monster *>(pooled->test());
+  const Monster *pooled_elem =
+    pooled->testarrayoftables()->LookupByKey(pooled_test->name()->c_str());
+  TEST_NOTNULL(pooled_elem);
+  TEST_EQ(pooled_elem->name(), pooled_test->name());
+}
+
+void CopyPlanTest(uint8_t *flatbuf) {
+  std::string bfbsfile;
+  TEST_EQ(flatbuffers::LoadFile(
+    "tests/monster_test.bfbs", true, &bfbsfile), true);
+  const reflection::Schema &schema = *reflection::GetSchema(bfbsfile.c_str());
+  const Table &root = *flatbuffers::GetAnyRoot(flatbuf);
+
+  // A plan copying everything gives the same result as CopyTable().
+  flatbuffers::CopyPlan all(schema);
+  TEST_EQ(all.ok(), true);
+  flatbuffers::FlatBufferBuilder fbb1, fbb2;
+  fbb1.Finish(flatbuffers::CopyTable(fbb1, schema, *schema.root_table(),
+                                     root), MonsterIdentifier());
+  fbb2.Finish(all.Copy(fbb2, root), MonsterIdentifier());
+  TEST_EQ(fbb1.GetSize(), fbb2.GetSize());
+  TEST_EQ(memcmp(fbb1.GetBufferPointer(), fbb2.GetBufferPointer(),
+                 fbb1.GetSize()), 0);
+
+  // With sharing, the table in the union is the same as in the vector.
+  flatbuffers::FlatBufferBuilder sharedfbb;
+  sharedfbb.Finish(all.Copy(sharedfbb, root, true), MonsterIdentifier());
+  AccessFlatBufferTest(sharedfbb.GetBufferPointer(), sharedfbb.GetSize());
+  const Monster *shared = GetMonster(sharedfbb.GetBufferPointer());
+  const Monster *shared_test = reinterpret_cast<const Monster *>(
+    shared->test());
+  TEST_EQ(shared->testarrayoftables()->LookupByKey(
+            shared_test->name()->c_str()), shared_test);
+
+  // Only copy some fields.
+  std::vector<std::string> paths;
+  paths.push_back("hp");
+  paths.push_back("name");
+  paths.push_back("test4");
+  paths.push_back("testarrayoftables.name");
+  paths.push_back("test");
+  flatbuffers::CopyPlan some(schema, paths);
+  TEST_EQ(some.ok(), true);
+  flatbuffers::FlatBufferBuilder fbb;
+  fbb.Finish(some.Copy(fbb, root), MonsterIdentifier());
+  flatbuffers::Verifier verifier(fbb.GetBufferPointer(), fbb.GetSize());
+  TEST_EQ(VerifyMonsterBuffer(verifier), true);
+  TEST_EQ(fbb.GetSize() < fbb1.GetSize(), true);
+  const Monster *monster = GetMonster(fbb.GetBufferPointer());
+  TEST_EQ(monster->hp(), 80);
+  TEST_EQ(monster->mana(), 150);  // default
+  TEST_EQ_STR(monster->name()->c_str(), "MyMonster");
+  TEST_EQ(monster->pos() == NULL, true);
+  TEST_EQ(monster->inventory() == NULL, true);
+  TEST_EQ(monster->testarrayofstring() == NULL, true);
+  TEST_EQ(monster->test4()->size(), 2U);
+  TEST_EQ(monster->test4()->Get(1)->a(), 30);
+  TEST_EQ(monster->testarrayoftables()->size(), 3U);
+  TEST_EQ_STR(monster->testarrayoftables()->Get(2)->name()->c_str(),
+              "Wilma");
+  TEST_EQ(monster->test_type(), Any_Monster);
+  TEST_EQ_STR(reinterpret_cast<const Monster *>(monster->test())->name()->
+                c_str(), "Fred");
+
+  paths.push_back("testarrayoftables.nonexistent");
+  paths.push_back("name.length");
+  flatbuffers::CopyPlan bad(schema, paths);
+  TEST_EQ(bad.ok(), false);
+}
+
+void CompactBufferTest(uint8_t *flatbuf, size_t length) {
+  std::string bfbsfile;
+  TEST_EQ(flatbuffers::LoadFile(
+    "tests/monster_test.bfbs", true, &bfbsfile), true);
+  const reflection::Schema &schema = *reflection::GetSchema(bfbsfile.c_str());
+
+  // Compacting keeps all the contents.
+  flatbuffers::FlatBufferBuilder fbb;
+  TEST_EQ(flatbuffers::CompactBuffer(schema, flatbuf, length, &fbb), true);
+  AccessFlatBufferTest(fbb.GetBufferPointer(), fbb.GetSize());
+  TEST_EQ(fbb.GetSize() <= length, true);
+
+  // A buffer full of identical subtrees, each stored separately.
+  flatbuffers::FlatBufferBuilder redundant;
+  std::vector<flatbuffers::Offset<Monster> > monsters;
+  const uint8_t inventory[] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+  for (int i = 0; i < 10; i++) {
+    flatbuffers::Offset<flatbuffers::String> strings[] = {
+      redundant.CreateString("a"), redundant.CreateString("b")
+    };
+    monsters.push_back(CreateMonster(
+      redundant, 0, 150, 80, redundant.CreateString("Fred"),
+      redundant.CreateVector(inventory, sizeof(inventory)), Color_Blue,
+      Any_NONE, 0, 0, redundant.CreateVector(strings, 2)));
+  }
+  FinishMonsterBuffer(redundant, CreateMonster(
+    redundant, 0, 150, 80, redundant.CreateString("MyMonster"), 0,
+    Color_Blue, Any_NONE, 0, 0, 0, redundant.CreateVector(monsters)));
+  fbb.Clear();
+  TEST_EQ(flatbuffers::CompactBuffer(schema, redundant.GetBufferPointer(),
+                                     redundant.GetSize(), &fbb), true);
+  flatbuffers::Verifier verifier(fbb.GetBufferPointer(), fbb.GetSize());
+  TEST_EQ(VerifyMonsterBuffer(verifier), true);
+  TEST_EQ(fbb.GetSize() * 3 < redundant.GetSize(), true);
+  const Monster *monster = GetMonster(fbb.GetBufferPointer());
+  TEST_EQ_STR(monster->name()->c_str(), "MyMonster");
+  const flatbuffers::Vector<flatbuffers::Offset<Monster> > *tables =
+    monster->testarrayoftables();
+  TEST_EQ(tables->size(), 10U);
+  for (uoffset_t i = 0; i < tables->size(); i++) {
+    TEST_EQ(tables->Get(i), tables->Get(0));
+  }
+  TEST_EQ_STR(tables->Get(9)->name()->c_str(), "Fred");
+  TEST_EQ(tables->Get(9)->inventory()->Get(7), 8);
+  TEST_EQ_STR(tables->Get(9)->testarrayofstring()->Get(1)->c_str(), "b");
+
+  // A BufferCompactor does the same for many buffers.
+  flatbuffers::BufferCompactor compactor(schema);
+  flatbuffers::FlatBufferBuilder compacted;
+  TEST_EQ(compactor.Compact(redundant.GetBufferPointer(), redundant.GetSize(),
+                            &compacted), true);
+  TEST_EQ(compacted.GetSize(), fbb.GetSize());
+  TEST_EQ(memcmp(compacted.GetBufferPointer(), fbb.GetBufferPointer(),
+                 fbb.GetSize()), 0);
+  compacted.Clear();
+  TEST_EQ(compactor.Compact(flatbuf, length, &compacted), true);
+  AccessFlatBufferTest(compacted.GetBufferPointer(), compacted.GetSize());
+
+  // Buffers that don't verify are rejected.
+  fbb.Clear();
+  TEST_EQ(flatbuffers::CompactBuffer(schema, redundant.GetBufferPointer(),
+                                     redundant.GetSize() / 2, &fbb), false);
+  compacted.Clear();
+  TEST_EQ(compactor.Compact(redundant.GetBufferPointer(),
+                            redundant.GetSize() / 2, &compacted), false);
+}
+
+// Applies the same changes to buf, either all at once or one by one.
+void ApplyResizes(const reflection::Schema &schema, std::vector<uint8_t> *buf,
+                  bool batched) {
+  flatbuffers::ResizeBatch batch(schema, buf);
+  for (int i = 0; i < 5; i++) {
+    const Monster *monster = GetMonster(buf->data());
+    switch (i) {
+      case 0:
+        batch.SetString(monster->name(), "A monster with a longer name");
+        break;
+      case 1:
+        batch.SetString(monster->testarrayofstring()->Get(1), "frederick");
+        break;
+      case 2:
+        // Shared by the union and the vector of tables.
+        batch.SetString(monster->testarrayoftables()->Get(1)->name(),
+                        "Fred Flintstone");
+        break;
+      case 3:
+        batch.ResizeVector<uint8_t>(monster->inventory(), 30, 7);
+        break;
+      case 4:
+        batch.ResizeAnyVector(
+          reinterpret_cast<const VectorOfAny *>(monster->test4()),
+          monster->test4()->size(), 0, sizeof(Test));
+        break;
+    }
+    if (!batched) batch.Apply();
+  }
+  batch.Apply();
+}
+
+void ResizeBatchTest(uint8_t *flatbuf, size_t length) {
+  std::string bfbsfile;
+  TEST_EQ(flatbuffers::LoadFile(
+    "tests/monster_test.bfbs", true, &bfbsfile), true);
+  const reflection::Schema &schema = *reflection::GetSchema(bfbsfile.c_str());
+
+  std::vector<uint8_t> batched(flatbuf, flatbuf + length);
+  std::vector<uint8_t> single(flatbuf, flatbuf + length);
+  ApplyResizes(schema, &batched, true);
+  ApplyResizes(schema, &single, false);
+  TEST_EQ(batched == single, true);
+
+  flatbuffers::Verifier verifier(batched.data(), batched.size());
+  TEST_EQ(VerifyMonsterBuffer(verifier), true);
+  const Monster *monster = GetMonster(batched.data());
+  TEST_EQ_STR(monster->name()->c_str(), "A monster with a longer name");
+  TEST_EQ(monster->name()->size(), 28U);
+  TEST_EQ(monster->hp(), 80);
+  TEST_EQ(monster->pos()->z(), 3);
+  TEST_EQ_STR(monster->testarrayofstring()->Get(0)->c_str(), "bob");
+  TEST_EQ_STR(monster->testarrayofstring()->Get(1)->c_str(), "frederick");
+  TEST_EQ(monster->inventory()->size(), 30U);
+  TEST_EQ(monster->inventory()->Get(9), 9);
+  TEST_EQ(monster->inventory()->Get(29), 7);
+  TEST_EQ(monster->test4()->size(), 0U);
+  const Vector<Offset<Monster> > *tables = monster->testarrayoftables();
+  TEST_EQ(tables->size(), 3U);
+  TEST_EQ_STR(tables->Get(0)->name()->c_str(), "Barney");
+  TEST_EQ_STR(tables->Get(1)->name()->c_str(), "Fred Flintstone");
+  TEST_EQ_STR(tables->Get(2)->name()->c_str(), "Wilma");
+  TEST_EQ(monster->test_type(), Any_Monster);
+  TEST_EQ_STR(reinterpret_cast<const Monster *>(monster->test())->name()->
+                c_str(), "Fred Flintstone");
+}
+
+void SchemaIndexTest(uint8_t *flatbuf) {
+  std::string bfbsfile;
+  TEST_EQ(flatbuffers::LoadFile(
+    "tests/monster_test.bfbs", true, &bfbsfile), true);
+  const reflection::Schema &schema = *reflection::GetSchema(bfbsfile.c_str());
+  flatbuffers::SchemaIndex index(schema);
+
+  // Every object and field can be found by name, and has the same
+  // properties as in the schema.
+  const Vector<Offset<reflection::Object> > &objects = *schema.objects();
+  for (uoffset_t i = 0; i < objects.size(); i++) {
+    const reflection::Object &objectdef = *objects.Get(i);
+    const flatbuffers::ObjectDescriptor *objectdesc =
+      index.LookupObject(objectdef.name()->c_str());
+    TEST_EQ(objectdesc, index.GetObjectDesc(static_cast<int>(i)));
+    TEST_EQ(objectdesc->object, &objectdef);
+    TEST_EQ(objectdesc->is_struct, objectdef.is_struct());
+    TEST_EQ(objectdesc->num_fields, objectdef.fields()->size());
+    for (uoffset_t j = 0; j < objectdef.fields()->size(); j++) {
+      const reflection::Field &fielddef = *objectdef.fields()->Get(j);
+      const flatbuffers::FieldDescriptor *fielddesc =
+        index.LookupField(*objectdesc, fielddef.name()->c_str());
+      TEST_EQ(fielddesc, objectdesc->fields + j);
+      TEST_EQ(fielddesc->field, &fielddef);
+      TEST_EQ(fielddesc->offset, fielddef.offset());
+      TEST_EQ(fielddesc->base_type, fielddef.type()->base_type());
+      TEST_EQ(fielddesc->default_integer, fielddef.default_integer());
+    }
+    TEST_EQ(index.LookupField(*objectdesc, "nonexistent") ==
+            static_cast<const flatbuffers::FieldDescriptor *>(NULL), true);
+  }
+  TEST_EQ(index.LookupObject("Nonexistent") ==
+          static_cast<const flatbuffers::ObjectDescriptor *>(NULL), true);
+
+  // Access the buffer through the descriptors.
+  const flatbuffers::ObjectDescriptor &monsterdesc = *index.root_table();
+  TEST_EQ(monsterdesc.object, schema.root_table());
+  Table &root = *flatbuffers::GetAnyRoot(flatbuf);
+  const flatbuffers::FieldDescriptor &hp = *index.LookupField(monsterdesc,
+                                                              "hp");
+  TEST_EQ(flatbuffers::GetFieldI<int16_t>(root, hp), 80);
+  TEST_EQ(flatbuffers::GetAnyFieldI(root, hp), 80);
+  TEST_EQ_STR(flatbuffers::GetAnyFieldS(root, hp, &schema).c_str(), "80");
+  TEST_EQ(flatbuffers::SetAnyFieldI(&root, hp, 300), true);
+  TEST_EQ(flatbuffers::GetFieldI<int16_t>(root, hp), 300);
+  flatbuffers::SetField<int16_t>(&root, hp, 80);
+  const flatbuffers::FieldDescriptor &mana = *index.LookupField(monsterdesc,
+                                                                "mana");
+  TEST_EQ(flatbuffers::GetAnyFieldI(root, mana), 150);  // Default.
+  TEST_EQ(flatbuffers::SetAnyFieldI(&root, mana, 10), false);
+  TEST_EQ_STR(flatbuffers::GetFieldS(root, *index.LookupField(monsterdesc,
+              "name"))->c_str(), "MyMonster");
+  TEST_EQ(flatbuffers::GetFieldV<uint8_t>(root, *index.LookupField(
+            monsterdesc, "inventory"))->size(), 10U);
+  const flatbuffers::FieldDescriptor &pos = *index.LookupField(monsterdesc,
+                                                               "pos");
+  const flatbuffers::ObjectDescriptor &vec3desc =
+    *index.GetObjectDesc(pos.type_index);
+  TEST_EQ(pos.inline_size, vec3desc.bytesize);
+  const Struct &vec3 = *flatbuffers::GetAnyFieldAddressOf<const Struct>(root,
+                                                                        pos);
+  TEST_EQ(flatbuffers::GetAnyFieldF(vec3, *index.LookupField(vec3desc, "y")),
+          2.0);
 }
 
 // Parse a .proto schema, output as .fbs
@@ -538,6 +845,681 @@ void FuzzTest1() {
 }
 
 
+// Tables with the same layout should share a single vtable, however many
+// distinct layouts the buffer contains.
+void VTableSharingTest() {
+  const int num_layouts = 100;
+  const int num_objects = 1000;
+
+  for (int limit = 0; limit <= num_layouts / 2; limit += num_layouts / 2) {
+    flatbuffers::FlatBufferBuilder builder;
+    builder.MaxSharedVTables(limit);
+    flatbuffers::uoffset_t objects[num_objects];
+    for (int i = 0; i < num_objects; i++) {
+      // Each layout sets a different pair of fields.
+      int layout = i % num_layouts;
+      uoffset_t start = builder.StartTable();
+      builder.AddElement<int32_t>(flatbuffers::FieldIndexToOffset(
+        static_cast<voffset_t>(layout % 10)), i + 1, 0);
+      builder.AddElement<int32_t>(flatbuffers::FieldIndexToOffset(
+        static_cast<voffset_t>(10 + layout / 10)), 1, 0);
+      objects[i] = builder.EndTable(start, 20);
+    }
+
+    uint8_t *eob = builder.GetBufferPointer() + builder.GetSize();
+    for (int i = 0; i < num_objects; i++) {
+      int layout = i % num_layouts;
+      Table *table = reinterpret_cast<Table *>(eob - objects[i]);
+      Table *first = reinterpret_cast<Table *>(eob - objects[layout]);
+      TEST_EQ(table->GetField<int32_t>(flatbuffers::FieldIndexToOffset(
+        static_cast<voffset_t>(layout % 10)), 0), i + 1);
+      // Layouts beyond the limit are not shared.
+      bool shared = !limit || layout < limit;
+      TEST_EQ(table->GetVTable() == first->GetVTable(), shared || i == layout);
+    }
+  }
+}
+
+void FixedCreateTest() {
+  for (int limit = 0; limit <= 1; limit++) {
+    flatbuffers::FlatBufferBuilder builder;
+    builder.MaxSharedVTables(limit);
+    const int num_stats = 10;
+    Offset<Stat> stats[num_stats];
+    Offset<String> id = builder.CreateString("id");
+    // With a limit, this takes the only vtable remembered.
+    if (limit) CreateTestSimpleTableWithEnum(builder, Color_Blue);
+    for (int i = 0; i < num_stats; i++) {
+      // Odd ones have a default count, so don't take the fixed path.
+      stats[i] = CreateStat(builder, id, i + 1,
+                            static_cast<uint16_t>(i % 2 ? 0 : i + 1));
+      // Interleave another fixed layout with padding.
+      builder.PushElement<uint8_t>(1);
+      CreateTestSimpleTableWithEnum(builder, Color_Red);
+    }
+    Offset<Stat> root = CreateStat(builder, id, 100, 100);
+    builder.Finish(root);
+
+    Verifier verifier(builder.GetBufferPointer(), builder.GetSize());
+    TEST_EQ(verifier.VerifyBuffer<Stat>(), true);
+    uint8_t *eob = builder.GetBufferPointer() + builder.GetSize();
+    Table *first = reinterpret_cast<Table *>(eob - stats[0].o);
+    for (int i = 0; i < num_stats; i++) {
+      const Stat *stat = reinterpret_cast<Stat *>(eob - stats[i].o);
+      TEST_EQ_STR(stat->id()->c_str(), "id");
+      TEST_EQ(stat->val(), i + 1);
+      TEST_EQ(stat->count(), i % 2 ? 0 : i + 1);
+      // All with every field set share a vtable, unless the other layout
+      // took the only one remembered.
+      Table *table = reinterpret_cast<Table *>(eob - stats[i].o);
+      TEST_EQ(table->GetVTable() == first->GetVTable(),
+              !(i % 2) && (!limit || !i));
+    }
+    const Stat *stat = flatbuffers::GetRoot<Stat>(eob - builder.GetSize());
+    TEST_EQ(stat->val(), 100);
+    TEST_EQ(stat->count(), 100);
+    Table *table = reinterpret_cast<Table *>(eob - root.o);
+    TEST_EQ(table->GetVTable() == first->GetVTable(), !limit);
+  }
+}
+
+void SharedStringTest() {
+  flatbuffers::FlatBufferBuilder builder;
+  Offset<String> foo = builder.CreateSharedString("foo");
+  Offset<String> bar = builder.CreateSharedString("bar");
+  uoffset_t size = builder.GetSize();
+  TEST_EQ(builder.CreateSharedString("foo").o, foo.o);
+  TEST_EQ(builder.CreateSharedString(std::string("bar")).o, bar.o);
+  TEST_EQ(builder.GetSize(), size);
+  // Strings may contain zeroes, and one being a prefix of another doesn't
+  // make them equal.
+  Offset<String> foo0 = builder.CreateSharedString("foo\0", 4);
+  Offset<String> fo = builder.CreateSharedString("fo");
+  TEST_EQ(foo0.o != foo.o && fo.o != foo.o && fo.o != foo0.o, true);
+  TEST_EQ(builder.CreateSharedString("foo\0", 4).o, foo0.o);
+  // The plain CreateString always writes a new copy.
+  TEST_EQ(builder.CreateString("foo").o != foo.o, true);
+
+  // After Clear(), previous strings are gone.
+  builder.Clear();
+  bar = builder.CreateSharedString("bar");
+  foo = builder.CreateSharedString("foo");
+  TEST_EQ(builder.CreateSharedString("foo").o, foo.o);
+  TEST_EQ(builder.CreateSharedString("bar").o, bar.o);
+
+  // The parser can share strings too.
+  const char *schema = "table T { A:string; B:[string]; } root_type T;";
+  const char *json = "{ A: \"abc\", B: [ \"abc\", \"def\", \"abc\" ] }";
+  flatbuffers::Parser parser;
+  TEST_EQ(parser.Parse(schema), true);
+  TEST_EQ(parser.Parse(json), true);
+  flatbuffers::Parser shared_parser(false, false, true);
+  TEST_EQ(shared_parser.Parse(schema), true);
+  TEST_EQ(shared_parser.Parse(json), true);
+  TEST_EQ(shared_parser.builder_.GetSize() < parser.builder_.GetSize(), true);
+  std::string jsongen, shared_jsongen;
+  flatbuffers::GeneratorOptions opts;
+  GenerateText(parser, parser.builder_.GetBufferPointer(), opts, &jsongen);
+  GenerateText(shared_parser, shared_parser.builder_.GetBufferPointer(), opts,
+               &shared_jsongen);
+  TEST_EQ_STR(jsongen.c_str(), shared_jsongen.c_str());
+}
+
+// Builds a small Monster, returns the end of the buffer.
+const uint8_t *BuildMonster(flatbuffers::FlatBufferBuilder &builder) {
+  Offset<String> name = builder.CreateString("MyMonster");
+  uint8_t inv[200] = { 0 };
+  Offset<Vector<uint8_t> > inventory = builder.CreateVector(inv, 200);
+  FinishMonsterBuffer(builder, CreateMonster(builder, NULL, 150, 80, name,
+                                             inventory));
+  Verifier verifier(builder.GetBufferPointer(), builder.GetSize());
+  TEST_EQ(VerifyMonsterBuffer(verifier), true);
+  return builder.GetBufferPointer() + builder.GetSize();
+}
+
+void AllocatorTest() {
+  // Buffers released to a pool allocator get reused by the next Clear().
+  flatbuffers::pool_allocator pool;
+  flatbuffers::FlatBufferBuilder builder(128, &pool);
+  const uint8_t *end = BuildMonster(builder);
+  for (int i = 0; i < 3; i++) {
+    flatbuffers::unique_ptr_t buf = builder.ReleaseBufferPointer();
+    TEST_EQ(GetMonster(buf.get())->hp(), 80);
+    buf.reset();
+    builder.Clear();
+    TEST_EQ(BuildMonster(builder), end);
+  }
+
+  // Same using a DetachedBuffer, which can change hands with swap().
+  flatbuffers::DetachedBuffer detached;
+  builder.Release(&detached);
+  TEST_NOTNULL(detached.data());
+  TEST_EQ(detached.data() + detached.size(), end);
+  flatbuffers::DetachedBuffer other;
+  other.swap(detached);
+  TEST_EQ(detached.data() == NULL && detached.size() == 0, true);
+  TEST_EQ(GetMonster(other.data())->hp(), 80);
+  other.reset();
+  TEST_EQ(other.data() == NULL, true);
+  builder.Clear();
+  TEST_EQ(BuildMonster(builder), end);
+
+  // Allocations stay alive until the arena is reset, after which the same
+  // memory is handed out again.
+  flatbuffers::arena_allocator arena(4096);
+  std::vector<const uint8_t *> ends;
+  for (int pass = 0; pass < 2; pass++) {
+    for (int i = 0; i < 3; i++) {
+      flatbuffers::FlatBufferBuilder arena_builder(128, &arena);
+      const uint8_t *arena_end = BuildMonster(arena_builder);
+      if (pass) TEST_EQ(arena_end, ends[i]); else ends.push_back(arena_end);
+    }
+    TEST_EQ(ends[0] != ends[1] && ends[1] != ends[2], true);
+    arena.reset();
+  }
+}
+
+// Builds a buffer exercising most builder functionality.
+void BuildMonsters(flatbuffers::FlatBufferBuilder &builder) {
+  const char *names[] = { "Fred", "Barney", "Wilma", "Pebbles", "Bamm-Bamm" };
+  std::vector<Offset<Monster> > monsters;
+  for (int i = 0; i < 100; i++) {
+    Offset<String> name = builder.CreateSharedString(names[i % 5]);
+    std::vector<uint8_t> inv(i * 7 % 300, static_cast<uint8_t>(i));
+    Offset<Vector<uint8_t> > inventory = builder.CreateVector(inv);
+    Vec3 pos(1, 2, 3, i, Color_Green, Test(5, 6));
+    monsters.push_back(CreateMonster(builder, &pos, 150, i, name, inventory,
+                                     Color_Blue));
+  }
+  Offset<Vector<Offset<Monster> > > sorted =
+    builder.CreateVectorOfSortedTables(&monsters);
+  Offset<Monster> root = CreateMonster(builder, NULL, 150, 80,
+                                       builder.CreateString("MyMonster"), 0,
+                                       Color_Blue, Any_Monster,
+                                       monsters[7].Union(), 0, 0, sorted);
+  FinishMonsterBuffer(builder, root);
+}
+
+// Chunked storage results in exactly the same bytes as a contiguous buffer.
+void ChunkedBuilderTest() {
+  flatbuffers::FlatBufferBuilder contiguous;
+  BuildMonsters(contiguous);
+  std::string expected(
+    reinterpret_cast<const char *>(contiguous.GetBufferPointer()),
+    contiguous.GetSize());
+
+  size_t chunk_sizes[] = { 16, 100, 1024, 100000 };
+  for (size_t i = 0; i < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); i++) {
+    flatbuffers::FlatBufferBuilder builder(64);
+    builder.UseChunkedStorage(chunk_sizes[i]);
+    for (int pass = 0; pass < 2; pass++) {
+      // Clear() so the second pass re-uses the first chunk.
+      builder.Clear();
+      BuildMonsters(builder);
+      std::vector<BufferSegment> segments;
+      builder.GetBufferSegments(&segments);
+      TEST_EQ(segments.size() > 1, true);
+      std::string gathered;
+      for (std::vector<BufferSegment>::const_iterator it = segments.begin();
+           it != segments.end(); ++it) {
+        TEST_EQ(it->size > 0, true);
+        gathered.append(reinterpret_cast<const char *>(it->data), it->size);
+      }
+      TEST_EQ(gathered == expected, true);
+    }
+    builder.Flatten();
+    TEST_EQ(memcmp(builder.GetBufferPointer(), expected.c_str(),
+                   expected.size()), 0);
+    // Continue building after flattening, then release.
+    builder.Clear();
+    BuildMonsters(builder);
+    flatbuffers::DetachedBuffer detached;
+    builder.Release(&detached);
+    TEST_EQ(detached.size(), expected.size());
+    TEST_EQ(memcmp(detached.data(), expected.c_str(), expected.size()), 0);
+  }
+}
+
+// Runs tasks one after the other, in reverse order to check nothing depends
+// on tasks running in order.
+class ReverseTaskRunner : public flatbuffers::TaskRunner {
+ public:
+  ReverseTaskRunner() : num_runs(0), num_tasks(0) {}
+  virtual void Run(size_t count, void (*task)(void *context, size_t index),
+                   void *context) {
+    num_runs++;
+    num_tasks += count;
+    for (size_t i = count; i > 0; ) task(context, --i);
+  }
+  int num_runs;
+  size_t num_tasks;
+};
+
+void ParallelVerifierTest() {
+  flatbuffers::FlatBufferBuilder builder;
+  BuildMonsters(builder);
+  const uint8_t *buf = builder.GetBufferPointer();
+  size_t len = builder.GetSize();
+
+  // The vector of 100 tables in the root gets split in 7 tasks, nothing else
+  // is big enough. 102 tables in total, including the root and the union.
+  ReverseTaskRunner runner;
+  flatbuffers::Verifier verifier(buf, len, 64, 102);
+  verifier.SetTaskRunner(&runner, 16);
+  TEST_EQ(VerifyMonsterBuffer(verifier), true);
+  TEST_EQ(runner.num_runs, 1);
+  TEST_EQ(runner.num_tasks, 7UL);
+
+  // Verify a batch of buffers.
+  std::string rawbuf;
+  flatbuffers::unique_ptr_t flatbuf = CreateFlatBufferTest(rawbuf);
+  const uint8_t *bufs[] = {
+    buf, flatbuf.get(), reinterpret_cast<const uint8_t *>(rawbuf.c_str())
+  };
+  size_t lens[] = { len, rawbuf.length(), rawbuf.length() };
+  bool results[] = { false, false, false };
+  TEST_EQ(flatbuffers::VerifyBuffers<Monster>(bufs, lens, 3, results, &runner),
+          true);
+  TEST_EQ(results[0] && results[1] && results[2], true);
+  TEST_EQ(runner.num_runs, 2);
+}
+
+Offset<Monster> BuildNumberedMonster(flatbuffers::FlatBufferBuilder &fbb,
+                                     size_t i, void * /*context*/) {
+  std::vector<uint8_t> inv(i % 10, static_cast<uint8_t>(i));
+  return CreateMonster(fbb, NULL, 150, static_cast<int16_t>(i),
+                       fbb.CreateSharedString(i % 2 ? "odd" : "even"),
+                       fbb.CreateVector(inv));
+}
+
+// Subtrees built in other builders can be spliced in, and refer to the same
+// data as when built in place.
+void SpliceTest() {
+  flatbuffers::FlatBufferBuilder child;
+  Offset<Monster> fred = CreateMonster(child, NULL, 150, 7,
+                                       child.CreateSharedString("Fred"));
+  flatbuffers::FlatBufferBuilder parent;
+  parent.CreateString("padding");
+  uoffset_t base = parent.Splice(child);
+  fred = flatbuffers::FlatBufferBuilder::Relocate(fred, base);
+  // The spliced string and vtable are shared with tables built later.
+  Offset<String> fred_name = parent.CreateSharedString("Fred");
+  uoffset_t size_before = parent.GetSize();
+  Offset<Monster> barney = CreateMonster(parent, NULL, 150, 8, fred_name);
+  TEST_EQ(parent.GetSize() - size_before, barney.o - size_before);
+  Offset<Monster> monsters[] = { fred, barney };
+  FinishMonsterBuffer(parent, CreateMonster(parent, NULL, 150, 80,
+                                            parent.CreateString("MyMonster"),
+                                            0, Color_Blue, Any_NONE, 0, 0, 0,
+                                            parent.CreateVector(monsters, 2)));
+  flatbuffers::Verifier verifier(parent.GetBufferPointer(), parent.GetSize());
+  TEST_EQ(VerifyMonsterBuffer(verifier), true);
+  const Vector<Offset<Monster> > *vec =
+    GetMonster(parent.GetBufferPointer())->testarrayoftables();
+  TEST_EQ(vec->Get(0)->hp(), 7);
+  TEST_EQ(vec->Get(1)->hp(), 8);
+  TEST_EQ(vec->Get(0)->name(), vec->Get(1)->name());
+
+  // A vector of tables built in parallel has the same contents as one built
+  // serially.
+  ReverseTaskRunner runner;
+  flatbuffers::FlatBufferBuilder serial;
+  std::vector<Offset<Monster> > offsets;
+  for (size_t i = 0; i < 1000; i++) {
+    offsets.push_back(BuildNumberedMonster(serial, i, NULL));
+  }
+  FinishMonsterBuffer(serial, CreateMonster(serial, NULL, 150, 80,
+                                            serial.CreateString("MyMonster"),
+                                            0, Color_Blue, Any_NONE, 0, 0, 0,
+                                            serial.CreateVector(offsets)));
+  flatbuffers::FlatBufferBuilder parallel;
+  Offset<Vector<Offset<Monster> > > tables =
+    flatbuffers::CreateVectorOfTablesInParallel(parallel, 1000,
+                                                BuildNumberedMonster, NULL,
+                                                &runner, 8);
+  FinishMonsterBuffer(parallel, CreateMonster(parallel, NULL, 150, 80,
+                                          parallel.CreateString("MyMonster"),
+                                          0, Color_Blue, Any_NONE, 0, 0, 0,
+                                          tables));
+  TEST_EQ(runner.num_tasks, 8UL);
+  flatbuffers::Verifier parallel_verifier(parallel.GetBufferPointer(),
+                                          parallel.GetSize());
+  TEST_EQ(VerifyMonsterBuffer(parallel_verifier), true);
+  const Vector<Offset<Monster> > *serial_vec =
+    GetMonster(serial.GetBufferPointer())->testarrayoftables();
+  const Vector<Offset<Monster> > *parallel_vec =
+    GetMonster(parallel.GetBufferPointer())->testarrayoftables();
+  TEST_EQ(parallel_vec->size(), 1000U);
+  for (uoffset_t i = 0; i < parallel_vec->size(); i++) {
+    TEST_EQ(parallel_vec->Get(i)->hp(), serial_vec->Get(i)->hp());
+    TEST_EQ_STR(parallel_vec->Get(i)->name()->c_str(),
+                serial_vec->Get(i)->name()->c_str());
+    TEST_EQ(parallel_vec->Get(i)->inventory()->size(),
+            serial_vec->Get(i)->inventory()->size());
+  }
+  // Each task only adds its own copy of the vtable and the two strings.
+  TEST_EQ(parallel.GetSize() < serial.GetSize() + 8 * 100, true);
+}
+
+// Tables get verified as they are accessed, and only once.
+void LazyVerifierTest() {
+  flatbuffers::FlatBufferBuilder builder;
+  BuildMonsters(builder);
+  flatbuffers::Verifier verifier(builder.GetBufferPointer(), builder.GetSize());
+
+  const Monster *root = GetMonsterLazily(verifier);
+  TEST_NOTNULL(root);
+  TEST_EQ(verifier.GetNumLazilyVerified(), 1UL);
+  TEST_EQ(root->enemy(verifier) == NULL, true);
+  const Monster *test = reinterpret_cast<const Monster *>(root->test(verifier));
+  TEST_NOTNULL(test);
+  TEST_NOTNULL(test->name());
+  TEST_EQ(verifier.GetNumLazilyVerified(), 2UL);
+  TEST_EQ(GetMonsterLazily(verifier), root);
+  TEST_EQ(verifier.GetNumLazilyVerified(), 2UL);
+
+  // The union refers to one of the vector elements, so that one isn't
+  // verified again.
+  const Vector<Offset<Monster> > *vec = root->testarrayoftables();
+  int hp_sum = 0;
+  for (uoffset_t i = 0; i < vec->size(); i++) {
+    const Monster *m = verifier.VerifyTableLazily(vec, i);
+    TEST_NOTNULL(m);
+    hp_sum += m->hp();
+  }
+  TEST_EQ(hp_sum, 99 * 100 / 2);
+  TEST_EQ(verifier.GetNumLazilyVerified(), 101UL);
+
+  // A table referred to as two different types is verified as each.
+  flatbuffers::FlatBufferBuilder shared_builder;
+  Vec3 pos(1, 2, 3, 0, Color_Red, Test(10, 20));
+  Offset<Monster> enemy = CreateMonster(shared_builder, &pos, 150, 80,
+                                        shared_builder.CreateString("e"));
+  Offset<flatbuffers::String> name = shared_builder.CreateString("m");
+  MonsterBuilder mb(shared_builder);
+  mb.add_name(name);
+  mb.add_enemy(enemy);
+  mb.add_test_type(Any_TestSimpleTableWithEnum);
+  mb.add_test(enemy.Union());
+  FinishMonsterBuffer(shared_builder, mb.Finish());
+  flatbuffers::Verifier shared_verifier(shared_builder.GetBufferPointer(),
+                                        shared_builder.GetSize());
+  const Monster *shared_root = GetMonsterLazily(shared_verifier);
+  TEST_NOTNULL(shared_root);
+  const Monster *shared_enemy = shared_root->enemy(shared_verifier);
+  TEST_NOTNULL(shared_enemy);
+  TEST_EQ(shared_verifier.GetNumLazilyVerified(), 2UL);
+  TEST_EQ(shared_root->test(shared_verifier),
+          reinterpret_cast<const void *>(shared_enemy));
+  TEST_EQ(shared_verifier.GetNumLazilyVerified(), 3UL);
+  TEST_EQ(shared_root->enemy(shared_verifier), shared_enemy);
+  TEST_EQ(shared_verifier.GetNumLazilyVerified(), 3UL);
+}
+
+// Mapped files can be used in place, like a loaded copy.
+void MappedFileTest() {
+  std::string loaded;
+  TEST_EQ(flatbuffers::LoadFile("tests/monsterdata_test.mon", true, &loaded),
+          true);
+  flatbuffers::MappedFile mapped;
+  TEST_EQ(mapped.Map("tests/monsterdata_test.mon",
+                     flatbuffers::MappedFile::kAccessRandom, true), true);
+  TEST_EQ(mapped.size(), loaded.size());
+  TEST_EQ(memcmp(mapped.data(), loaded.c_str(), loaded.size()), 0);
+
+  flatbuffers::Verifier verifier(mapped.data(), mapped.size());
+  TEST_EQ(VerifyMonsterBuffer(verifier), true);
+  TEST_EQ_STR(GetMonster(mapped.data())->name()->c_str(), "MyMonster");
+  TEST_EQ(flatbuffers::GetAnyRoot(mapped.data()) != NULL, true);
+  TEST_EQ(mapped.Advise(flatbuffers::MappedFile::kAccessSequential), true);
+
+  // Mapping another file replaces the previous mapping.
+  TEST_EQ(mapped.Map("tests/monster_test.bfbs"), true);
+  flatbuffers::Verifier schema_verifier(mapped.data(), mapped.size());
+  TEST_EQ(reflection::VerifySchemaBuffer(schema_verifier), true);
+
+  mapped.Unmap();
+  TEST_EQ(mapped.data() == NULL, true);
+  TEST_EQ(mapped.size(), 0U);
+  TEST_EQ(mapped.Advise(flatbuffers::MappedFile::kAccessNormal), false);
+  TEST_EQ(mapped.Map("tests/does_not_exist.mon"), false);
+  TEST_EQ(mapped.data() == NULL, true);
+}
+
+// Verify buffers using only their binary schema.
+void SchemaVerifierTest(const uint8_t *flatbuf, size_t length) {
+  std::string bfbsfile;
+  TEST_EQ(flatbuffers::LoadFile(
+    "tests/monster_test.bfbs", true, &bfbsfile), true);
+  const reflection::Schema &schema = *reflection::GetSchema(bfbsfile.c_str());
+  flatbuffers::SchemaVerifier schema_verifier(schema);
+  TEST_EQ(schema_verifier.VerifyBuffer(flatbuf, length), true);
+
+  // Same limits on depth and amount of tables as generated code: the
+  // buffer has the root, the union and the vector of 100 tables.
+  flatbuffers::FlatBufferBuilder builder;
+  BuildMonsters(builder);
+  const uint8_t *buf = builder.GetBufferPointer();
+  TEST_EQ(schema_verifier.VerifyBuffer(buf, builder.GetSize(),
+                                       schema.root_table(), 2, 102), true);
+  flatbuffers::Verifier verifier(buf, builder.GetSize(), 2, 102);
+  TEST_EQ(VerifyMonsterBuffer(verifier), true);
+
+  // Verify a table inside a buffer with an existing verifier.
+  const reflection::Object &monsterdef = *schema.root_table();
+  flatbuffers::Verifier table_verifier(buf, builder.GetSize());
+  TEST_EQ(schema_verifier.VerifyTable(table_verifier, monsterdef,
+            reinterpret_cast<const Table *>(GetMonster(buf)->test())), true);
+  TEST_EQ(schema_verifier.VerifyTable(table_verifier, monsterdef,
+                                      GetAnyRoot(buf)), true);
+}
+
+// CreateVector writes scalar vectors in bulk, check that gives the same
+// result as writing them an element at a time.
+template<typename T> void BulkVectorTest(size_t len) {
+  std::vector<T> elems;
+  for (size_t i = 0; i < len; i++)
+    elems.push_back(static_cast<T>(lcg_rand()));
+  flatbuffers::FlatBufferBuilder bulk, single;
+  // Misalign the start, so alignment gets tested too.
+  bulk.CreateString("x");
+  single.CreateString("x");
+  uoffset_t bulk_vec = bulk.CreateVector(elems).o;
+  single.StartVector(len, sizeof(T));
+  for (size_t i = len; i > 0; ) single.PushElement(elems[--i]);
+  uoffset_t single_vec = single.EndVector(len);
+  bulk.Finish(Offset<Vector<T> >(bulk_vec));
+  single.Finish(Offset<Vector<T> >(single_vec));
+  TEST_EQ(bulk.GetSize(), single.GetSize());
+  TEST_EQ(memcmp(bulk.GetBufferPointer(), single.GetBufferPointer(),
+                 bulk.GetSize()), 0);
+  const Vector<T> *vec = GetRoot<Vector<T> >(bulk.GetBufferPointer());
+  TEST_EQ(vec->size(), len);
+  for (size_t i = 0; i < len; i++) TEST_EQ(vec->Get(i) == elems[i], true);
+}
+
+void BulkVectorTests() {
+  lcg_reset();
+  BulkVectorTest<uint8_t>(0);
+  BulkVectorTest<uint8_t>(1001);
+  BulkVectorTest<int16_t>(3);
+  BulkVectorTest<float>(1000);
+  BulkVectorTest<double>(0);
+  BulkVectorTest<double>(999);
+  BulkVectorTest<uint64_t>(1);
+}
+
+void VectorViewTest() {
+  flatbuffers::FlatBufferBuilder builder;
+  uint8_t inv[] = { 0, 1, 2, 3, 4 };
+  Test tests[] = { Test(10, 20), Test(30, 40) };
+  std::vector<uint64_t> keys;
+  for (uint64_t i = 0; i < 10; i++) keys.push_back(i << 40);
+  Offset<Vector<uint8_t> > inventory = builder.CreateVector(inv, 5);
+  Offset<Vector<const Test *> > test4 = builder.CreateVectorOfStructs(tests,
+                                                                      2);
+  Offset<Vector<uint64_t> > keys_vec = builder.CreateVector(keys);
+  MonsterBuilder mb(builder);
+  mb.add_name(builder.CreateString("MyMonster"));
+  mb.add_inventory(inventory);
+  mb.add_test4(test4);
+  mb.add_testarrayoftables_keys(keys_vec);
+  FinishMonsterBuffer(builder, mb.Finish());
+
+  // Once where aligned, once copied to an address that is only aligned to
+  // 4 bytes, as some transports do.
+  std::vector<uint64_t> misaligned(builder.GetSize() / 8 + 1);
+  uint8_t *moved = reinterpret_cast<uint8_t *>(&misaligned[0]) + 4;
+  memcpy(moved, builder.GetBufferPointer(), builder.GetSize());
+  const uint8_t *bufs[] = { builder.GetBufferPointer(), moved };
+  for (int b = 0; b < 2; b++) {
+    const Monster *monster = GetMonster(bufs[b]);
+    flatbuffers::VectorView<uint8_t> inv_view = monster->inventory_view();
+    TEST_EQ(inv_view.size(), 5U);
+    TEST_EQ(inv_view.copied(), !FLATBUFFERS_LITTLEENDIAN);
+    TEST_EQ(memcmp(inv_view.data(), inv, sizeof(inv)), 0);
+
+    flatbuffers::VectorView<uint64_t> keys_view =
+      monster->testarrayoftables_keys_view();
+    TEST_EQ(keys_view.copied(), b == 1 || !FLATBUFFERS_LITTLEENDIAN);
+    TEST_EQ(reinterpret_cast<size_t>(keys_view.data()) %
+            flatbuffers::AlignOf<uint64_t>(), 0U);
+    TEST_EQ(keys_view.size(), keys.size());
+    for (uoffset_t i = 0; i < keys_view.size(); i++)
+      TEST_EQ(keys_view[i], keys[i]);
+    // Copies of copies have their own storage.
+    flatbuffers::VectorView<uint64_t> keys_copy;
+    keys_copy = keys_view;
+    TEST_EQ(keys_copy.data() != keys_view.data(), keys_view.copied());
+    TEST_EQ(std::equal(keys_copy.begin(), keys_copy.end(), keys.begin()),
+            true);
+
+    flatbuffers::VectorView<Test> test4_view = monster->test4_view();
+    TEST_EQ(test4_view.copied(), false);
+    TEST_EQ(test4_view.size(), 2U);
+    TEST_EQ(test4_view[0].a(), 10);
+    TEST_EQ(test4_view[1].b(), 40);
+
+    // Unset fields give empty views.
+    flatbuffers::VectorView<uint8_t> bools = monster->testarrayofbools_view();
+    TEST_EQ(bools.empty() && bools.begin() == bools.end(), true);
+  }
+}
+
+// Vectors after the end of the buffer, referred to with 64bit offsets.
+void LargeBufferTest() {
+  using MyGame::Large::Point;
+  using MyGame::Large::Tile;
+  // The preview is a buffer of its own, nested in the region.
+  flatbuffers::FlatBufferBuilder preview_builder;
+  MyGame::Large::FinishTileBuffer(preview_builder, MyGame::Large::CreateTile(
+    preview_builder, preview_builder.CreateString("preview"), 0, 0, 0, 2));
+  std::vector<uint8_t> preview(preview_builder.GetBufferPointer(),
+                               preview_builder.GetBufferPointer() +
+                               preview_builder.GetSize());
+  std::vector<float> weights;
+  for (int i = 0; i < 1000; i++) weights.push_back(i * 0.5f);
+  Point points[] = { Point(1, 2), Point(3, 4), Point(5, 6) };
+
+  flatbuffers::FlatBufferBuilder builder;
+  flatbuffers::LargeBufferBuilder large(builder);
+  flatbuffers::Offset64<flatbuffers::Vector64<float> > weights_vec =
+    large.CreateVector(weights);
+  flatbuffers::Offset64<flatbuffers::Vector64<Point> > points_vec =
+    large.CreateVector(points, 3);
+  flatbuffers::Offset64<flatbuffers::Vector64<uint8_t> > preview_vec =
+    large.CreateVector(preview);
+  MyGame::Large::FinishTileBuffer(builder, MyGame::Large::CreateTile(
+    builder, builder.CreateString("tile"), weights_vec, points_vec,
+    preview_vec, 1));
+  std::ostringstream out;
+  TEST_EQ(large.Write(out), true);
+  std::string written = out.str();
+  TEST_EQ(written.size(), large.GetSize());
+
+  // Aligned like a mapped file would be.
+  std::vector<uint64_t> aligned(written.size() / 8 + 1);
+  uint8_t *buf = reinterpret_cast<uint8_t *>(&aligned[0]);
+  memcpy(buf, written.c_str(), written.size());
+  flatbuffers::Verifier verifier(buf, written.size());
+  TEST_EQ(MyGame::Large::VerifyTileBuffer(verifier), true);
+  const Tile *tile = MyGame::Large::GetTile(buf);
+  TEST_EQ_STR(tile->name()->c_str(), "tile");
+  TEST_EQ(tile->id(), 1U);
+  TEST_EQ(tile->weights()->size(), 1000U);
+  TEST_EQ(tile->weights()->Get(999), 499.5f);
+  TEST_EQ(reinterpret_cast<uintptr_t>(tile->weights()->Data()) % 8, 0U);
+  TEST_EQ(tile->points()->size(), 3U);
+  TEST_EQ(tile->points()->data()[2].y(), 6);
+  TEST_EQ(tile->preview()->size(), preview.size());
+  const Tile *nested = tile->preview_nested_root();
+  TEST_EQ_STR(nested->name()->c_str(), "preview");
+  TEST_EQ(nested->id(), 2U);
+  TEST_EQ(nested->weights() == NULL, true);
+  MyGame::Large::GetMutableTile(buf)->mutable_weights()->Mutate(0, 7);
+  TEST_EQ(tile->weights()->Get(0), 7);
+
+  #ifndef FLATBUFFERS_NO_FILE_TESTS
+  // Text output, and verification through reflection.
+  std::string schemafile;
+  TEST_EQ(flatbuffers::LoadFile("tests/large_test.fbs", false, &schemafile),
+          true);
+  flatbuffers::Parser parser;
+  TEST_EQ(parser.Parse(schemafile.c_str()), true);
+  flatbuffers::GeneratorOptions opts;
+  opts.indent_step = -1;
+  std::string text;
+  GenerateText(parser, buf, opts, &text);
+  TEST_NOTNULL(strstr(text.c_str(), "weights: [7,0.5,1,1.5,"));
+  TEST_NOTNULL(strstr(text.c_str(), "points: [{x: 1,y: 2},"));
+  // Can't be parsed back in.
+  TEST_EQ(parser.Parse(text.c_str()), false);
+  TEST_NOTNULL(strstr(parser.error_.c_str(), "offset64 fields can't"));
+  flatbuffers::Parser schema_parser;
+  TEST_EQ(schema_parser.Parse(schemafile.c_str()), true);
+  schema_parser.Serialize();
+  const reflection::Schema &schema = *reflection::GetSchema(
+    schema_parser.builder_.GetBufferPointer());
+  TEST_EQ(flatbuffers::SchemaVerifier(schema).VerifyBuffer(buf,
+                                                          written.size()),
+          true);
+  const reflection::Field *weights_field =
+    schema.root_table()->fields()->LookupByKey("weights");
+  TEST_EQ(flatbuffers::GetFieldV64<float>(*flatbuffers::GetAnyRoot(buf),
+                                          *weights_field)->Get(1), 0.5f);
+  TEST_EQ(flatbuffers::CopyPlan(schema).ok(), false);
+
+  // Resizing adjusts the offsets, whether the whole buffer was loaded or
+  // just the front, followed by the region afterwards.
+  std::string longer(100, 'x');
+  std::vector<uint8_t> whole(buf, buf + written.size());
+  flatbuffers::SetString(schema, longer,
+                         MyGame::Large::GetTile(&whole[0])->name(), &whole);
+  std::vector<uint8_t> front(buf, buf + builder.GetSize());
+  flatbuffers::SetString(schema, longer,
+                         MyGame::Large::GetTile(&front[0])->name(), &front);
+  front.insert(front.end(), buf + builder.GetSize(), buf + written.size());
+  TEST_EQ(whole == front, true);
+  flatbuffers::Verifier resized_verifier(&whole[0], whole.size());
+  TEST_EQ(MyGame::Large::VerifyTileBuffer(resized_verifier), true);
+  const Tile *resized = MyGame::Large::GetTile(&whole[0]);
+  TEST_EQ(resized->name()->str() == longer, true);
+  TEST_EQ(resized->weights()->Get(999), 499.5f);
+  TEST_EQ(resized->points()->data()[1].x(), 3);
+  TEST_EQ(resized->preview_nested_root()->id(), 2U);
+  #endif
+
+  // Without any vectors, nothing follows the buffer.
+  flatbuffers::FlatBufferBuilder small_builder;
+  flatbuffers::LargeBufferBuilder small(small_builder);
+  MyGame::Large::FinishTileBuffer(small_builder,
+                                  MyGame::Large::CreateTile(small_builder));
+  std::ostringstream small_out;
+  TEST_EQ(small.Write(small_out), true);
+  TEST_EQ(small.GetSize(), small_builder.GetSize());
+  TEST_EQ(small_out.str().size(), small_builder.GetSize());
+}
+
 // High level stress/fuzz test: generate a big schema and
 // matching json data in random combinations, then parse both,
 // generate json back from the binary, and compare with the original.
@@ -754,6 +1736,7 @@ void ErrorTest() {
   TestError(".0", "floating point");
   TestError("\"\0", "illegal");
   TestError("\"\\q", "escape code");
+  TestError("\"long enough to be scanned a word at a time\t\"", "illegal");
   TestError("table ///", "documentation");
   TestError("@", "illegal");
   TestError("table 1", "expecting");
@@ -792,6 +1775,10 @@ void ErrorTest() {
   TestError("table X { Y:[int]; YLength:int; }", "clash");
   TestError("table X { Y:string = 1; }", "scalar");
   TestError("table X { Y:byte; } root_type X; { Y:1, Y:2 }", "more than once");
+  TestError("table X { Y:[int] (key_index: \"Z\"); }", "vector of ulong");
+  TestError("table X { Y:[ulong] (key_index: \"Z\"); }", "key_index");
+  TestError("table X { Y:int (offset64); }", "offset64 attribute");
+  TestError("table X { Y:[string] (offset64); }", "offset64 attribute");
 }
 
 // Additional parser testing not covered elsewhere.
@@ -810,6 +1797,56 @@ void ScientificTest() {
           fabs(root[1] - 3.14159) < 0.001, true);
 }
 
+// Roundtrip a value through NumToString and strtod.
+template<typename T> void NumToStringRoundtrip(T val) {
+  std::string s = flatbuffers::NumToString(val);
+  T parsed = static_cast<T>(strtod(s.c_str(), NULL));
+  TEST_EQ(memcmp(&parsed, &val, sizeof(T)), 0);
+}
+
+void NumToStringTest() {
+  TEST_EQ_STR(flatbuffers::NumToString(0).c_str(), "0");
+  TEST_EQ_STR(flatbuffers::NumToString(-12345).c_str(), "-12345");
+  TEST_EQ_STR(flatbuffers::NumToString(static_cast<int8_t>(-128)).c_str(),
+              "-128");
+  TEST_EQ_STR(flatbuffers::NumToString(static_cast<uint8_t>(255)).c_str(),
+              "255");
+  TEST_EQ_STR(flatbuffers::NumToString('A').c_str(), "65");
+  TEST_EQ_STR(flatbuffers::NumToString(
+                static_cast<int64_t>(0x8000000000000000ULL)).c_str(),
+              "-9223372036854775808");
+  TEST_EQ_STR(flatbuffers::NumToString(0xFFFFFFFFFFFFFFFFULL).c_str(),
+              "18446744073709551615");
+  TEST_EQ_STR(flatbuffers::NumToString(Color_Blue).c_str(), "8");
+
+  // Floating point values use the shortest text that parses back to the same
+  // value, without exponent.
+  TEST_EQ_STR(flatbuffers::NumToString(1.0).c_str(), "1");
+  TEST_EQ_STR(flatbuffers::NumToString(0.1).c_str(), "0.1");
+  TEST_EQ_STR(flatbuffers::NumToString(-2.5).c_str(), "-2.5");
+  TEST_EQ_STR(flatbuffers::NumToString(0.0).c_str(), "0");
+  TEST_EQ_STR(flatbuffers::NumToString(-0.0).c_str(), "-0");
+  TEST_EQ_STR(flatbuffers::NumToString(1e21).c_str(),
+              "1000000000000000000000");
+  TEST_EQ_STR(flatbuffers::NumToString(1.5e-7).c_str(), "0.00000015");
+  TEST_EQ_STR(flatbuffers::NumToString(3.14159f).c_str(), "3.14159");
+  TEST_EQ_STR(flatbuffers::NumToString(0.1f).c_str(), "0.1");
+  NumToStringRoundtrip(4.9406564584124654e-324);  // Smallest denormal.
+  NumToStringRoundtrip(1.7976931348623157e308);   // Largest double.
+  NumToStringRoundtrip(1.17549435e-38f);          // Smallest normal float.
+  lcg_reset();
+  for (int i = 0; i < 10000; i++) {
+    uint64_t bits = (static_cast<uint64_t>(lcg_rand()) << 32) | lcg_rand();
+    double d;
+    memcpy(&d, &bits, sizeof(d));
+    if (d == d && d - d == 0) NumToStringRoundtrip(d);  // Skip nan and inf.
+    uint32_t fbits = lcg_rand();
+    float f;
+    memcpy(&f, &fbits, sizeof(f));
+    if (f == f && f - f == 0) NumToStringRoundtrip(f);
+  }
+}
+
 void EnumStringsTest() {
   flatbuffers::Parser parser1;
   TEST_EQ(parser1.Parse("enum E:byte { A, B, C } table T { F:[E]; }"
@@ -835,6 +1872,527 @@ void UnicodeTest() {
                      "\\u5225\\u30B5\\u30A4\\u30C8\\x01\\x80\"}", true);
 }
 
+void LongStringTest() {
+  // Strings long enough for the tokenizer to skip through them a word at a
+  // time, with escapes and multi-byte chars at varying offsets.
+  std::string text;
+  for (int i = 0; i < 40; i++) {
+    text += std::string(i, 'a') + "\\\"" + std::string(i % 9, 'b') +
+            "\\u20AC\\n";
+  }
+  flatbuffers::Parser parser;
+  TEST_EQ(parser.Parse(("table T { F:string; } root_type T; { F:\"" + text +
+                        "\" }").c_str()), true);
+  std::string expected;
+  for (int i = 0; i < 40; i++) {
+    expected += std::string(i, 'a') + "\"" + std::string(i % 9, 'b') +
+                "\xE2\x82\xAC\n";
+  }
+  const flatbuffers::Table *root = flatbuffers::GetRoot<flatbuffers::Table>(
+                                      parser.builder_.GetBufferPointer());
+  const flatbuffers::String *str =
+    root->GetPointer<const flatbuffers::String *>(4);
+  TEST_EQ_STR(str->c_str(), expected.c_str());
+}
+
+bool CollectBuffer(void *context, const uint8_t *buf, size_t len) {
+  static_cast<std::vector<std::string> *>(context)->push_back(
+    std::string(reinterpret_cast<const char *>(buf), len));
+  return true;
+}
+
+void JsonConverterTest() {
+  const char *schema = "enum E:byte { A, B } "
+                       "table T { X:int; S:string; V:[short]; F:E; I:int; } "
+                       "root_type T;";
+  const char *objects[] = {
+    "{ X: 1, S: \"one\" }",
+    "{ X: 2, V: [ 1, 2, 3 ], F: \"B\" }",
+    "{ S: \"three\", F: B, I: \"E.B\" }",
+  };
+  const int num_objects = sizeof(objects) / sizeof(objects[0]);
+  flatbuffers::Parser schema_parser;
+  TEST_EQ(schema_parser.Parse(schema), true);
+
+  // Newline-delimited JSON, with an empty line thrown in.
+  std::string ndjson;
+  for (int i = 0; i < num_objects; i++) {
+    ndjson += objects[i];
+    ndjson += i == 1 ? "\n\n" : "\n";
+  }
+  std::vector<std::string> buffers;
+  flatbuffers::JsonConverter converter(schema_parser);
+  TEST_EQ(converter.ConvertAll(ndjson.c_str(), CollectBuffer, &buffers), true);
+  TEST_EQ(converter.count(), static_cast<size_t>(num_objects));
+  TEST_EQ(buffers.size(), static_cast<size_t>(num_objects));
+  for (int i = 0; i < num_objects; i++) {
+    // Must be the same as parsing schema and object together.
+    flatbuffers::Parser parser;
+    TEST_EQ(parser.Parse((std::string(schema) + objects[i]).c_str()), true);
+    TEST_EQ(buffers[i] ==
+            std::string(reinterpret_cast<const char *>(
+                          parser.builder_.GetBufferPointer()),
+                        parser.builder_.GetSize()), true);
+  }
+
+  // A second converter sharing the schema, building into our own builder.
+  flatbuffers::FlatBufferBuilder builder;
+  flatbuffers::JsonConverter converter2(schema_parser, &builder);
+  TEST_EQ(converter2.Convert("{ X: 1, X: 2 }"), false);
+  TEST_NOTNULL(strstr(converter2.error().c_str(), "more than once"));
+  TEST_EQ(converter2.Convert("{ X: 1 } { X: 2 }"), false);
+  TEST_NOTNULL(strstr(converter2.error().c_str(), "more than one"));
+  TEST_EQ(converter2.Convert(objects[0]), true);
+  TEST_EQ(std::string(reinterpret_cast<const char *>(
+                        builder.GetBufferPointer()), builder.GetSize()) ==
+          buffers[0], true);
+
+  // The schema parser itself is still usable for JSON.
+  TEST_EQ(schema_parser.Parse(objects[2]), true);
+  TEST_EQ(std::string(reinterpret_cast<const char *>(
+                        schema_parser.builder_.GetBufferPointer()),
+                      schema_parser.builder_.GetSize()) == buffers[2], true);
+}
+
+void SchemaCacheTest() {
+  std::string schemafile;
+  std::string jsonfile;
+  TEST_EQ(flatbuffers::LoadFile(
+    "tests/monster_test.fbs", false, &schemafile), true);
+  TEST_EQ(flatbuffers::LoadFile(
+    "tests/monsterdata_test.golden", false, &jsonfile), true);
+  const char *include_directories[] = { "tests", NULL };
+  flatbuffers::GeneratorOptions opts;
+  opts.include_dependence_headers = false;
+
+  flatbuffers::SchemaCache cache;
+  std::string fbs[2], bfbs[2], json[2];
+  for (int i = 0; i < 2; i++) {
+    flatbuffers::Parser parser;
+    parser.SetSchemaCache(&cache);
+    TEST_EQ(parser.Parse(schemafile.c_str(), include_directories), true);
+    TEST_EQ(cache.hits(), static_cast<size_t>(i));
+    fbs[i] = flatbuffers::GenerateFBS(parser, "monster_test", opts);
+    parser.Serialize();
+    bfbs[i] = std::string(reinterpret_cast<const char *>(
+                            parser.builder_.GetBufferPointer()),
+                          parser.builder_.GetSize());
+    TEST_EQ(parser.Parse(jsonfile.c_str(), include_directories), true);
+    GenerateText(parser, parser.builder_.GetBufferPointer(), opts, &json[i]);
+  }
+  // include_test1.fbs and the include_test2.fbs it includes.
+  TEST_EQ(cache.misses(), 2U);
+  // Restored from the cache, the schema must be the same as parsed.
+  TEST_EQ_STR(fbs[1].c_str(), fbs[0].c_str());
+  TEST_EQ(bfbs[1] == bfbs[0], true);
+  TEST_EQ_STR(json[1].c_str(), json[0].c_str());
+
+  // An include on its own is restored from the same entry.
+  flatbuffers::Parser parser;
+  parser.SetSchemaCache(&cache);
+  TEST_EQ(parser.Parse("include \"include_test1.fbs\";",
+                       include_directories), true);
+  TEST_EQ(parser.Parse(schemafile.c_str(), include_directories), true);
+  TEST_EQ(cache.hits(), 2U);
+  TEST_EQ(parser.Parse(schemafile.c_str(), include_directories), false);
+  // Once there's more in the schema than include files, it's not used.
+  flatbuffers::Parser parser2;
+  parser2.SetSchemaCache(&cache);
+  TEST_EQ(parser2.Parse("table X {}", include_directories), true);
+  TEST_EQ(parser2.Parse(schemafile.c_str(), include_directories), true);
+  TEST_EQ(cache.hits(), 2U);
+  TEST_EQ(cache.misses(), 2U);
+}
+
+// Records can be read back from a log by number, also when the log was
+// never finished.
+void RecordLogTest() {
+  std::ostringstream out;
+  flatbuffers::RecordLogWriter writer(out, MonsterIdentifier());
+  std::vector<std::string> copies;
+  for (int i = 0; i < 20; i++) {
+    flatbuffers::FlatBufferBuilder builder;
+    std::vector<uint8_t> inv(i * 3, static_cast<uint8_t>(i));
+    FinishMonsterBuffer(builder, CreateMonster(builder, NULL, 150, 80,
+      builder.CreateString("monster_" + flatbuffers::NumToString(i)),
+      builder.CreateVector(inv)));
+    TEST_EQ(writer.Append(builder), true);
+    copies.push_back(std::string(
+      reinterpret_cast<const char *>(builder.GetBufferPointer()),
+      builder.GetSize()));
+  }
+  // Buffers without the identifier aren't accepted.
+  flatbuffers::FlatBufferBuilder other;
+  other.Finish(CreateMonster(other, NULL, 150, 80, other.CreateString("x")));
+  TEST_EQ(writer.Append(other), false);
+  TEST_EQ(writer.num_records(), 20U);
+  std::string unfinished = out.str();
+  TEST_EQ(writer.Finish(), true);
+  std::string log = out.str();
+
+  flatbuffers::RecordLogReader reader;
+  TEST_EQ(reader.Init(reinterpret_cast<const uint8_t *>(log.c_str()),
+                      log.size()), true);
+  TEST_EQ(reader.has_index(), true);
+  TEST_EQ(reader.num_records(), 20U);
+  TEST_EQ_STR(reader.file_identifier().c_str(), MonsterIdentifier());
+  for (size_t i = 0; i < reader.num_records(); i++) {
+    size_t len;
+    const uint8_t *buf = reader.Get(i, &len);
+    TEST_EQ(reinterpret_cast<size_t>(buf) %
+            sizeof(flatbuffers::largest_scalar_t), 0U);
+    TEST_EQ(std::string(reinterpret_cast<const char *>(buf), len) ==
+            copies[i], true);
+    flatbuffers::Verifier verifier(buf, len);
+    TEST_EQ(VerifyMonsterBuffer(verifier), true);
+  }
+  TEST_EQ_STR(reader.GetRoot<Monster>(13)->name()->c_str(), "monster_13");
+  size_t len;
+  TEST_EQ(reader.Get(20, &len) == NULL, true);
+
+  // Without the index, the same records are found by following their sizes.
+  TEST_EQ(reader.Init(reinterpret_cast<const uint8_t *>(unfinished.c_str()),
+                      unfinished.size()), true);
+  TEST_EQ(reader.has_index(), false);
+  TEST_EQ(reader.num_records(), 20U);
+  TEST_EQ_STR(reader.GetRoot<Monster>(19)->name()->c_str(), "monster_19");
+  // A partially written record is left out.
+  TEST_EQ(reader.Init(reinterpret_cast<const uint8_t *>(unfinished.c_str()),
+                      unfinished.size() - 1), true);
+  TEST_EQ(reader.num_records(), 19U);
+  // So is a partially written index.
+  TEST_EQ(reader.Init(reinterpret_cast<const uint8_t *>(log.c_str()),
+                      log.size() - 1), true);
+  TEST_EQ(reader.has_index(), false);
+  TEST_EQ(reader.num_records(), 20U);
+
+  TEST_EQ(reader.Init(reinterpret_cast<const uint8_t *>(copies[0].c_str()),
+                      copies[0].size()), false);
+}
+
+// The hash functions match their reference values, and the compile time
+// versions match the runtime ones.
+void HashTest() {
+  // Reference values for xxHash with seed 0.
+  const char *spam = "Nobody inspects the spammish repetition";
+  TEST_EQ(flatbuffers::HashXXH32(""), 0x02CC5D05U);
+  TEST_EQ(flatbuffers::HashXXH32("abc"), 0x32D153FFU);
+  TEST_EQ(flatbuffers::HashXXH32(spam), 0xE2293B2FU);
+  TEST_EQ(flatbuffers::HashXXH64(""), 0xEF46DB3751D8E999ULL);
+  TEST_EQ(flatbuffers::HashXXH64("abc"), 0x44BC2CF5AD770999ULL);
+  TEST_EQ(flatbuffers::HashXXH64(spam), 0xFBCEA83C8A378BF1ULL);
+
+  lcg_reset();  // Keep it deterministic.
+  char data[100];
+  for (size_t i = 0; i < sizeof(data); i++) {
+    data[i] = static_cast<char>(lcg_rand());
+  }
+  // All lengths, to cover every combination of stripes and tail bytes.
+  for (size_t len = 0; len <= sizeof(data); len++) {
+    TEST_EQ(flatbuffers::HashXXH32(data, len, 1234),
+            flatbuffers::ConstHashXXH32(data, len, 1234));
+    TEST_EQ(flatbuffers::HashXXH64(data, len, 1234),
+            flatbuffers::ConstHashXXH64(data, len, 1234));
+  }
+  for (size_t i = 0; i < sizeof(data) - 1; i++) {
+    if (!data[i]) data[i] = 1;
+  }
+  data[sizeof(data) - 1] = 0;
+  TEST_EQ(flatbuffers::HashFnv1<uint32_t>(data),
+          flatbuffers::ConstHashFnv1<uint32_t>(data));
+  TEST_EQ(flatbuffers::HashFnv1a<uint64_t>(data),
+          flatbuffers::ConstHashFnv1a<uint64_t>(data));
+
+  #if __cplusplus >= 201103L
+    // The generated hash functions fold into constants.
+    static_assert(Monster::testhashu32_fnv1a_hash("This string is being "
+                                                  "hashed!") == 2390860913U,
+                  "hashed at compile time");
+  #endif
+  TEST_EQ(Monster::testhashs64_fnv1a_hash("x"),
+          static_cast<int64_t>(flatbuffers::HashFnv1a<uint64_t>("x")));
+
+  // xxHash fields hash JSON strings like the others.
+  flatbuffers::Parser parser;
+  TEST_EQ(parser.Parse("table X { a:uint (hash:\"xxh32\"); "
+                       "b:ulong (hash:\"xxh64\"); } root_type X; "
+                       "{ a: \"abc\", b: \"abc\" }"), true);
+  flatbuffers::Table *root = const_cast<flatbuffers::Table *>(
+    flatbuffers::GetRoot<flatbuffers::Table>(
+      parser.builder_.GetBufferPointer()));
+  TEST_EQ(root->GetField<uint32_t>(4, 0), 0x32D153FFU);
+  TEST_EQ(root->GetField<uint64_t>(6, 0), 0x44BC2CF5AD770999ULL);
+}
+
+// Large vectors are sorted by extracted keys, and must end up in the same
+// order as sorting by KeyCompareLessThan.
+void SortedTablesTest() {
+  lcg_reset();  // Keep it deterministic.
+  flatbuffers::FlatBufferBuilder builder;
+  std::vector<Offset<Monster> > monsters;
+  for (int i = 0; i < 1000; i++) {
+    // A few distinct prefixes, so most strings are only ordered by their tail.
+    std::string name = "prefix" + flatbuffers::NumToString(lcg_rand() % 3) +
+                       "_" + flatbuffers::NumToString(lcg_rand() % 500);
+    if (i % 10 == 0) name = name.substr(0, lcg_rand() % 9);
+    monsters.push_back(CreateMonster(builder, NULL, 150, 80,
+                                     builder.CreateString(name)));
+  }
+  builder.CreateVectorOfSortedTables(&monsters);
+  // The vector just created is at the start of the buffer.
+  const Vector<Offset<Monster> > *sorted =
+    reinterpret_cast<const Vector<Offset<Monster> > *>(
+      builder.GetBufferPointer());
+  TEST_EQ(sorted->size(), monsters.size());
+  for (uoffset_t i = 1; i < sorted->size(); i++) {
+    TEST_EQ(sorted->Get(i)->KeyCompareLessThan(sorted->Get(i - 1)), false);
+  }
+
+  // Scalar keys, including negative ones, are sorted by the radix sort alone.
+  std::vector<Offset<reflection::EnumVal> > vals;
+  for (int i = 0; i < 1000; i++) {
+    int64_t value = static_cast<int64_t>(lcg_rand()) - 0x40000000;
+    if (i % 100 == 0) value *= 0x10000000LL;
+    vals.push_back(reflection::CreateEnumVal(builder,
+                                             builder.CreateString("v"),
+                                             value));
+  }
+  builder.CreateVectorOfSortedTables(&vals);
+  const Vector<Offset<reflection::EnumVal> > *sorted_vals =
+    reinterpret_cast<const Vector<Offset<reflection::EnumVal> > *>(
+      builder.GetBufferPointer());
+  TEST_EQ(sorted_vals->size(), vals.size());
+  for (uoffset_t i = 1; i < sorted_vals->size(); i++) {
+    TEST_EQ(sorted_vals->Get(i - 1)->value() <= sorted_vals->Get(i)->value(),
+            true);
+  }
+}
+
+// Lookups through a key index find the same tables as LookupByKey.
+// Stands in for Monster in LookupByKeyIndex(), counting the tables read.
+struct KeyCompareCounter {
+  int KeyCompareWithValue(const char *val) const {
+    compares++;
+    return reinterpret_cast<const Monster *>(this)->KeyCompareWithValue(val);
+  }
+  static int compares;
+};
+int KeyCompareCounter::compares = 0;
+
+// A hand written table type, with only the key comparison.
+struct NameOnlyMonster {
+  bool KeyCompareLessThan(const NameOnlyMonster *o) const {
+    return *reinterpret_cast<const Monster *>(this)->name() <
+           *reinterpret_cast<const Monster *>(o)->name();
+  }
+};
+
+void KeyIndexTest() {
+  flatbuffers::FlatBufferBuilder builder;
+  std::vector<Offset<Monster> > monsters;
+  // Names share their first 8 bytes, so index values are mostly equal.
+  for (int i = 0; i < 300; i += 3) {
+    char name[32];
+    snprintf(name, sizeof(name), "monster_%d", i);
+    monsters.push_back(CreateMonster(builder, NULL, 150, 80,
+                                     builder.CreateString(name)));
+  }
+  monsters.push_back(CreateMonster(builder, NULL, 150, 80,
+                                   builder.CreateString("a")));
+  Offset<Vector<Offset<Monster> > > sorted =
+    builder.CreateVectorOfSortedTables(&monsters);
+  Offset<Vector<uint64_t> > keys = builder.CreateKeyIndex(monsters);
+  MonsterBuilder mb(builder);
+  mb.add_name(builder.CreateString("MyMonster"));
+  mb.add_testarrayoftables(sorted);
+  mb.add_testarrayoftables_keys(keys);
+  FinishMonsterBuffer(builder, mb.Finish());
+
+  const Monster *root = GetMonster(builder.GetBufferPointer());
+  TEST_EQ(root->testarrayoftables_keys()->size(), monsters.size());
+  for (int i = 0; i < 300; i++) {
+    char name[32];
+    snprintf(name, sizeof(name), "monster_%d", i);
+    const Monster *found = root->testarrayoftables_by_key(name);
+    TEST_EQ(found == root->testarrayoftables()->LookupByKey(name), true);
+    TEST_EQ(found != NULL, i % 3 == 0);
+    if (found) TEST_EQ_STR(found->name()->c_str(), name);
+  }
+  TEST_EQ_STR(root->testarrayoftables_by_key("a")->name()->c_str(), "a");
+  TEST_EQ(root->testarrayoftables_by_key("") == NULL, true);
+  TEST_EQ(root->testarrayoftables_by_key("zzz") == NULL, true);
+
+  // Keys sharing their prefix are still found in O(log n) table reads.
+  flatbuffers::FlatBufferBuilder large_builder;
+  std::vector<Offset<Monster> > many;
+  for (int i = 0; i < 1024; i++) {
+    char name[32];
+    snprintf(name, sizeof(name), "monster_%d", i);
+    many.push_back(CreateMonster(large_builder, NULL, 150, 80,
+                                 large_builder.CreateString(name)));
+  }
+  Offset<Vector<Offset<Monster> > > many_sorted =
+    large_builder.CreateVectorOfSortedTables(&many);
+  Offset<Vector<uint64_t> > many_keys = large_builder.CreateKeyIndex(many);
+  MonsterBuilder many_mb(large_builder);
+  many_mb.add_name(large_builder.CreateString("MyMonster"));
+  many_mb.add_testarrayoftables(many_sorted);
+  many_mb.add_testarrayoftables_keys(many_keys);
+  FinishMonsterBuffer(large_builder, many_mb.Finish());
+  const Monster *many_root = GetMonster(large_builder.GetBufferPointer());
+  const Vector<Offset<KeyCompareCounter> > *counted =
+    reinterpret_cast<const Vector<Offset<KeyCompareCounter> > *>(
+      many_root->testarrayoftables());
+  const char *lookups[] = { "monster_0", "monster_511", "monster_1023",
+                            "monster_5000" };
+  for (size_t i = 0; i < sizeof(lookups) / sizeof(lookups[0]); i++) {
+    KeyCompareCounter::compares = 0;
+    const KeyCompareCounter *found = flatbuffers::LookupByKeyIndex(
+      counted, many_root->testarrayoftables_keys(), lookups[i]);
+    TEST_EQ(found != NULL, i < 3);
+    TEST_EQ(KeyCompareCounter::compares <= 11, true);  // log2(1024) + 1.
+  }
+
+  // With chunked storage, the keys are read without flattening first, as
+  // long as no two keys share a prefix.
+  flatbuffers::FlatBufferBuilder chunked_builder;
+  chunked_builder.UseChunkedStorage(256);
+  std::vector<Offset<Monster> > chunked_monsters;
+  for (int i = 0; i < 100; i++) {
+    char name[32];
+    snprintf(name, sizeof(name), "%d", (i * 37) % 100);
+    chunked_monsters.push_back(
+      CreateMonster(chunked_builder, NULL, 150, 80,
+                    chunked_builder.CreateString(name)));
+  }
+  Offset<Vector<Offset<Monster> > > chunked_sorted =
+    chunked_builder.CreateVectorOfSortedTables(&chunked_monsters);
+  Offset<Vector<uint64_t> > chunked_keys =
+    chunked_builder.CreateKeyIndex(chunked_monsters);
+  std::vector<flatbuffers::BufferSegment> segments;
+  chunked_builder.GetBufferSegments(&segments);
+  TEST_EQ(segments.size() > 1, true);
+  MonsterBuilder chunked_mb(chunked_builder);
+  chunked_mb.add_name(chunked_builder.CreateString("MyMonster"));
+  chunked_mb.add_testarrayoftables(chunked_sorted);
+  chunked_mb.add_testarrayoftables_keys(chunked_keys);
+  FinishMonsterBuffer(chunked_builder, chunked_mb.Finish());
+  chunked_builder.Flatten();
+  const Monster *chunked_root =
+    GetMonster(chunked_builder.GetBufferPointer());
+  TEST_EQ_STR(chunked_root->testarrayoftables()->Get(0)->name()->c_str(), "0");
+  TEST_EQ_STR(chunked_root->testarrayoftables()->Get(99)->name()->c_str(),
+              "99");
+  TEST_EQ(chunked_root->testarrayoftables_by_key("42") != NULL, true);
+  TEST_EQ(chunked_root->testarrayoftables_by_key("420") == NULL, true);
+
+  // Tables without the generated KeyIndexValueAt() are sorted by comparing
+  // them.
+  TEST_EQ(flatbuffers::HasKeyIndexValueAt<Monster>::value, true);
+  TEST_EQ(flatbuffers::HasKeyIndexValueAt<NameOnlyMonster>::value, false);
+  flatbuffers::FlatBufferBuilder plain_builder;
+  std::vector<Offset<NameOnlyMonster> > plain_monsters;
+  for (int i = 0; i < 100; i++) {
+    char name[32];
+    snprintf(name, sizeof(name), "%d", (i * 37) % 100);
+    plain_monsters.push_back(Offset<NameOnlyMonster>(
+      CreateMonster(plain_builder, NULL, 150, 80,
+                    plain_builder.CreateString(name)).o));
+  }
+  Offset<Vector<Offset<NameOnlyMonster> > > plain_sorted =
+    plain_builder.CreateVectorOfSortedTables(&plain_monsters);
+  MonsterBuilder plain_mb(plain_builder);
+  plain_mb.add_name(plain_builder.CreateString("MyMonster"));
+  plain_mb.add_testarrayoftables(
+    Offset<Vector<Offset<Monster> > >(plain_sorted.o));
+  FinishMonsterBuffer(plain_builder, plain_mb.Finish());
+  const Vector<Offset<Monster> > *plain_tables =
+    GetMonster(plain_builder.GetBufferPointer())->testarrayoftables();
+  for (uoffset_t i = 1; i < plain_tables->size(); i++) {
+    TEST_EQ(plain_tables->Get(i - 1)->KeyCompareLessThan(plain_tables->Get(i)),
+            true);
+  }
+
+  // Without an index, lookups fall back to a binary search on the tables.
+  flatbuffers::FlatBufferBuilder builder2;
+  Offset<Monster> tables[] = {
+    CreateMonster(builder2, NULL, 150, 80, builder2.CreateString("b")),
+    CreateMonster(builder2, NULL, 150, 80, builder2.CreateString("a"))
+  };
+  Offset<Vector<Offset<Monster> > > sorted2 =
+    builder2.CreateVectorOfSortedTables(tables, 2);
+  FinishMonsterBuffer(builder2, CreateMonster(builder2, NULL, 150, 80,
+                                              builder2.CreateString("X"), 0,
+                                              Color_Blue, Any_NONE, 0, 0, 0,
+                                              sorted2));
+  const Monster *root2 = GetMonster(builder2.GetBufferPointer());
+  TEST_EQ_STR(root2->testarrayoftables_by_key("b")->name()->c_str(), "b");
+  TEST_EQ(root2->testarrayoftables_by_key("c") == NULL, true);
+
+  TEST_EQ(flatbuffers::KeyIndexValue(-1) < flatbuffers::KeyIndexValue(0),
+          true);
+  TEST_EQ(flatbuffers::KeyIndexValue(-2.5) < flatbuffers::KeyIndexValue(-1.0),
+          true);
+  TEST_EQ(flatbuffers::KeyIndexValue(-0.0) == flatbuffers::KeyIndexValue(0.0),
+          true);
+  TEST_EQ(flatbuffers::KeyIndexValue(1.0) < flatbuffers::KeyIndexValue(2.0),
+          true);
+}
+
+void StatsTest() {
+  flatbuffers::FlatBufferBuilder builder(64);
+  BuildMonsters(builder);
+  flatbuffers::BuilderStats stats = builder.GetStats();
+  Verifier verifier(builder.GetBufferPointer(), builder.GetSize());
+  TEST_EQ(VerifyMonsterBuffer(verifier), true);
+  flatbuffers::VerifierStats verifier_stats = verifier.GetStats();
+  flatbuffers::Parser parser;
+  TEST_EQ(parser.Parse("table T { a:int; b:short = 3; } root_type T;"
+                       "{ a: 1, b: 3 }"), true);
+  flatbuffers::ParserStats parser_stats = parser.GetStats();
+  #ifdef FLATBUFFERS_STATS
+    TEST_EQ(stats.reallocations > 0, true);
+    TEST_EQ(stats.chunks, 0U);
+    TEST_EQ(stats.padding_bytes > 0, true);
+    // One EndTable() per table. Most monsters share a vtable, but padding
+    // can put their fields at different offsets.
+    TEST_EQ(stats.vtables_created + stats.vtables_reused, 101U);
+    TEST_EQ(stats.vtables_reused > 90, true);
+    TEST_EQ(stats.forced_default_bytes, 0U);
+    // The monster in the union is also in the vector, and counted twice.
+    TEST_EQ(verifier_stats.tables, 102U);
+    TEST_EQ(verifier_stats.max_depth, 2U);
+    TEST_EQ(verifier_stats.vectors > 200, true);
+    TEST_EQ(verifier_stats.bytes >= builder.GetSize(), true);
+    TEST_EQ(parser_stats.json_objects, 1U);
+    TEST_EQ(parser_stats.tokens, 27U);
+    TEST_EQ(parser_stats.bytes, 58U);
+    TEST_EQ(parser_stats.schema_seconds >= 0 &&
+            parser_stats.json_seconds >= 0, true);
+
+    // Stats start over on Clear(), and count defaults written anyway.
+    builder.Clear();
+    builder.ForceDefaults(true);
+    BuildMonsters(builder);
+    stats = builder.GetStats();
+    TEST_EQ(stats.reallocations, 0U);
+    TEST_EQ(stats.vtables_created + stats.vtables_reused, 101U);
+    TEST_EQ(stats.forced_default_bytes > 0, true);
+
+    // With chunked storage, the buffer grows by chunks instead.
+    flatbuffers::FlatBufferBuilder chunked(64);
+    chunked.UseChunkedStorage(256);
+    BuildMonsters(chunked);
+    TEST_EQ(chunked.GetStats().reallocations, 0U);
+    TEST_EQ(chunked.GetStats().chunks > 10, true);
+  #else
+    TEST_EQ(stats.reallocations + stats.padding_bytes + stats.vtables_created,
+            0U);
+    TEST_EQ(verifier_stats.tables, 0U);
+    TEST_EQ(parser_stats.tokens, 0U);
+  #endif
+}
+
 int main(int /*argc*/, const char * /*argv*/[]) {
   // Run our various test suites:
 
@@ -849,16 +2407,42 @@ int main(int /*argc*/, const char * /*argv*/[]) {
   #ifndef FLATBUFFERS_NO_FILE_TESTS
   ParseAndGenerateTextTest();
   ReflectionTest(flatbuf.get(), rawbuf.length());
+  SchemaIndexTest(flatbuf.get());
+  CopyPlanTest(flatbuf.get());
+  CompactBufferTest(flatbuf.get(), rawbuf.length());
+  ResizeBatchTest(flatbuf.get(), rawbuf.length());
   ParseProtoTest();
+  SchemaVerifierTest(flatbuf.get(), rawbuf.length());
+  MappedFileTest();
   #endif
 
   FuzzTest1();
   FuzzTest2();
+  VTableSharingTest();
+  FixedCreateTest();
+  SharedStringTest();
+  AllocatorTest();
+  ChunkedBuilderTest();
+  BulkVectorTests();
+  VectorViewTest();
+  LargeBufferTest();
+  ParallelVerifierTest();
+  LazyVerifierTest();
+  SpliceTest();
+  StatsTest();
 
   ErrorTest();
   ScientificTest();
+  NumToStringTest();
   EnumStringsTest();
   UnicodeTest();
+  LongStringTest();
+  JsonConverterTest();
+  SchemaCacheTest();
+  RecordLogTest();
+  HashTest();
+  SortedTablesTest();
+  KeyIndexTest();
 
   if (!testing_fails) {
     printf("ALL TESTS PASSED\n");